@@ -22,5 +22,6 @@ struct datehelper {
   bool (*is_dst_us_eastern)(uint16_t year, uint8_t month, uint8_t day, uint8_t hour);
   void (*apply_tz_offset_eastern)(uint16_t* year, uint8_t* month, uint8_t* day, uint8_t* hour);
   uint8_t (*calc_rtc_weekday)(uint16_t year, uint8_t month, uint8_t day);
+  uint32_t (*ms_to_next_second)(const RTC_TimeTypeDef* time);
 };
 extern const struct datehelper DateHelper;
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "framebuffer.h"
+#include "gfx.h"
+#include "stm32f4xx_hal.h"
+
+// Flush counters since boot (or the last reset_stats)
+typedef struct {
+  uint32_t frames;            // gdispGFlush calls
+  uint32_t frames_skipped;    // Nothing had changed since the last flush
+  uint32_t frames_dropped;    // The previous frame was still streaming out; sent later
+  uint32_t bytes_last;        // SPI bytes (commands + pixels) of the last flush that sent anything
+  uint32_t bytes_full;        // What a whole-frame flush sends, for comparison
+  uint64_t bytes_total;
+  uint32_t flush_us_last;     // CPU time in gdispGFlush: diff and pack, the loop waits for this
+  uint32_t flush_us_max;
+  uint32_t transfer_us_last;  // Until the DMA finished, spent rendering the next frame
+  uint8_t bands_last;         // Windows sent by the last flush that sent anything
+} display_stats_t;
+
+struct display {
+  // Take over drawing and flushing from the UC1698 driver; call after gfxInit()
+  void (*init)(void);
+  // Call from the main loop: sends a frame dropped while DMA was busy
+  void (*process)(void);
+  // Forward HAL_SPI_TxCpltCallback here
+  void (*dma_complete)(SPI_HandleTypeDef* hspi);
+  // White pixels of a 1bpp sprite into the frame in one pass, instead of
+  // gdisp's pixel-at-a-time fallback
+  void (*blit)(int x, int y, const fb_sprite_t* sprite);
+  // Copy the whole frame out to a layer, or a layer over the whole frame,
+  // for views with a static background
+  void (*save_layer)(framebuffer_t* layer);
+  void (*load_layer)(const framebuffer_t* layer);
+  const display_stats_t* (*stats)(void);
+  void (*reset_stats)(void);
+};
+extern const struct display Display;
@@ -10,6 +10,7 @@ typedef struct {
   uint8_t hour;
   uint8_t minute;
   uint8_t second;
+  uint16_t millisecond;  // 0 from firmware that only sends whole seconds
   uint16_t year;
   uint8_t month;
   uint8_t day;
@@ -21,6 +22,7 @@ typedef struct {
   char condition[32];
   uint8_t humidity;
   uint8_t precip_chance;  // 0-100 percentage
+  bool stale;             // ESP8266 restored it from flash; fresh data follows
   bool valid;
 } esp_weather_t;
 
@@ -38,11 +40,14 @@ typedef struct {
   char ip_address[16];
   int8_t rssi;
   esp_gsheet_status_t gsheet_status;
+  uint32_t assoc_ms;  // Last WiFi association time, 0 if not reported
+  bool assoc_fast;    // Reconnected via cached AP/lease instead of a full scan
   bool valid;
 } esp_status_t;
 
 typedef struct {
   int32_t balance;
+  bool stale;
   bool valid;
 } esp_balance_t;
 
@@ -58,6 +63,7 @@ typedef struct {
 typedef struct {
   esp_calendar_event_t events[ESP_CALENDAR_MAX_EVENTS];
   uint8_t event_count;
+  bool stale;
   bool valid;
 } esp_calendar_t;
 
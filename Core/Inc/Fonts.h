@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include "gfx.h"
+
+// Every font the views use, opened once in init()
+typedef enum {
+  FONT_SANS10,
+  FONT_SANS12,
+  FONT_SANS16,
+  FONT_SANS24,
+  FONT_SANS32,
+  FONT_SANS_BOLD12,
+  FONT_COUNT
+} font_id_t;
+
+struct fonts {
+  // Open the fonts and measure their glyphs; call after gfxInit()
+  void (*init)(void);
+  font_t (*get)(font_id_t id);
+  // gdispGetFontMetric(font, fontHeight), from the table
+  int (*height)(font_id_t id);
+  // gdispGetStringWidth, from the glyph table and a cache of recent strings
+  int (*string_width)(font_id_t id, const char* str);
+  // Width of the first len bytes of str, uncached: for fitting text once
+  // rather than measuring it every frame
+  int (*prefix_width)(font_id_t id, const char* str, size_t len);
+};
+extern const struct fonts Fonts;
@@ -7,7 +7,16 @@
 #endif
 
 #include "gfx.h"
+#include "view_schedule.h"
 
 typedef struct {
   void (*render)(void);
+  // The loop only calls render() when this says so; views set the
+  // animation interval in init() and invalidate when their data changes
+  view_schedule_t schedule;
 } View;
+
+// Redraw on the next pass of the loop
+static inline void view_invalidate(View* view) {
+  view_schedule_invalidate(&view->schedule);
+}
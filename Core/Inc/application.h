@@ -12,7 +12,9 @@
 #include "ClockView.h"
 #include "DFPlayerMini.h"
 #include "DigitalEncoder.h"
+#include "Display.h"
 #include "FlipClockView.h"
+#include "Fonts.h"
 #include "NeoPixel.h"
 #include "StatusView.h"
 #include "gfx.h"
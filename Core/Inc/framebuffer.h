@@ -0,0 +1,68 @@
+#pragma once
+
+// 1bpp frame for the 160x160 panel and the change tracking used to flush
+// only what moved. No HAL or uGFX dependencies, so it builds on the host.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FB_WIDTH 160
+#define FB_HEIGHT 160
+#define FB_STRIDE (FB_WIDTH / 8)  // Bytes per row, MSB = leftmost pixel
+#define FB_SIZE (FB_STRIDE * FB_HEIGHT)
+
+// Changed rows closer than this are sent as one band: a window costs about
+// as much command overhead as a few rows of pixels
+#define FB_BAND_MERGE_ROWS 4
+#define FB_MAX_BANDS 8
+
+typedef struct {
+  uint8_t bits[FB_SIZE] __attribute__((aligned(4)));
+} framebuffer_t;
+
+// A packed 1bpp image: rows padded to whole bytes (padding bits clear),
+// MSB = leftmost pixel
+typedef struct {
+  uint16_t width, height;
+  uint16_t stride;  // Bytes per row
+  const uint8_t* bits;
+} fb_sprite_t;
+
+// A sprite as tools/bmp2sprite.py --rle emits it: the packed rows, PackBits
+// compressed (n < 128: n + 1 literal bytes follow; n > 128: the next byte
+// repeats 257 - n times)
+typedef struct {
+  uint16_t width, height;
+  uint16_t stride;
+  uint16_t size;  // Compressed bytes
+  const uint8_t* data;
+} fb_rle_sprite_t;
+
+// A changed region: rows y0..y1 and columns x0..x1, both exclusive at the end
+typedef struct {
+  uint16_t x0, x1;
+  uint16_t y0, y1;
+} fb_band_t;
+
+void fb_clear(framebuffer_t* fb, bool on);
+void fb_set_pixel(framebuffer_t* fb, int x, int y, bool on);
+bool fb_get_pixel(const framebuffer_t* fb, int x, int y);
+
+// Fill a rectangle already clipped to the frame
+void fb_fill_rect(framebuffer_t* fb, int x, int y, int cx, int cy, bool on);
+
+// Set the frame pixels under the sprite's set pixels, clipped to the frame;
+// clear sprite pixels leave the frame as it was
+void fb_blit(framebuffer_t* fb, int x, int y, const fb_sprite_t* sprite);
+
+// Expand an RLE sprite into bits (stride * height bytes) and describe it as
+// a plain sprite; false if the data does not decode to exactly that size
+bool fb_rle_unpack(const fb_rle_sprite_t* rle, uint8_t* bits, fb_sprite_t* sprite);
+
+// Compare frame with what was last sent and return up to max bands covering
+// every difference (the last band absorbs any overflow). Columns are widened
+// to multiples of align pixels, as the panel addresses them in groups.
+int fb_diff(const framebuffer_t* frame, const framebuffer_t* sent, int align, fb_band_t* bands, int max);
+
+// Record a band as sent
+void fb_commit(framebuffer_t* sent, const framebuffer_t* frame, const fb_band_t* band);
@@ -114,11 +114,11 @@
 //     #define GDISP_INCLUDE_FONT_DEJAVUSANSBOLD12_AA   FALSE
 //     #define GDISP_INCLUDE_USER_FONTS                 FALSE
 
-#define GDISP_NEED_IMAGE TRUE
+#define GDISP_NEED_IMAGE FALSE  // Images are 1bpp sprites from Core/Assets
 //    #define GDISP_NEED_IMAGE_NATIVE                  FALSE
 //    #define GDISP_NEED_IMAGE_GIF                     FALSE
 //        #define GDISP_IMAGE_GIF_BLIT_BUFFER_SIZE     32
-#define GDISP_NEED_IMAGE_BMP TRUE
+//    #define GDISP_NEED_IMAGE_BMP                     FALSE
 //        #define GDISP_NEED_IMAGE_BMP_1               TRUE
 //        #define GDISP_NEED_IMAGE_BMP_4               TRUE
 //        #define GDISP_NEED_IMAGE_BMP_4_RLE           TRUE
@@ -162,6 +162,9 @@
 // #define GDISP_TOTAL_DISPLAYS                         1
 
 #define GDISP_DRIVER_LIST GDISPVMT_UC1698
+// UC1698 column (of 128) where this panel's 160 visible pixels start;
+// Display.c addresses its flush windows from it
+#define UC1698_COLUMN_OFFSET 37
 //    #ifdef GDISP_DRIVER_LIST
 //        // For code and speed optimization define as TRUE or FALSE if all
 //        controllers have the same capability #define
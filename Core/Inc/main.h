@@ -59,6 +59,8 @@ void Error_Handler(void);
 /* USER CODE END EFP */
 
 /* Private defines -----------------------------------------------------------*/
+#define DISPLAY_CD_Pin GPIO_PIN_4
+#define DISPLAY_CD_GPIO_Port GPIOA
 #define SPI1_CS_Pin GPIO_PIN_6
 #define SPI1_CS_GPIO_Port GPIOA
 #define DFPLAYER_TX_Pin GPIO_PIN_9
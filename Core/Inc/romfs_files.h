@@ -1,7 +1,6 @@
 #pragma once
 
 //#include "img/drizzle_48_48.h"
-#include "img/piggy_96_96.h"
 //#include "img/clearday_48_48.h"
 //#include "img/cloudy_48_48.h"
 //#include "img/fog_48_48.h"
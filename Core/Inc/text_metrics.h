@@ -0,0 +1,42 @@
+#pragma once
+
+// Glyph width tables and a small cache of measured strings, so views can
+// centre text without asking uGFX to walk the font every frame. No uGFX
+// dependencies, so it builds on the host; Fonts fills the tables.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TEXT_FIRST_CHAR ' '
+#define TEXT_LAST_CHAR '~'
+#define TEXT_CACHE_SLOTS 16
+#define TEXT_CACHE_MAX_LEN 23  // Longer strings are measured every time
+
+// Per-font advance widths for printable ASCII
+typedef struct {
+  uint8_t widths[TEXT_LAST_CHAR - TEXT_FIRST_CHAR + 1];
+  uint8_t height;
+} text_metrics_t;
+
+typedef struct {
+  int8_t font;  // -1 = empty
+  uint16_t width;
+  char text[TEXT_CACHE_MAX_LEN + 1];
+} text_cache_entry_t;
+
+typedef struct {
+  text_cache_entry_t slots[TEXT_CACHE_SLOTS];
+  uint32_t hits;
+  uint32_t misses;
+} text_cache_t;
+
+// Sum of glyph widths, or -1 if the string has anything outside the table
+// (UTF-8 titles): the caller measures those the slow way
+int text_width(const text_metrics_t* metrics, const char* str);
+// The same for the first len bytes (or up to the terminator)
+int text_width_n(const text_metrics_t* metrics, const char* str, size_t len);
+
+void text_cache_clear(text_cache_t* cache);
+bool text_cache_lookup(text_cache_t* cache, int font, const char* str, int* width);
+void text_cache_store(text_cache_t* cache, int font, const char* str, int width);
@@ -0,0 +1,29 @@
+#pragma once
+
+// When a view needs drawing: because something it shows changed
+// (invalidated) or because its next animation frame is due. No HAL
+// dependencies, so it builds on the host; ticks are HAL_GetTick() ms.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+  uint32_t interval;   // ms between animation frames, 0 = only when invalidated
+  uint32_t next_wake;  // Tick the next frame is due at, if waking
+  bool waking;
+  volatile bool dirty;  // May be set from timer callbacks
+} view_schedule_t;
+
+// Start dirty, so the first pass draws
+void view_schedule_init(view_schedule_t* s, uint32_t interval);
+
+void view_schedule_invalidate(view_schedule_t* s);
+
+bool view_schedule_due(const view_schedule_t* s, uint32_t now);
+
+// Call right before drawing: clears dirty and books the next animation frame
+void view_schedule_begin_frame(view_schedule_t* s, uint32_t now);
+
+// Wake in ms unless a frame is already due sooner, e.g. to land on the next
+// RTC second rather than a second after the last frame
+void view_schedule_wake_in(view_schedule_t* s, uint32_t now, uint32_t ms);
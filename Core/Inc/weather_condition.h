@@ -0,0 +1,16 @@
+#pragma once
+
+// Which icon a forecast condition ("Light Rain", "Chance Snow Showers", ...)
+// gets, worked out once when the weather arrives. No HAL dependencies, so
+// it builds on the host.
+
+typedef enum {
+  PRECIP_NONE,  // Sun or moon, by the time of day
+  PRECIP_RAIN,
+  PRECIP_SNOW,
+  PRECIP_SLEET,
+} precip_type_t;
+
+// First matching keyword wins, ignoring case: sleet before snow before rain,
+// so "Rain And Snow" and "Freezing Rain" get the mixed icon
+precip_type_t weather_classify(const char* condition);
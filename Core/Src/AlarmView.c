@@ -1,4 +1,5 @@
 #include "AlarmView.h"
+#include "Fonts.h"
 #include <stdio.h>
 
 extern RTC_HandleTypeDef hrtc;
@@ -9,6 +10,8 @@ extern RTC_HandleTypeDef hrtc;
 
 static View view;
 
+#define FRAME_INTERVAL 50  // Bus and road animation
+
 // Display dimensions
 #define DISPLAY_WIDTH 160
 #define DISPLAY_HEIGHT 160
@@ -155,9 +158,8 @@ static void draw_school_bus(int frame) {
   gdispFillArea(bus_x - 5, bus_y + 9, 3, 10, Black);
 
   // "school" text on side of bus
-  font_t font = gdispOpenFont("DejaVuSans10");
+  font_t font = Fonts.get(FONT_SANS10);
   gdispDrawString(bus_x + 38, bus_y + bus_height - 22, "SCHOOL", font, Black);
-  gdispCloseFont(font);
 }
 
 // Draw on/off toggle switch (black and white)
@@ -178,7 +180,7 @@ static void draw_toggle_switch(int x, int y, bool is_on, bool is_selected) {
   gdispFillCircle(knob_x, knob_y, knob_radius, White);
 
   // Draw both labels - text under knob is black, other is white
-  font_t font = gdispOpenFont("DejaVuSans10");
+  font_t font = Fonts.get(FONT_SANS10);
   if (is_on) {
     // Knob is on right covering ON - draw ON in black, OFF in white
     gdispDrawString(x + 4, y + 7, "OFF", font, White);
@@ -188,12 +190,11 @@ static void draw_toggle_switch(int x, int y, bool is_on, bool is_selected) {
     gdispDrawString(x + 4, y + 7, "OFF", font, Black);
     gdispDrawString(x + switch_width - 18, y + 7, "ON", font, White);
   }
-  gdispCloseFont(font);
 }
 
 // Draw the time display with selection highlight
 static void draw_alarm_time(void) {
-  font_t font = gdispOpenFont("DejaVuSans24");
+  font_t font = Fonts.get(FONT_SANS24);
 
   uint8_t display_hour = alarm_hour;
   const char* ampm = "AM";
@@ -214,7 +215,7 @@ static void draw_alarm_time(void) {
   // Draw hour
   char hour_str[4];
   snprintf(hour_str, sizeof(hour_str), "%d", display_hour);
-  int hour_width = gdispGetStringWidth(hour_str, font);
+  int hour_width = Fonts.string_width(FONT_SANS24, hour_str);
 
   if (selected_field == ALARM_FIELD_HOUR) {
     // Draw underline for selected hour
@@ -226,12 +227,12 @@ static void draw_alarm_time(void) {
 
   // Draw colon
   gdispDrawString(text_x, text_y, ":", font, White);
-  text_x += gdispGetStringWidth(":", font);
+  text_x += Fonts.string_width(FONT_SANS24, ":");
 
   // Draw minute
   char min_str[4];
   snprintf(min_str, sizeof(min_str), "%02d", alarm_minute);
-  int min_width = gdispGetStringWidth(min_str, font);
+  int min_width = Fonts.string_width(FONT_SANS24, min_str);
 
   if (selected_field == ALARM_FIELD_MINUTE) {
     // Draw underline for selected minute
@@ -243,8 +244,6 @@ static void draw_alarm_time(void) {
 
   // Draw AM/PM
   gdispDrawString(text_x, text_y, ampm, font, White);
-
-  gdispCloseFont(font);
 }
 
 static void render(void) {
@@ -272,14 +271,17 @@ static void render(void) {
 
 static void set_alarm_hour(uint8_t hour) {
   alarm_hour = hour % 24;
+  view_invalidate(&view);
 }
 
 static void set_alarm_minute(uint8_t minute) {
   alarm_minute = minute % 60;
+  view_invalidate(&view);
 }
 
 static void set_enabled(bool enabled) {
   alarm_enabled = enabled;
+  view_invalidate(&view);
 }
 
 static bool is_enabled(void) {
@@ -296,6 +298,7 @@ static uint8_t get_alarm_minute(void) {
 
 static void set_selected_field(alarm_field_t field) {
   selected_field = field;
+  view_invalidate(&view);
 }
 
 static alarm_field_t get_selected_field(void) {
@@ -304,6 +307,7 @@ static alarm_field_t get_selected_field(void) {
 
 static void next_field(void) {
   selected_field = (selected_field + 1) % ALARM_FIELD_COUNT;
+  view_invalidate(&view);
 }
 
 static void adjust_selected(int8_t delta) {
@@ -323,6 +327,7 @@ static void adjust_selected(int8_t delta) {
     default:
       break;
   }
+  view_invalidate(&view);
 }
 
 static void save_to_backup(void) {
@@ -346,6 +351,7 @@ static void load_from_backup(void) {
 
 static View* init(void) {
   view.render = render;
+  view_schedule_init(&view.schedule, FRAME_INTERVAL);
   alarm_hour = 7;
   alarm_minute = 0;
   alarm_enabled = false;
@@ -1,7 +1,13 @@
 #include "BankView.h"
+#include "Fonts.h"
 #include <stdio.h>
+#include "Display.h"
+#include "piggy_96_96.h"  // Generated by the sprite_assets target
 
 static View view;
+
+#define FRAME_INTERVAL 50  // Pig walk and bob
+
 static int pig_offset = 0;
 static bool pig_count_up = true;
 static int pig_bob = 0;
@@ -38,28 +44,25 @@ static void render() {
     }
   }
   // ALEX's BANK ACCOUNT
-  font_t DejaVuSans16 = gdispOpenFont("DejaVuSans16");
+  font_t DejaVuSans16 = Fonts.get(FONT_SANS16);
   char title_string[] = "Alex's Bank Account";
-  int title_width = gdispGetStringWidth(title_string, DejaVuSans16) + 1;
-  int title_height = gdispGetFontMetric(DejaVuSans16, fontHeight) + 1;
+  int title_width = Fonts.string_width(FONT_SANS16, title_string) + 1;
+  int title_height = Fonts.height(FONT_SANS16) + 1;
   gdispDrawStringBox((swidth / 2) - (title_width / 2), 10, title_width, title_height, title_string, DejaVuSans16, White,
                      justifyCenter);
 
   // PIG
-  gdispImage piggy_img;
-  gdispImageOpenFile(&piggy_img, "piggy_96_96.bmp");
-  gdispImageDraw(&piggy_img, (((swidth / 2) - 35) - pig_offset), 30 + pig_bob, 96, 96, 0, 0);
-  gdispImageClose(&piggy_img);
+  Display.blit(((swidth / 2) - 35) - pig_offset, 30 + pig_bob, &piggy_96_96_sprite);
 
   //"ROAD"
   gdispFillArea(0, 125, swidth, 6, White);
 
   // BALANCE
-  font_t DejaVuSans32 = gdispOpenFont("DejaVuSans32");
+  font_t DejaVuSans32 = Fonts.get(FONT_SANS32);
   char money_string[16] = {'\0'};
   snprintf(money_string, sizeof(money_string), "$%ld", (long)current_balance);
-  int money_width = gdispGetStringWidth(money_string, DejaVuSans32) + 1;
-  int money_height = gdispGetFontMetric(DejaVuSans32, fontHeight) + 1;
+  int money_width = Fonts.string_width(FONT_SANS32, money_string) + 1;
+  int money_height = Fonts.height(FONT_SANS32) + 1;
   gdispDrawStringBox((swidth / 2) - (money_width / 2), 96 + 37, money_width, money_height, money_string, DejaVuSans32,
                      White, justifyCenter);
 
@@ -68,10 +71,12 @@ static void render() {
 
 static void set_balance(int32_t balance) {
   current_balance = balance;
+  view_invalidate(&view);
 }
 
 static View* init() {
   view.render = render;
+  view_schedule_init(&view.schedule, FRAME_INTERVAL);
   current_balance = 0;
   return &view;
 }
@@ -1,4 +1,5 @@
 #include "CalendarView.h"
+#include "Fonts.h"
 #include "DateHelper.h"
 #include <stdio.h>
 #include <string.h>
@@ -15,44 +16,87 @@ static View view;
 #define EVENT_MARGIN 3
 #define MAX_VISIBLE_EVENTS 4
 
-// Stored calendar data
-static calendar_event_t events[CALENDAR_MAX_EVENTS];
+// Content column of an event row, and the room its title has
+#define CONTENT_X 8
+#define TITLE_MAX_WIDTH (DISPLAY_WIDTH - CONTENT_X - 12)
+#define ELLIPSIS ".."
+
+// An event as render() draws it, built once in set_events
+typedef struct {
+  char time_range[32];                 // "Mon  10:30a - 11:00a"
+  char title[CALENDAR_MAX_TITLE_LEN];  // Cut to TITLE_MAX_WIDTH, with ELLIPSIS
+} event_row_t;
+
+// "YYYY-MM-DD HH:MM", parsed
+typedef struct {
+  int year, month, day;
+  int hour, minute;
+} event_time_t;
+
+static event_row_t rows[CALENDAR_MAX_EVENTS];
 static uint8_t event_count = 0;
+static char more_str[16];  // "+N more", when there are hidden events
 
-// Format time from "YYYY-MM-DD HH:MM" to "10:30a"
-static void format_time_only(const char* datetime, char* output, size_t output_size) {
-  int year, month, day, hour, minute;
-  if (sscanf(datetime, "%d-%d-%d %d:%d", &year, &month, &day, &hour, &minute) != 5) {
-    strncpy(output, "?", output_size - 1);
-    output[output_size - 1] = '\0';
-    return;
-  }
+static bool parse_time(const char* datetime, event_time_t* time) {
+  return sscanf(datetime, "%d-%d-%d %d:%d", &time->year, &time->month, &time->day, &time->hour, &time->minute) == 5;
+}
 
+// Format a time as "10:30a"
+static void format_time_only(const event_time_t* time, char* output, size_t output_size) {
   // Convert to 12-hour format
   const char* ampm = "a";
-  int display_hour = hour;
-  if (hour == 0) {
+  int display_hour = time->hour;
+  if (time->hour == 0) {
     display_hour = 12;
-  } else if (hour == 12) {
+  } else if (time->hour == 12) {
     ampm = "p";
-  } else if (hour > 12) {
-    display_hour = hour - 12;
+  } else if (time->hour > 12) {
+    display_hour = time->hour - 12;
     ampm = "p";
   }
 
-  snprintf(output, output_size, "%d:%02d%s", display_hour, minute, ampm);
+  snprintf(output, output_size, "%d:%02d%s", display_hour, time->minute, ampm);
 }
 
-// Get day abbreviation from datetime
-static const char* get_day_abbrev(const char* datetime) {
+static void format_time_range(const calendar_event_t* event, char* output, size_t output_size) {
   static const char* day_abbrev[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
-  int year, month, day, hour, minute;
-  if (sscanf(datetime, "%d-%d-%d %d:%d", &year, &month, &day, &hour, &minute) != 5) {
-    return "???";
+  event_time_t start, end;
+  char start_str[12] = "?", end_str[12] = "?";
+  const char* day = "???";
+
+  if (parse_time(event->start, &start)) {
+    day = day_abbrev[DateHelper.calc_day_of_week(start.year, start.month, start.day)];
+    format_time_only(&start, start_str, sizeof(start_str));
   }
+  if (parse_time(event->end, &end)) {
+    format_time_only(&end, end_str, sizeof(end_str));
+  }
+  snprintf(output, output_size, "%s  %s - %s", day, start_str, end_str);
+}
 
-  uint8_t dow = DateHelper.calc_day_of_week(year, month, day);
-  return day_abbrev[dow];
+// Copy a title, cut so it fits TITLE_MAX_WIDTH with the ellipsis after it.
+// Widths only grow with length, so the longest prefix that fits is found
+// by bisection: a handful of measurements however long the title.
+static void fit_title(const char* title, char* output, size_t output_size) {
+  size_t len = strnlen(title, output_size - 1);
+  memcpy(output, title, len);
+  output[len] = '\0';
+  if (Fonts.prefix_width(FONT_SANS12, title, len) <= TITLE_MAX_WIDTH) return;
+
+  int room = TITLE_MAX_WIDTH - Fonts.string_width(FONT_SANS12, ELLIPSIS);
+  size_t lo = 0, hi = len;  // prefix lo fits, prefix hi does not
+  while (hi - lo > 1) {
+    size_t mid = (lo + hi) / 2;
+    if (Fonts.prefix_width(FONT_SANS12, title, mid) <= room) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  // Don't split a UTF-8 sequence, or leave a space before the ellipsis
+  while (lo > 0 && ((title[lo] & 0xC0) == 0x80 || title[lo - 1] == ' ')) lo--;
+  if (lo + sizeof(ELLIPSIS) > output_size) lo = output_size - sizeof(ELLIPSIS);
+  memcpy(&output[lo], ELLIPSIS, sizeof(ELLIPSIS));
 }
 
 // Draw a bullet point
@@ -78,46 +122,13 @@ static void draw_clock_icon(int x, int y, int size) {
 }
 
 // Draw a single calendar event
-static void draw_event(int y, const calendar_event_t* event, int index) {
-  int content_x = 8;
-
+static void draw_event(int y, const event_row_t* row) {
   // Draw bullet point
-  draw_bullet(content_x, y + 8);
-
-  // Time range with clock icon
-  font_t time_font = gdispOpenFont("DejaVuSans10");
-  char start_str[12], end_str[12];
-  format_time_only(event->start, start_str, sizeof(start_str));
-  format_time_only(event->end, end_str, sizeof(end_str));
-
-  char time_range[32];
-  snprintf(time_range, sizeof(time_range), "%s  %s - %s", get_day_abbrev(event->start), start_str, end_str);
-  gdispDrawString(content_x + 8, y + 2, time_range, time_font, White);
-  gdispCloseFont(time_font);
-
-  // Title on second line (larger)
-  font_t title_font = gdispOpenFont("DejaVuSans12");
-
-  // Truncate title if needed
-  char title_display[24];
-  strncpy(title_display, event->title, sizeof(title_display) - 1);
-  title_display[sizeof(title_display) - 1] = '\0';
-
-  int max_width = DISPLAY_WIDTH - content_x - 12;
-  int title_width = gdispGetStringWidth(title_display, title_font);
-  if (title_width > max_width) {
-    size_t len = strlen(title_display);
-    while (len > 3 && gdispGetStringWidth(title_display, title_font) > max_width) {
-      len--;
-      title_display[len] = '\0';
-    }
-    if (len > 3) {
-      strcpy(&title_display[len - 2], "..");
-    }
-  }
+  draw_bullet(CONTENT_X, y + 8);
 
-  gdispDrawString(content_x + 8, y + 16, title_display, title_font, White);
-  gdispCloseFont(title_font);
+  // Time range, then the title on the second line (larger)
+  gdispDrawString(CONTENT_X + 8, y + 2, row->time_range, Fonts.get(FONT_SANS10), White);
+  gdispDrawString(CONTENT_X + 8, y + 16, row->title, Fonts.get(FONT_SANS12), White);
 
   // Dotted separator line below event (except for last visible)
   int line_y = y + EVENT_HEIGHT - 2;
@@ -152,9 +163,8 @@ static void draw_header(void) {
   }
 
   // Title
-  font_t title_font = gdispOpenFont("DejaVuSans16");
+  font_t title_font = Fonts.get(FONT_SANS16);
   gdispDrawString(26, 1, "Schedule", title_font, White);
-  gdispCloseFont(title_font);
 
   // Double line separator
   gdispDrawLine(6, HEADER_HEIGHT - 3, DISPLAY_WIDTH - 6, HEADER_HEIGHT - 3, White);
@@ -168,7 +178,7 @@ static void render(void) {
 
   if (event_count == 0) {
     // Empty state
-    font_t font = gdispOpenFont("DejaVuSans12");
+    font_t font = Fonts.get(FONT_SANS12);
 
     // Draw empty calendar icon (larger)
     int cx = DISPLAY_WIDTH / 2;
@@ -187,25 +197,22 @@ static void render(void) {
     gdispDrawLine(cx + 10, cy, cx - 10, cy + 14, White);
 
     const char* msg = "No upcoming events";
-    int msg_width = gdispGetStringWidth(msg, font);
+    int msg_width = Fonts.string_width(FONT_SANS12, msg);
     gdispDrawString((DISPLAY_WIDTH - msg_width) / 2, cy + 28, msg, font, White);
-    gdispCloseFont(font);
   } else {
     // Draw events
     int y = HEADER_HEIGHT + EVENT_MARGIN;
     int visible = (event_count < MAX_VISIBLE_EVENTS) ? event_count : MAX_VISIBLE_EVENTS;
 
     for (int i = 0; i < visible; i++) {
-      draw_event(y, &events[i], i);
+      draw_event(y, &rows[i]);
       y += EVENT_HEIGHT;
     }
 
     // More events indicator with arrow
     if (event_count > MAX_VISIBLE_EVENTS) {
-      font_t font = gdispOpenFont("DejaVuSans10");
-      char more_str[16];
-      snprintf(more_str, sizeof(more_str), "+%d more", event_count - MAX_VISIBLE_EVENTS);
-      int text_width = gdispGetStringWidth(more_str, font);
+      font_t font = Fonts.get(FONT_SANS10);
+      int text_width = Fonts.string_width(FONT_SANS10, more_str);
       int text_x = DISPLAY_WIDTH - text_width - 10;
       int text_y = DISPLAY_HEIGHT - 14;
 
@@ -216,7 +223,6 @@ static void render(void) {
       gdispDrawLine(arrow_x + 8, arrow_y, arrow_x + 4, arrow_y + 4, White);
 
       gdispDrawString(text_x, text_y, more_str, font, White);
-      gdispCloseFont(font);
     }
   }
 
@@ -226,19 +232,20 @@ static void render(void) {
 static void set_events(calendar_event_t* new_events, uint8_t count) {
   event_count = (count > CALENDAR_MAX_EVENTS) ? CALENDAR_MAX_EVENTS : count;
   for (int i = 0; i < event_count; i++) {
-    strncpy(events[i].start, new_events[i].start, sizeof(events[i].start) - 1);
-    events[i].start[sizeof(events[i].start) - 1] = '\0';
-    strncpy(events[i].end, new_events[i].end, sizeof(events[i].end) - 1);
-    events[i].end[sizeof(events[i].end) - 1] = '\0';
-    strncpy(events[i].title, new_events[i].title, sizeof(events[i].title) - 1);
-    events[i].title[sizeof(events[i].title) - 1] = '\0';
+    format_time_range(&new_events[i], rows[i].time_range, sizeof(rows[i].time_range));
+    fit_title(new_events[i].title, rows[i].title, sizeof(rows[i].title));
+  }
+  if (event_count > MAX_VISIBLE_EVENTS) {
+    snprintf(more_str, sizeof(more_str), "+%d more", event_count - MAX_VISIBLE_EVENTS);
   }
+  view_invalidate(&view);
 }
 
 static View* init(void) {
   view.render = render;
+  view_schedule_init(&view.schedule, 0);  // Static until set_events
   event_count = 0;
-  memset(events, 0, sizeof(events));
+  memset(rows, 0, sizeof(rows));
   return &view;
 }
 
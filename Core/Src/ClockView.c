@@ -1,17 +1,34 @@
 #include "ClockView.h"
-#include <math.h>   // for cos, sin
+#include "Display.h"
+#include "Fonts.h"
 #include <stdio.h>  // for snprintf
 
 static View view;
 
+#define FRAME_INTERVAL 1000  // Second hand
+
 // Clock configuration constants
 #define CLOCK_RADIUS 47
 #define CLOCK_XOFFSET 83
 #define CLOCK_YOFFSET 68
-#define DEG_TO_RAD 0.017453293f  // pi/180
-#define HOUR_HAND_LENGTH 0.7f
-#define MIN_HAND_LENGTH 0.9f
-#define SEC_HAND_LENGTH 0.9f
+// Hand lengths in 1/16 pixel: 0.7 and 0.9 of the radius
+#define HOUR_HAND_LENGTH (CLOCK_RADIUS * 16 * 7 / 10)
+#define MIN_HAND_LENGTH (CLOCK_RADIUS * 16 * 9 / 10)
+#define SEC_HAND_LENGTH (CLOCK_RADIUS * 16 * 9 / 10)
+
+// sin(i * 6 degrees) in Q14, one entry per minute mark; cos(i) = sin(i + 15)
+static const int16_t sin_q14[60] = {
+    0, 1713, 3406, 5063, 6664, 8192, 9630, 10963, 12176, 13255,
+    14189, 14968, 15582, 16026, 16294, 16384, 16294, 16026, 15582, 14968,
+    14189, 13255, 12176, 10963, 9630, 8192, 6664, 5063, 3406, 1713,
+    0, -1713, -3406, -5063, -6664, -8192, -9630, -10963, -12176, -13255,
+    -14189, -14968, -15582, -16026, -16294, -16384, -16294, -16026, -15582, -14968,
+    -14189, -13255, -12176, -10963, -9630, -8192, -6664, -5063, -3406, -1713,
+};
+
+// Face and labels without hands, drawn on the first render
+static framebuffer_t face_layer;
+static bool face_cached = false;
 
 // Clock state
 static struct {
@@ -19,17 +36,31 @@ static struct {
   int sec_arrow_x, sec_arrow_y;
   int min_arrow_x, min_arrow_y;
   int hour_arrow_x, hour_arrow_y;
-  int prev_sec_x, prev_sec_y;
-  int prev_min_x, prev_min_y;
-  int prev_hour_x, prev_hour_y;
 } clock_state = {0};
 
-static float alfa;
+// Point at minute mark i (0 = 3 o'clock, clockwise) and length in 1/16
+// pixel from the centre, rounded down like the float version was
+static void mark_point(int i, int length_q4, int* x, int* y) {
+  *x = CLOCK_XOFFSET + ((sin_q14[(i + 15) % 60] * length_q4) >> 18);
+  *y = CLOCK_YOFFSET + ((sin_q14[i % 60] * length_q4) >> 18);
+}
+
+// sin((i + twelfths / 12) * 6 degrees) in Q14, linear between the marks
+static int sin_between(int i, int twelfths) {
+  int from = sin_q14[i % 60];
+  return from + (sin_q14[(i + 1) % 60] - from) * twelfths / 12;
+}
+
+// Like mark_point, but twelfths (0..11) of the way on to mark i + 1
+static void between_points(int i, int twelfths, int length_q4, int* x, int* y) {
+  *x = CLOCK_XOFFSET + ((sin_between(i + 15, twelfths) * length_q4) >> 18);
+  *y = CLOCK_YOFFSET + ((sin_between(i, twelfths) * length_q4) >> 18);
+}
 
 static void draw_hour(char* hour_string, int x, int y) {
-  font_t font = gdispOpenFont("DejaVuSansBold12");
-  int hour_width = gdispGetStringWidth(hour_string, font) + 2;
-  int hour_height = gdispGetFontMetric(font, fontHeight) + 1;
+  font_t font = Fonts.get(FONT_SANS_BOLD12);
+  int hour_width = Fonts.string_width(FONT_SANS_BOLD12, hour_string) + 2;
+  int hour_height = Fonts.height(FONT_SANS_BOLD12) + 1;
   int hour_x = x - (hour_width / 8) + 1;
   int hour_y = y - 1;
 
@@ -38,7 +69,6 @@ static void draw_hour(char* hour_string, int x, int y) {
   }
 
   gdispDrawStringBox(hour_x, hour_y, hour_width, hour_height, hour_string, font, White, justifyCenter);
-  gdispCloseFont(font);
 }
 static void SetLines(int xl1pos, int yl1pos, int xl2pos, int yl2pos) {
   gdispDrawLine(xl1pos, yl1pos, xl2pos, yl2pos, White);
@@ -48,33 +78,17 @@ static void SetThickLines(int xl1pos, int yl1pos, int xl2pos, int yl2pos) {
   gdispDrawThickLine(xl1pos, yl1pos, xl2pos, yl2pos, White, 3, TRUE);
 }
 static void draw_clock(int hour, int minute, int second) {
-  // Calculate hour hand position
-  alfa = (270 + (30 * hour + (0.5 * minute))) * DEG_TO_RAD;
-  clock_state.hour_arrow_x = (cos(alfa) * CLOCK_RADIUS * HOUR_HAND_LENGTH) + CLOCK_XOFFSET;
-  clock_state.hour_arrow_y = (sin(alfa) * CLOCK_RADIUS * HOUR_HAND_LENGTH) + CLOCK_YOFFSET;
-
-  // Calculate minute hand position
-  alfa = (270 + (6 * minute)) * DEG_TO_RAD;
-  clock_state.min_arrow_x = (cos(alfa) * CLOCK_RADIUS * MIN_HAND_LENGTH) + CLOCK_XOFFSET;
-  clock_state.min_arrow_y = (sin(alfa) * CLOCK_RADIUS * MIN_HAND_LENGTH) + CLOCK_YOFFSET;
-
-  // Calculate second hand position
-  alfa = (270 + (6 * second)) * DEG_TO_RAD;
-  clock_state.sec_arrow_x = (cos(alfa) * CLOCK_RADIUS * SEC_HAND_LENGTH) + CLOCK_XOFFSET;
-  clock_state.sec_arrow_y = (sin(alfa) * CLOCK_RADIUS * SEC_HAND_LENGTH) + CLOCK_YOFFSET;
+  // Mark 45 is 12 o'clock. The hour hand is a mark further every 12
+  // minutes and glides between marks in the minutes in between.
+  between_points(45 + (hour % 12) * 5 + minute / 12, minute % 12, HOUR_HAND_LENGTH, &clock_state.hour_arrow_x,
+                 &clock_state.hour_arrow_y);
+  mark_point(45 + minute, MIN_HAND_LENGTH, &clock_state.min_arrow_x, &clock_state.min_arrow_y);
+  mark_point(45 + second, SEC_HAND_LENGTH, &clock_state.sec_arrow_x, &clock_state.sec_arrow_y);
 
   // Draw hands
   SetThickLines(CLOCK_XOFFSET, CLOCK_YOFFSET, clock_state.hour_arrow_x, clock_state.hour_arrow_y);
-  clock_state.prev_hour_x = clock_state.hour_arrow_x;
-  clock_state.prev_hour_y = clock_state.hour_arrow_y;
-
   SetThickLines(CLOCK_XOFFSET, CLOCK_YOFFSET, clock_state.min_arrow_x, clock_state.min_arrow_y);
-  clock_state.prev_min_x = clock_state.min_arrow_x;
-  clock_state.prev_min_y = clock_state.min_arrow_y;
-
   SetLines(CLOCK_XOFFSET, CLOCK_YOFFSET, clock_state.sec_arrow_x, clock_state.sec_arrow_y);
-  clock_state.prev_sec_x = clock_state.sec_arrow_x;
-  clock_state.prev_sec_y = clock_state.sec_arrow_y;
 }
 static void SetPoint(int xppos, int yppos) {
   gdispDrawPixel(xppos, yppos, White);
@@ -86,16 +100,14 @@ static void SetFilledCircle(int xcpos, int ycpos, int radius) {
 
 static void face() {
   for (int i = 0; i <= 59; i++) {
-    alfa = 6 * i * DEG_TO_RAD;
-    clock_state.point_x = (cos(alfa) * CLOCK_RADIUS) + CLOCK_XOFFSET;
-    clock_state.point_y = (sin(alfa) * CLOCK_RADIUS) + CLOCK_YOFFSET;
+    mark_point(i, CLOCK_RADIUS * 16, &clock_state.point_x, &clock_state.point_y);
     SetPoint(clock_state.point_x, clock_state.point_y);
 
     if ((i % 5) == 0) {
       SetFilledCircle(clock_state.point_x, clock_state.point_y, 2);
-      alfa = 6 * (i + 45) * DEG_TO_RAD;
-      clock_state.point_x = (cos(alfa) * (CLOCK_RADIUS + 12)) + CLOCK_XOFFSET - 5;
-      clock_state.point_y = (sin(alfa) * (CLOCK_RADIUS + 12)) + CLOCK_YOFFSET - 5;
+      mark_point(i + 45, (CLOCK_RADIUS + 12) * 16, &clock_state.point_x, &clock_state.point_y);
+      clock_state.point_x -= 5;
+      clock_state.point_y -= 5;
 
       char buffer[3] = {'\0'};
       int hour = (i / 5);
@@ -116,29 +128,37 @@ static void render() {
   RTC_DateTypeDef currentDate;
   HAL_RTC_GetTime(&hrtc, &currentTime, RTC_FORMAT_BIN);
   HAL_RTC_GetDate(&hrtc, &currentDate, RTC_FORMAT_BIN);
-  gdispClear(Black);
-
-  // Draw clock face (static) and hands (dynamic)
-  face();
+  // Clock face (static, drawn once and copied in) and hands (dynamic)
+  if (!face_cached) {
+    gdispClear(Black);
+    face();
+    Display.save_layer(&face_layer);
+    face_cached = true;
+  } else {
+    Display.load_layer(&face_layer);
+  }
   draw_clock(currentTime.Hours, currentTime.Minutes, currentTime.Seconds);
 
   // Draw time string at bottom
-  font_t DejaVuSans24 = gdispOpenFont("DejaVuSans24");
+  font_t DejaVuSans24 = Fonts.get(FONT_SANS24);
   char time_string[10] = {'\0'};
   DateHelper.to_string(time_string);
 
-  int time_width = gdispGetStringWidth(time_string, DejaVuSans24) + 1;
-  int time_height = gdispGetFontMetric(DejaVuSans24, fontHeight) + 1;
+  int time_width = Fonts.string_width(FONT_SANS24, time_string) + 1;
+  int time_height = Fonts.height(FONT_SANS24) + 1;
 
   gdispDrawStringBox((width / 2) - (time_width / 2), height - time_height + 5, time_width, time_height, time_string,
                      DejaVuSans24, White, justifyCenter);
-  gdispCloseFont(DejaVuSans24);
 
   gdispGFlush(gdispGetDisplay(0));
+
+  // Next frame as the RTC second turns over, not a second after this one
+  view_schedule_wake_in(&view.schedule, HAL_GetTick(), DateHelper.ms_to_next_second(&currentTime));
 }
 
 static View* init() {
   view.render = render;
+  view_schedule_init(&view.schedule, FRAME_INTERVAL);
 
   // Initialize hand positions
   clock_state.sec_arrow_x = CLOCK_XOFFSET;
@@ -184,6 +184,12 @@ static uint8_t calc_rtc_weekday(uint16_t year, uint8_t month, uint8_t day) {
   return (dow == 0) ? 7 : dow;
 }
 
+// Time left in the current RTC second, from the sub-second down-counter
+// HAL_RTC_GetTime filled in (it runs from SecondFraction to 0)
+static uint32_t ms_to_next_second(const RTC_TimeTypeDef* time) {
+  return ((time->SubSeconds + 1) * 1000) / (time->SecondFraction + 1);
+}
+
 const struct datehelper DateHelper = {.get_epoch = get_epoch,
                                       .get_day_of_week = get_day_of_week,
                                       .get_month = get_month,
@@ -194,4 +200,5 @@ const struct datehelper DateHelper = {.get_epoch = get_epoch,
                                       .nth_weekday_of_month = nth_weekday_of_month,
                                       .is_dst_us_eastern = is_dst_us_eastern,
                                       .apply_tz_offset_eastern = apply_tz_offset_eastern,
-                                      .calc_rtc_weekday = calc_rtc_weekday};
+                                      .calc_rtc_weekday = calc_rtc_weekday,
+                                      .ms_to_next_second = ms_to_next_second};
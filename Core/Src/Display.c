@@ -0,0 +1,287 @@
+// Frame ownership and partial flushing for the UC1698 panel.
+//
+// The uc1698 uGFX driver still brings the panel up in gfxInit(). After that
+// its drawing and flush entries are swapped for ones that draw into an
+// in-RAM 1bpp frame; a flush compares it with a copy of what the panel
+// already shows and sends only the changed bands, each through a UC1698
+// window so the controller wraps rows by itself.
+//
+// The frame views draw into is the back buffer. A flush packs the changed
+// bands into the front buffer (panel format, commands included) and hands
+// it to SPI DMA, so rendering carries on while it streams out. A flush
+// that comes while the front buffer is still in flight is dropped rather
+// than waiting or tearing it; process() sends it once the DMA completes.
+
+#include "Display.h"
+#include <string.h>
+#include "main.h"
+#include "src/gdisp/gdisp_driver.h"
+
+extern SPI_HandleTypeDef hspi1;
+
+// Panel wiring and addressing, as set up by the uc1698 driver: 4-wire SPI
+// with a command/data line, 4K-colour mode (RGB 4:4:4, one pixel per
+// sub-pixel, so a column address covers 3 pixels and two columns pack into
+// 3 bytes). The C/D line is DISPLAY_CD in the .ioc (main.h), and the
+// column the 160 visible pixels start at is the panel's, so it lives with
+// the driver selection in gfxconf.h.
+#ifndef UC1698_COLUMN_OFFSET
+#error "gfxconf.h must define UC1698_COLUMN_OFFSET for this panel"
+#endif
+#define DISPLAY_SPI hspi1
+#define DISPLAY_PIXELS_PER_COLUMN 3
+#define DISPLAY_ALIGN (2 * DISPLAY_PIXELS_PER_COLUMN)  // Whole 3-byte column pairs
+#define DISPLAY_ROW_BYTES ((FB_WIDTH + DISPLAY_ALIGN - 1) / DISPLAY_ALIGN * 3)
+
+// UC1698 commands
+#define UC1698_SET_COLUMN_LSB 0x00
+#define UC1698_SET_COLUMN_MSB 0x10
+#define UC1698_SET_ROW_LSB 0x60
+#define UC1698_SET_ROW_MSB 0x70
+#define UC1698_WINDOW_START_COLUMN 0xF4
+#define UC1698_WINDOW_START_ROW 0xF5
+#define UC1698_WINDOW_END_COLUMN 0xF6
+#define UC1698_WINDOW_END_ROW 0xF7
+#define UC1698_WINDOW_MODE_INSIDE 0xF8
+#define UC1698_WINDOW_COMMAND_BYTES 13
+
+// Front buffer: every band's window commands and pixels, in send order
+#define DISPLAY_TX_SIZE (FB_MAX_BANDS * UC1698_WINDOW_COMMAND_BYTES + FB_HEIGHT * DISPLAY_ROW_BYTES)
+#define DISPLAY_MAX_SEGMENTS (2 * FB_MAX_BANDS)
+
+// One DMA transfer: a run of command or data bytes in the front buffer
+typedef struct {
+  uint16_t offset;
+  uint16_t len;
+  bool data;
+} tx_segment_t;
+
+static framebuffer_t frame;
+static framebuffer_t sent;
+static bool sent_valid = false;  // Panel content unknown until the first full flush
+static display_stats_t stats;
+
+static GDISPVMT vmt;
+
+static uint8_t tx_buffer[DISPLAY_TX_SIZE] __attribute__((aligned(4)));
+static tx_segment_t tx_segments[DISPLAY_MAX_SEGMENTS];
+static uint8_t tx_segment_count;
+static volatile uint8_t tx_segment_next;
+static volatile bool tx_busy = false;
+static bool flush_pending = false;  // A flush was dropped while tx_busy
+static uint32_t tx_started;         // DWT cycles when the first segment went out
+
+// Timing
+
+static void cycle_counter_init(void) {
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+static uint32_t cycles_to_us(uint32_t cycles) {
+  return cycles / (SystemCoreClock / 1000000);
+}
+
+// SPI transport
+
+static void start_segment(const tx_segment_t* segment) {
+  HAL_GPIO_WritePin(DISPLAY_CD_GPIO_Port, DISPLAY_CD_Pin, segment->data ? GPIO_PIN_SET : GPIO_PIN_RESET);
+  HAL_SPI_Transmit_DMA(&DISPLAY_SPI, &tx_buffer[segment->offset], segment->len);
+}
+
+// Called from the SPI1 TX DMA interrupt
+static void dma_complete(SPI_HandleTypeDef* hspi) {
+  if (hspi != &DISPLAY_SPI || !tx_busy) return;
+
+  if (tx_segment_next < tx_segment_count) {
+    start_segment(&tx_segments[tx_segment_next++]);
+    return;
+  }
+  HAL_GPIO_WritePin(SPI1_CS_GPIO_Port, SPI1_CS_Pin, GPIO_PIN_SET);
+  stats.transfer_us_last = cycles_to_us(DWT->CYCCNT - tx_started);
+  tx_busy = false;
+}
+
+// Convert pixels x0..x1 (multiples of DISPLAY_ALIGN) of a row to 4K-colour
+// nibbles: each 1bpp pixel becomes 0x0 or 0xF
+static uint16_t pack_row(uint8_t* out, const uint8_t* row, int x0, int x1) {
+  static const uint8_t pair[4] = {0x00, 0x0F, 0xF0, 0xFF};
+  uint16_t len = 0;
+  for (int x = x0; x < x1; x += 2) {
+    uint8_t bits = 0;
+    if (x < FB_WIDTH) {
+      // x is even, so both pixels sit in the same source byte
+      bits = (row[x >> 3] >> (6 - (x & 7))) & 0x03;
+    }
+    out[len++] = pair[bits];
+  }
+  return len;
+}
+
+// Append a band's window commands and pixels to the front buffer
+static uint16_t pack_band(const fb_band_t* band, uint16_t offset) {
+  uint8_t col0 = UC1698_COLUMN_OFFSET + band->x0 / DISPLAY_PIXELS_PER_COLUMN;
+  uint8_t col1 = UC1698_COLUMN_OFFSET + band->x1 / DISPLAY_PIXELS_PER_COLUMN - 1;
+  uint8_t row0 = band->y0;
+  uint8_t row1 = band->y1 - 1;
+  const uint8_t cmd[UC1698_WINDOW_COMMAND_BYTES] = {
+      UC1698_WINDOW_START_COLUMN, col0,
+      UC1698_WINDOW_START_ROW,    row0,
+      UC1698_WINDOW_END_COLUMN,   col1,
+      UC1698_WINDOW_END_ROW,      row1,
+      UC1698_WINDOW_MODE_INSIDE,
+      UC1698_SET_COLUMN_LSB | (col0 & 0x0F),
+      UC1698_SET_COLUMN_MSB | (col0 >> 4),
+      UC1698_SET_ROW_LSB | (row0 & 0x0F),
+      UC1698_SET_ROW_MSB | (row0 >> 4),
+  };
+  memcpy(&tx_buffer[offset], cmd, sizeof(cmd));
+  tx_segments[tx_segment_count++] = (tx_segment_t){offset, sizeof(cmd), false};
+  offset += sizeof(cmd);
+
+  uint16_t data = offset;
+  for (int y = band->y0; y < band->y1; y++) {
+    offset += pack_row(&tx_buffer[offset], &frame.bits[y * FB_STRIDE], band->x0, band->x1);
+  }
+  tx_segments[tx_segment_count++] = (tx_segment_t){data, offset - data, true};
+  return offset;
+}
+
+// uGFX driver entries (g->p is already clipped by gdisp)
+
+static void lld_pixel(GDisplay* g) {
+  fb_set_pixel(&frame, g->p.x, g->p.y, g->p.color != Black);
+}
+
+static void lld_fill(GDisplay* g) {
+  fb_fill_rect(&frame, g->p.x, g->p.y, g->p.cx, g->p.cy, g->p.color != Black);
+}
+
+static void lld_clear(GDisplay* g) {
+  fb_clear(&frame, g->p.color != Black);
+}
+
+static gColor lld_get(GDisplay* g) {
+  return fb_get_pixel(&frame, g->p.x, g->p.y) ? White : Black;
+}
+
+static void lld_flush(GDisplay* g) {
+  (void)g;
+  uint32_t start = DWT->CYCCNT;
+  stats.frames++;
+
+  if (tx_busy) {
+    stats.frames_dropped++;
+    flush_pending = true;
+    return;
+  }
+  flush_pending = false;
+
+  fb_band_t bands[FB_MAX_BANDS];
+  int count;
+  if (sent_valid) {
+    count = fb_diff(&frame, &sent, DISPLAY_ALIGN, bands, FB_MAX_BANDS);
+  } else {
+    bands[0] = (fb_band_t){0, DISPLAY_ROW_BYTES / 3 * DISPLAY_ALIGN, 0, FB_HEIGHT};
+    count = 1;
+  }
+  if (count == 0) {
+    stats.frames_skipped++;
+    return;
+  }
+
+  // Snapshot the changed bands into the front buffer; the back buffer is
+  // free to draw into again as soon as this returns
+  tx_segment_count = 0;
+  uint16_t bytes = 0;
+  for (int i = 0; i < count; i++) {
+    bytes = pack_band(&bands[i], bytes);
+    fb_commit(&sent, &frame, &bands[i]);
+  }
+  sent_valid = true;
+
+  tx_busy = true;
+  tx_segment_next = 1;
+  tx_started = DWT->CYCCNT;
+  HAL_GPIO_WritePin(SPI1_CS_GPIO_Port, SPI1_CS_Pin, GPIO_PIN_RESET);
+  start_segment(&tx_segments[0]);
+
+  uint32_t us = cycles_to_us(DWT->CYCCNT - start);
+  stats.bytes_last = bytes;
+  stats.bytes_total += bytes;
+  stats.bands_last = count;
+  stats.flush_us_last = us;
+  if (us > stats.flush_us_max) stats.flush_us_max = us;
+}
+
+static void init(void) {
+  cycle_counter_init();
+
+  GDisplay* g = gdispGetDisplay(0);
+
+  // Keep the driver's init/control/query; everything that touches pixels
+  // comes here. Streaming, blit and scroll are left out so gdisp falls back
+  // to pixel/fill for them.
+  vmt = *gvmt(g);
+  vmt.writestart = NULL;
+  vmt.writepos = NULL;
+  vmt.writecolor = NULL;
+  vmt.writestop = NULL;
+  vmt.readstart = NULL;
+  vmt.readcolor = NULL;
+  vmt.readstop = NULL;
+  vmt.blit = NULL;
+  vmt.vscroll = NULL;
+  vmt.pixel = lld_pixel;
+  vmt.fill = lld_fill;
+  vmt.clear = lld_clear;
+  vmt.get = lld_get;
+  vmt.flush = lld_flush;
+  g->d.vmt = &vmt.d;
+
+  fb_clear(&frame, false);
+  sent_valid = false;
+  memset(&stats, 0, sizeof(stats));
+  stats.bytes_full = UC1698_WINDOW_COMMAND_BYTES + FB_HEIGHT * DISPLAY_ROW_BYTES;
+}
+
+static void blit(int x, int y, const fb_sprite_t* sprite) {
+  fb_blit(&frame, x, y, sprite);
+}
+
+static void save_layer(framebuffer_t* layer) {
+  *layer = frame;
+}
+
+static void load_layer(const framebuffer_t* layer) {
+  frame = *layer;
+}
+
+// Send a flush that was dropped while the last one was still in flight
+static void process(void) {
+  if (flush_pending && !tx_busy) {
+    gdispGFlush(gdispGetDisplay(0));
+  }
+}
+
+static const display_stats_t* get_stats(void) {
+  return &stats;
+}
+
+static void reset_stats(void) {
+  uint32_t full = stats.bytes_full;
+  memset(&stats, 0, sizeof(stats));
+  stats.bytes_full = full;
+}
+
+const struct display Display = {
+    .init = init,
+    .process = process,
+    .dma_complete = dma_complete,
+    .blit = blit,
+    .save_layer = save_layer,
+    .load_layer = load_layer,
+    .stats = get_stats,
+    .reset_stats = reset_stats,
+};
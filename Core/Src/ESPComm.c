@@ -183,6 +183,12 @@ static void esp_process_dma_buffer(void) {
   esp_rx_old_pos = pos;
 }
 
+// Replies served from the ESP8266's flash cache end in ",STALE" or ";STALE"
+static bool esp_is_stale(const char* data) {
+  size_t len = strlen(data);
+  return len >= 6 && strcmp(data + len - 5, "STALE") == 0 && (data[len - 6] == ',' || data[len - 6] == ';');
+}
+
 static void esp_parse_response(const char* response) {
   if (strncmp(response, "TIME:", 5) == 0) {
     esp_parse_time(response + 5);
@@ -207,14 +213,16 @@ static void esp_parse_response(const char* response) {
 static void esp_parse_time(const char* data) {
   esp_time_t time = {0};
 
-  int year, month, day, hour, minute, second;
-  if (sscanf(data, "%d-%d-%dT%d:%d:%dZ", &year, &month, &day, &hour, &minute, &second) == 6) {
+  // "2026-01-08T12:34:56.789Z"; the milliseconds are optional
+  int year, month, day, hour, minute, second, millisecond = 0;
+  if (sscanf(data, "%d-%d-%dT%d:%d:%d.%dZ", &year, &month, &day, &hour, &minute, &second, &millisecond) >= 6) {
     time.year = year;
     time.month = month;
     time.day = day;
     time.hour = hour;
     time.minute = minute;
     time.second = second;
+    time.millisecond = millisecond;
     time.valid = true;
 
     last_time = time;
@@ -240,6 +248,7 @@ static void esp_parse_weather(const char* data) {
     weather.condition[sizeof(weather.condition) - 1] = '\0';
     weather.humidity = humidity;
     weather.precip_chance = (uint8_t)precip_chance;
+    weather.stale = esp_is_stale(data);
     weather.valid = true;
 
     last_weather = weather;
@@ -254,6 +263,7 @@ static void esp_parse_weather(const char* data) {
     weather.condition[sizeof(weather.condition) - 1] = '\0';
     weather.humidity = humidity;
     weather.precip_chance = 0;
+    weather.stale = esp_is_stale(data);
     weather.valid = true;
 
     last_weather = weather;
@@ -304,11 +314,14 @@ static void esp_parse_status(const char* data) {
     status.connected = true;
     status.connecting = false;
 
-    // Parse IP, RSSI, and GSheet status: "192.168.1.100,-50,GSHEET_READY"
+    // Parse IP, RSSI, GSheet status and association time/kind:
+    // "192.168.1.100,-50,GSHEET_READY,412,FAST" (older firmware stops after GSheet)
     char ip[16];
     int rssi;
     char gsheet_str[24];
-    int parsed = sscanf(data + 10, "%15[^,],%d,%23s", ip, &rssi, gsheet_str);
+    unsigned long assoc_ms;
+    char assoc_kind[8];
+    int parsed = sscanf(data + 10, "%15[^,],%d,%23[^,],%lu,%7s", ip, &rssi, gsheet_str, &assoc_ms, assoc_kind);
     if (parsed >= 1) {
       strncpy(status.ip_address, ip, sizeof(status.ip_address) - 1);
       status.ip_address[sizeof(status.ip_address) - 1] = '\0';
@@ -319,6 +332,10 @@ static void esp_parse_status(const char* data) {
     if (parsed >= 3) {
       status.gsheet_status = esp_parse_gsheet_status(gsheet_str);
     }
+    if (parsed >= 5) {
+      status.assoc_ms = assoc_ms;
+      status.assoc_fast = strcmp(assoc_kind, "FAST") == 0;
+    }
     status.valid = true;
   } else if (strncmp(data, "CONNECTING,", 11) == 0) {
     status.connected = false;
@@ -365,6 +382,7 @@ static void esp_parse_balance(const char* data) {
   int value;
   if (sscanf(data, "%d", &value) == 1) {
     balance.balance = value;
+    balance.stale = esp_is_stale(data);
     balance.valid = true;
 
     last_balance = balance;
@@ -384,6 +402,7 @@ static void esp_parse_calendar(const char* data) {
   // New: "count,start|end|title;start|end|title;..." (two pipes per event)
   // Old: "count,datetime|title;datetime|title;..." (one pipe per event)
   // Also handles "0" or "NO_EVENTS" for empty calendar
+  // A trailing ";STALE" / ",STALE" (no pipes) marks a cached reply and ends the list
 
   const char* comma = strchr(data, ',');
   if (!comma) {
@@ -472,6 +491,7 @@ static void esp_parse_calendar(const char* data) {
     }
   }
 
+  calendar.stale = esp_is_stale(data);
   calendar.valid = true;
   last_calendar = calendar;
 
@@ -1,11 +1,16 @@
 #include "FlipClockView.h"
+#include "Fonts.h"
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include "DateHelper.h"
+#include "Display.h"
+#include "weather_condition.h"
 
 static View view;
 
+#define FRAME_INTERVAL 1000  // Colon blinks with the seconds
+
 // Display dimensions
 #define DISPLAY_WIDTH 160
 #define DISPLAY_HEIGHT 160
@@ -35,6 +40,22 @@ static View view;
 // Weather state
 static flipclock_weather_t weather_data = {0};
 
+// The weather strip as draw_temp() draws it, built in set_weather
+static struct {
+  char temp_val[8];
+  int temp_width;
+  char condition_short[10];  // Cut to fit before the icon
+  char precip_str[8];
+  int precip_width;
+  precip_type_t precip;
+} strip;
+
+// Sun or moon, worked out again only when the RTC hour changes
+static struct {
+  uint8_t hour;  // RTC Hours with the PM flag in the top bit, 0xFF = not yet
+  bool is_day;
+} day_night = {0xFF, true};
+
 // Animation state
 static struct {
   int frame;
@@ -55,62 +76,121 @@ static const unsigned char digit_segments[10] = {
     0x7B   // 9: a,b,c,d,f,g
 };
 
+// Digit sprites, rasterized once in init(): the tapered segments take ~10
+// lines each, far too many to redraw every second
+#define SPRITE_STRIDE(w) (((w) + 7) / 8)
+#define LARGE_ONE_CENTERED 10  // Extra large glyph: "1" centered in DIGIT_WIDTH
+
+static uint8_t large_bits[11][SPRITE_STRIDE(DIGIT_WIDTH) * DIGIT_HEIGHT];
+static uint8_t med_bits[10][SPRITE_STRIDE(MED_DIGIT_WIDTH) * MED_DIGIT_HEIGHT];
+static fb_sprite_t large_digits[11];
+static fb_sprite_t med_digits[10];
+
+// A glyph being rasterized
+typedef struct {
+  uint8_t* bits;
+  int stride;
+} glyph_t;
+
+static void glyph_hline(glyph_t* g, int x0, int x1, int y) {
+  for (int x = x0; x <= x1; x++) {
+    g->bits[y * g->stride + (x >> 3)] |= 0x80 >> (x & 7);
+  }
+}
+
+static void glyph_vline(glyph_t* g, int x, int y0, int y1) {
+  for (int y = y0; y <= y1; y++) {
+    g->bits[y * g->stride + (x >> 3)] |= 0x80 >> (x & 7);
+  }
+}
+
 // Draw a horizontal segment
-static void draw_h_segment(int x, int y, int width, int thick) {
+static void draw_h_segment(glyph_t* g, int x, int y, int width, int thick) {
   for (int i = 0; i < thick; i++) {
     int inset = (i < thick / 2) ? (thick / 2 - i) : (i - thick / 2);
-    gdispDrawLine(x + inset + 1, y + i, x + width - inset - 2, y + i, White);
+    glyph_hline(g, x + inset + 1, x + width - inset - 2, y + i);
   }
 }
 
 // Draw a vertical segment
-static void draw_v_segment(int x, int y, int height, int thick) {
+static void draw_v_segment(glyph_t* g, int x, int y, int height, int thick) {
   for (int i = 0; i < thick; i++) {
     int x_off = x + i;
     int taper = (i < thick / 2) ? (thick / 2 - i) : (i - thick / 2);
-    gdispDrawLine(x_off, y + taper + 1, x_off, y + height - taper - 2, White);
+    glyph_vline(g, x_off, y + taper + 1, y + height - taper - 2);
   }
 }
 
 // Draw a digit with configurable size
-static void draw_digit_sized(int x, int y, int digit, int w, int h, int t) {
-  if (digit < 0 || digit > 9)
-    return;
+static void draw_digit_sized(glyph_t* g, int digit, int w, int h, int t) {
   unsigned char segs = digit_segments[digit];
   int half_h = h / 2;
 
   if (segs & 0x40)
-    draw_h_segment(x + t / 2, y, w - t, t);  // a - top
+    draw_h_segment(g, t / 2, 0, w - t, t);  // a - top
   if (segs & 0x20)
-    draw_v_segment(x + w - t, y + t / 2, half_h - t / 2, t);  // b - upper right
+    draw_v_segment(g, w - t, t / 2, half_h - t / 2, t);  // b - upper right
   if (segs & 0x10)
-    draw_v_segment(x + w - t, y + half_h, half_h - t / 2, t);  // c - lower right
+    draw_v_segment(g, w - t, half_h, half_h - t / 2, t);  // c - lower right
   if (segs & 0x08)
-    draw_h_segment(x + t / 2, y + h - t, w - t, t);  // d - bottom
+    draw_h_segment(g, t / 2, h - t, w - t, t);  // d - bottom
   if (segs & 0x04)
-    draw_v_segment(x, y + half_h, half_h - t / 2, t);  // e - lower left
+    draw_v_segment(g, 0, half_h, half_h - t / 2, t);  // e - lower left
   if (segs & 0x02)
-    draw_v_segment(x, y + t / 2, half_h - t / 2, t);  // f - upper left
+    draw_v_segment(g, 0, t / 2, half_h - t / 2, t);  // f - upper left
   if (segs & 0x01)
-    draw_h_segment(x + t / 2, y + half_h - t / 2, w - t, t);  // g - middle
+    draw_h_segment(g, t / 2, half_h - t / 2, w - t, t);  // g - middle
+}
+
+// Draw "1" centered within DIGIT_WIDTH (instead of right-aligned)
+static void draw_one_centered(glyph_t* g) {
+  int center_x = (DIGIT_WIDTH - SEGMENT_THICK) / 2;
+  // Draw segments b (upper right) and c (lower right) centered
+  draw_v_segment(g, center_x, SEGMENT_THICK / 2, DIGIT_HEIGHT / 2 - SEGMENT_THICK / 2, SEGMENT_THICK);
+  draw_v_segment(g, center_x, DIGIT_HEIGHT / 2, DIGIT_HEIGHT / 2 - SEGMENT_THICK / 2, SEGMENT_THICK);
+}
+
+static void make_sprite(fb_sprite_t* sprite, uint8_t* bits, int w, int h) {
+  sprite->width = w;
+  sprite->height = h;
+  sprite->stride = SPRITE_STRIDE(w);
+  sprite->bits = bits;
+}
+
+static void rasterize_digits(void) {
+  memset(large_bits, 0, sizeof(large_bits));
+  memset(med_bits, 0, sizeof(med_bits));
+  for (int digit = 0; digit < 10; digit++) {
+    glyph_t large = {large_bits[digit], SPRITE_STRIDE(DIGIT_WIDTH)};
+    draw_digit_sized(&large, digit, DIGIT_WIDTH, DIGIT_HEIGHT, SEGMENT_THICK);
+    make_sprite(&large_digits[digit], large_bits[digit], DIGIT_WIDTH, DIGIT_HEIGHT);
+
+    glyph_t med = {med_bits[digit], SPRITE_STRIDE(MED_DIGIT_WIDTH)};
+    draw_digit_sized(&med, digit, MED_DIGIT_WIDTH, MED_DIGIT_HEIGHT, MED_SEGMENT_THICK);
+    make_sprite(&med_digits[digit], med_bits[digit], MED_DIGIT_WIDTH, MED_DIGIT_HEIGHT);
+  }
+  glyph_t one = {large_bits[LARGE_ONE_CENTERED], SPRITE_STRIDE(DIGIT_WIDTH)};
+  draw_one_centered(&one);
+  make_sprite(&large_digits[LARGE_ONE_CENTERED], large_bits[LARGE_ONE_CENTERED], DIGIT_WIDTH, DIGIT_HEIGHT);
 }
 
 // Draw large digit for time
 static void draw_large_digit(int x, int y, int digit) {
-  draw_digit_sized(x, y, digit, DIGIT_WIDTH, DIGIT_HEIGHT, SEGMENT_THICK);
+  if (digit < 0 || digit > 9)
+    return;
+  Display.blit(x, y, &large_digits[digit]);
 }
 
 // Draw large "1" centered within DIGIT_WIDTH (instead of right-aligned)
 static void draw_large_one_centered(int x, int y) {
-  int center_x = x + (DIGIT_WIDTH - SEGMENT_THICK) / 2;
-  // Draw segments b (upper right) and c (lower right) centered
-  draw_v_segment(center_x, y + SEGMENT_THICK / 2, DIGIT_HEIGHT / 2 - SEGMENT_THICK / 2, SEGMENT_THICK);
-  draw_v_segment(center_x, y + DIGIT_HEIGHT / 2, DIGIT_HEIGHT / 2 - SEGMENT_THICK / 2, SEGMENT_THICK);
+  Display.blit(x, y, &large_digits[LARGE_ONE_CENTERED]);
 }
 
 // Draw medium digit for day/date
 static void draw_med_digit(int x, int y, int digit) {
-  draw_digit_sized(x, y, digit, MED_DIGIT_WIDTH, MED_DIGIT_HEIGHT, MED_SEGMENT_THICK);
+  if (digit < 0 || digit > 9)
+    return;
+  Display.blit(x, y, &med_digits[digit]);
 }
 
 // Draw colon between hours and minutes (blinks based on seconds)
@@ -207,13 +287,13 @@ static void draw_date(void) {
   int month = currentDate.Month;
   int date = currentDate.Date;
 
-  font_t label_font = gdispOpenFont("DejaVuSans10");
-  font_t value_font = gdispOpenFont("DejaVuSans16");
+  font_t label_font = Fonts.get(FONT_SANS10);
+  font_t value_font = Fonts.get(FONT_SANS16);
 
   // DAY section (left side) - center label over value
   int day_value_x = 8;
-  int day_value_width = gdispGetStringWidth(day, value_font);
-  int day_label_width = gdispGetStringWidth("DAY", label_font);
+  int day_value_width = Fonts.string_width(FONT_SANS16, day);
+  int day_label_width = Fonts.string_width(FONT_SANS10, "DAY");
   int day_label_x = day_value_x + (day_value_width - day_label_width) / 2;
   gdispDrawString(day_label_x, DATE_LABEL_Y, "DAY", label_font, White);
   gdispDrawString(day_value_x, DATE_Y + 4, day, value_font, White);
@@ -227,7 +307,7 @@ static void draw_date(void) {
   int total_num_width = month_width + 2 + slash_width + date_width;
 
   // Draw combined label centered over the numbers
-  int label_width = gdispGetStringWidth("MONTH / DATE", label_font);
+  int label_width = Fonts.string_width(FONT_SANS10, "MONTH / DATE");
   int label_x = num_start_x + (total_num_width - label_width) / 2;
   gdispDrawString(label_x, DATE_LABEL_Y, "MONTH / DATE", label_font, White);
 
@@ -250,9 +330,6 @@ static void draw_date(void) {
     date_x += MED_DIGIT_WIDTH + MED_DIGIT_SPACING;
   }
   draw_med_digit(date_x, DATE_Y, date % 10);
-
-  gdispCloseFont(label_font);
-  gdispCloseFont(value_font);
 }
 
 // Draw rain drop icon
@@ -337,98 +414,58 @@ static void draw_moon_icon(int x, int y, int size) {
   gdispFillCircle(cx + r / 2, cy - r / 4, r - 1, Black);
 }
 
-// Determine precipitation type from condition string
-typedef enum { PRECIP_NONE, PRECIP_RAIN, PRECIP_SNOW, PRECIP_SLEET } precip_type_t;
+static void update_day_night(const RTC_TimeTypeDef* time) {
+  uint8_t hour = time->Hours | (time->TimeFormat == RTC_HOURFORMAT12_PM ? 0x80 : 0);
+  if (hour == day_night.hour) return;
+  day_night.hour = hour;
 
-static precip_type_t get_precip_type(const char* condition) {
-  if (strstr(condition, "Sleet") != NULL || strstr(condition, "sleet") != NULL || strstr(condition, "Ice") != NULL ||
-      strstr(condition, "ice") != NULL || strstr(condition, "Freezing") != NULL ||
-      strstr(condition, "freezing") != NULL || strstr(condition, "Wintry") != NULL ||
-      strstr(condition, "wintry") != NULL) {
-    return PRECIP_SLEET;
-  }
-  if (strstr(condition, "Snow") != NULL || strstr(condition, "snow") != NULL || strstr(condition, "Flurr") != NULL ||
-      strstr(condition, "flurr") != NULL || strstr(condition, "Blizzard") != NULL ||
-      strstr(condition, "blizzard") != NULL) {
-    return PRECIP_SNOW;
-  }
-  if (strstr(condition, "Rain") != NULL || strstr(condition, "rain") != NULL || strstr(condition, "Drizzle") != NULL ||
-      strstr(condition, "drizzle") != NULL || strstr(condition, "Shower") != NULL ||
-      strstr(condition, "shower") != NULL || strstr(condition, "Thunder") != NULL ||
-      strstr(condition, "thunder") != NULL) {
-    return PRECIP_RAIN;
+  // Convert 12-hour RTC format to 24-hour for day/night check
+  uint8_t hour_24;
+  if (time->TimeFormat == RTC_HOURFORMAT12_AM) {
+    // AM: 12 AM = 0, 1-11 AM = 1-11
+    hour_24 = (time->Hours == 12) ? 0 : time->Hours;
+  } else {
+    // PM: 12 PM = 12, 1-11 PM = 13-23
+    hour_24 = (time->Hours == 12) ? 12 : time->Hours + 12;
   }
-  return PRECIP_NONE;
+  day_night.is_day = (hour_24 >= 6 && hour_24 < 20);
 }
 
 // Draw temperature section with temp, condition, icon, precipitation
 static void draw_temp(void) {
-  font_t font = gdispOpenFont("DejaVuSans16");
+  font_t font = Fonts.get(FONT_SANS16);
   int text_x = 4;
 
   if (!weather_data.valid) {
     // Show placeholder when no data
     gdispDrawString(text_x, TEMP_Y + 1, "--", font, White);
-    int dash_width = gdispGetStringWidth("--", font);
+    int dash_width = Fonts.string_width(FONT_SANS16, "--");
     draw_degree_symbol(text_x + dash_width, TEMP_Y + 1);
     gdispDrawString(text_x + dash_width + 8, TEMP_Y + 1, "F", font, White);
-    gdispCloseFont(font);
     return;
   }
 
   // Draw temperature value
-  char temp_val[8];
-  snprintf(temp_val, sizeof(temp_val), "%d", weather_data.temp_f);
-  gdispDrawString(text_x, TEMP_Y + 1, temp_val, font, White);
-  int temp_width = gdispGetStringWidth(temp_val, font);
+  gdispDrawString(text_x, TEMP_Y + 1, strip.temp_val, font, White);
 
   // Draw degree symbol manually
-  draw_degree_symbol(text_x + temp_width, TEMP_Y + 1);
+  draw_degree_symbol(text_x + strip.temp_width, TEMP_Y + 1);
 
   // Draw F
-  gdispDrawString(text_x + temp_width + 8, TEMP_Y + 1, "F", font, White);
-  int f_width = gdispGetStringWidth("F", font);
-  int total_temp_width = temp_width + 8 + f_width;
-
-  // Draw condition/forecast (truncate to fit before icon)
-  char condition_short[10];
-  strncpy(condition_short, weather_data.condition, sizeof(condition_short) - 1);
-  condition_short[sizeof(condition_short) - 1] = '\0';
-
-  gdispDrawString(text_x + total_temp_width + 8, TEMP_Y + 1, condition_short, font, White);
-
-  // Calculate precipitation text width first to position icon
-  char precip_str[8];
-  snprintf(precip_str, sizeof(precip_str), "%d%%", weather_data.precip_chance);
-  font_t precip_font = gdispOpenFont("DejaVuSans10");
-  int precip_width = gdispGetStringWidth(precip_str, precip_font);
-  int precip_draw_x = DISPLAY_WIDTH - precip_width - 2;  // Right-align with 2px margin
-  int icon_x = precip_draw_x - 12;  // Icon to the left of percentage with 2px gap
-
-  // Determine precipitation type for icon
-  precip_type_t precip = get_precip_type(weather_data.condition);
+  gdispDrawString(text_x + strip.temp_width + 8, TEMP_Y + 1, "F", font, White);
+  int f_width = Fonts.string_width(FONT_SANS16, "F");
+  int total_temp_width = strip.temp_width + 8 + f_width;
 
-  // Get current hour to determine day/night
-  // RTC stores local time in 12-hour format with AM/PM flag
-  RTC_TimeTypeDef currentTime;
-  RTC_DateTypeDef currentDate;
-  HAL_RTC_GetTime(&hrtc, &currentTime, RTC_FORMAT_BIN);
-  HAL_RTC_GetDate(&hrtc, &currentDate, RTC_FORMAT_BIN);
-
-  // Convert 12-hour RTC format to 24-hour for day/night check
-  uint8_t hour_24;
-  if (currentTime.TimeFormat == RTC_HOURFORMAT12_AM) {
-    // AM: 12 AM = 0, 1-11 AM = 1-11
-    hour_24 = (currentTime.Hours == 12) ? 0 : currentTime.Hours;
-  } else {
-    // PM: 12 PM = 12, 1-11 PM = 13-23
-    hour_24 = (currentTime.Hours == 12) ? 12 : currentTime.Hours + 12;
-  }
+  // Draw condition/forecast
+  gdispDrawString(text_x + total_temp_width + 8, TEMP_Y + 1, strip.condition_short, font, White);
 
-  bool is_day = (hour_24 >= 6 && hour_24 < 20);
+  // Right-align the percentage with a 2px margin, icon to the left of it
+  font_t precip_font = Fonts.get(FONT_SANS10);
+  int precip_draw_x = DISPLAY_WIDTH - strip.precip_width - 2;
+  int icon_x = precip_draw_x - 12;
 
   // Always draw weather icon
-  switch (precip) {
+  switch (strip.precip) {
     case PRECIP_SNOW:
       draw_snow_icon(icon_x, TEMP_Y, 10);
       break;
@@ -441,7 +478,7 @@ static void draw_temp(void) {
     case PRECIP_NONE:
     default:
       // Show sun during day, moon at night
-      if (is_day) {
+      if (day_night.is_day) {
         draw_sun_icon(icon_x, TEMP_Y, 10);
       } else {
         draw_moon_icon(icon_x, TEMP_Y, 10);
@@ -450,10 +487,7 @@ static void draw_temp(void) {
   }
 
   // Draw precipitation percentage
-  gdispDrawString(precip_draw_x, TEMP_Y + 3, precip_str, precip_font, White);
-  gdispCloseFont(precip_font);
-
-  gdispCloseFont(font);
+  gdispDrawString(precip_draw_x, TEMP_Y + 3, strip.precip_str, precip_font, White);
 }
 
 static void render(void) {
@@ -480,9 +514,13 @@ static void render(void) {
   draw_separator(LINE2_Y);
 
   // Draw temperature section
+  update_day_night(&currentTime);
   draw_temp();
 
   gdispGFlush(gdispGetDisplay(0));
+
+  // Next frame as the RTC second turns over, not a second after this one
+  view_schedule_wake_in(&view.schedule, HAL_GetTick(), DateHelper.ms_to_next_second(&currentTime));
 }
 
 static void set_weather(int16_t temp_f, const char* condition, uint8_t precip_chance) {
@@ -495,12 +533,24 @@ static void set_weather(int16_t temp_f, const char* condition, uint8_t precip_ch
   }
   weather_data.precip_chance = precip_chance;
   weather_data.valid = true;
+
+  snprintf(strip.temp_val, sizeof(strip.temp_val), "%d", temp_f);
+  strip.temp_width = Fonts.string_width(FONT_SANS16, strip.temp_val);
+  strncpy(strip.condition_short, weather_data.condition, sizeof(strip.condition_short) - 1);
+  strip.condition_short[sizeof(strip.condition_short) - 1] = '\0';
+  snprintf(strip.precip_str, sizeof(strip.precip_str), "%d%%", precip_chance);
+  strip.precip_width = Fonts.string_width(FONT_SANS10, strip.precip_str);
+  strip.precip = weather_classify(weather_data.condition);
+  view_invalidate(&view);
 }
 
 static View* init(void) {
   view.render = render;
+  view_schedule_init(&view.schedule, FRAME_INTERVAL);
+  rasterize_digits();
   anim.frame = 0;
   weather_data.valid = false;
+  day_night.hour = 0xFF;
   return &view;
 }
 
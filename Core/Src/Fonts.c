@@ -0,0 +1,69 @@
+#include "Fonts.h"
+#include <string.h>
+#include "text_metrics.h"
+
+#define FONTS_MAX_MEASURE 63  // Longest prefix prefix_width copies out for uGFX
+
+static const char* const names[FONT_COUNT] = {
+    [FONT_SANS10] = "DejaVuSans10",
+    [FONT_SANS12] = "DejaVuSans12",
+    [FONT_SANS16] = "DejaVuSans16",
+    [FONT_SANS24] = "DejaVuSans24",
+    [FONT_SANS32] = "DejaVuSans32",
+    [FONT_SANS_BOLD12] = "DejaVuSansBold12",
+};
+
+static font_t fonts[FONT_COUNT];
+static text_metrics_t metrics[FONT_COUNT];
+static text_cache_t widths;
+
+static void init(void) {
+  for (int id = 0; id < FONT_COUNT; id++) {
+    fonts[id] = gdispOpenFont(names[id]);
+    metrics[id].height = gdispGetFontMetric(fonts[id], fontHeight);
+    for (int c = TEXT_FIRST_CHAR; c <= TEXT_LAST_CHAR; c++) {
+      metrics[id].widths[c - TEXT_FIRST_CHAR] = gdispGetCharWidth((char)c, fonts[id]);
+    }
+  }
+  text_cache_clear(&widths);
+}
+
+static font_t get(font_id_t id) {
+  return fonts[id];
+}
+
+static int height(font_id_t id) {
+  return metrics[id].height;
+}
+
+static int string_width(font_id_t id, const char* str) {
+  int width;
+  if (text_cache_lookup(&widths, id, str, &width)) return width;
+
+  // uGFX measures without kerning, so this is the same sum it would make
+  width = text_width(&metrics[id], str);
+  if (width < 0) {
+    width = gdispGetStringWidth(str, fonts[id]);
+  }
+  text_cache_store(&widths, id, str, width);
+  return width;
+}
+
+static int prefix_width(font_id_t id, const char* str, size_t len) {
+  int width = text_width_n(&metrics[id], str, len);
+  if (width >= 0) return width;
+
+  char buffer[FONTS_MAX_MEASURE + 1];
+  if (len > FONTS_MAX_MEASURE) len = FONTS_MAX_MEASURE;
+  strncpy(buffer, str, len);
+  buffer[len] = '\0';
+  return gdispGetStringWidth(buffer, fonts[id]);
+}
+
+const struct fonts Fonts = {
+    .init = init,
+    .get = get,
+    .height = height,
+    .string_width = string_width,
+    .prefix_width = prefix_width,
+};
@@ -1,9 +1,12 @@
 #include "StatusView.h"
+#include "Fonts.h"
 #include <stdio.h>
 #include <string.h>
 
 static View view;
 
+#define FRAME_INTERVAL 50  // Spinner steps every 3 frames
+
 // Display dimensions
 #define DISPLAY_WIDTH 160
 #define DISPLAY_HEIGHT 160
@@ -88,7 +91,7 @@ static void draw_pending_circle(int x, int y, int size) {
 
 // Draw a status item with label and indicator
 static void draw_status_item(int y, const char* label, boot_phase_state_t state) {
-  font_t font = gdispOpenFont("DejaVuSans12");
+  font_t font = Fonts.get(FONT_SANS12);
 
   // Draw label
   int text_x = 20;
@@ -110,8 +113,6 @@ static void draw_status_item(int y, const char* label, boot_phase_state_t state)
       draw_pending_circle(indicator_x, y + 1, indicator_size);
       break;
   }
-
-  gdispCloseFont(font);
 }
 
 static void render(void) {
@@ -120,11 +121,10 @@ static void render(void) {
   gdispClear(Black);
 
   // Draw title
-  font_t title_font = gdispOpenFont("DejaVuSans16");
+  font_t title_font = Fonts.get(FONT_SANS16);
   const char* title = "Booting...";
-  int title_width = gdispGetStringWidth(title, title_font);
+  int title_width = Fonts.string_width(FONT_SANS16, title);
   gdispDrawString((DISPLAY_WIDTH - title_width) / 2, 20, title, title_font, White);
-  gdispCloseFont(title_font);
 
   // Draw separator line
   gdispDrawLine(20, 45, DISPLAY_WIDTH - 20, 45, White);
@@ -152,22 +152,27 @@ static void render(void) {
 
 static void set_wifi_state(boot_phase_state_t state) {
   wifi_state = state;
+  view_invalidate(&view);
 }
 
 static void set_time_state(boot_phase_state_t state) {
   time_state = state;
+  view_invalidate(&view);
 }
 
 static void set_weather_state(boot_phase_state_t state) {
   weather_state = state;
+  view_invalidate(&view);
 }
 
 static void set_balance_state(boot_phase_state_t state) {
   balance_state = state;
+  view_invalidate(&view);
 }
 
 static void set_calendar_state(boot_phase_state_t state) {
   calendar_state = state;
+  view_invalidate(&view);
 }
 
 static bool is_boot_complete(void) {
@@ -180,6 +185,7 @@ static bool is_boot_complete(void) {
 
 static View* init(void) {
   view.render = render;
+  view_schedule_init(&view.schedule, FRAME_INTERVAL);
   anim_frame = 0;
   wifi_state = BOOT_PHASE_PENDING;
   time_state = BOOT_PHASE_PENDING;
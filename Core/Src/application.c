@@ -15,10 +15,18 @@ struct DigitalEncoderValue old_encoder_value;
 static uint8_t active_view = 0;
 // AlarmView editing state
 static bool alarm_view_active = false;
+// The view on the panel, and loop passes that drew it vs found nothing due
+static View* shown_view = NULL;
+static uint32_t frames_drawn = 0;
+static uint32_t frames_skipped = 0;
+// CPU cycles spent in render() (the DWT counter is started by Display.init)
+static uint64_t render_cycles_total = 0;
+static uint32_t render_cycles_max = 0;
 #define CLOCK_DISPLAY_TIME 30000           // 30 seconds on clock
 #define CALENDAR_DISPLAY_TIME 10000        // 10 seconds on calendar
 #define BANK_DISPLAY_TIME 10000            // 10 seconds on bank
 #define CALENDAR_REFRESH_INTERVAL 3600000  // 1 hour
+#define DISPLAY_STATS_INTERVAL 60000       // 1 minute
 extern TIM_HandleTypeDef htim1;
 extern TIM_HandleTypeDef htim2;
 extern TIM_HandleTypeDef htim3;
@@ -55,7 +63,7 @@ View* get_current_view(void) {
 #define MAX_PROJECT_ID_LEN 128
 #define MAX_EMAIL_LEN 256
 #define MAX_PRIVATE_KEY_LEN 2048
-#define MAX_CALENDAR_URL_LEN 256
+#define MAX_CALENDAR_URL_LEN 776  // Up to three space-separated feed URLs
 #define MAX_API_KEY_LEN 64
 #define MAX_CITY_LEN 64
 #define MAX_COUNTRY_LEN 8
@@ -189,7 +197,7 @@ static void config() {
                       &client_email_printer);
   Disk.register_entry("PRIVATE_KEY", "", "#Service account private key", &private_key_validator, &private_key_updater,
                       &private_key_printer);
-  Disk.register_entry("CALENDAR_URL", "", "#Google Calendar iCal URL", &calendar_url_validator, &calendar_url_updater,
+  Disk.register_entry("CALENDAR_URL", "", "#iCal feed URLs, space-separated (up to 3)", &calendar_url_validator, &calendar_url_updater,
                       &calendar_url_printer);
   Disk.register_entry("OPENWEATHER_API_KEY", "", "#OpenWeather API key", &openweather_api_key_validator,
                       &openweather_api_key_updater, &openweather_api_key_printer);
@@ -255,6 +263,24 @@ static void refresh_balance_cb(void) {
   app_log_debug("Refreshing balance...");
   ESPComm.request_balance(on_esp_balance_received);
 }
+static void log_display_stats_cb(void) {
+  const display_stats_t* stats = Display.stats();
+  app_log_debug("Display: %lu flushes, %lu unchanged, %lu dropped, last %lu of %lu bytes in %u windows, "
+                "%lu us (max %lu us) + %lu us DMA",
+                (unsigned long)stats->frames, (unsigned long)stats->frames_skipped,
+                (unsigned long)stats->frames_dropped, (unsigned long)stats->bytes_last,
+                (unsigned long)stats->bytes_full, stats->bands_last, (unsigned long)stats->flush_us_last,
+                (unsigned long)stats->flush_us_max, (unsigned long)stats->transfer_us_last);
+  app_log_debug("Views: %lu frames drawn (%lu cycles avg, %lu max), %lu loop passes with nothing due",
+                (unsigned long)frames_drawn,
+                (unsigned long)(frames_drawn ? render_cycles_total / frames_drawn : 0),
+                (unsigned long)render_cycles_max, (unsigned long)frames_skipped);
+  Display.reset_stats();
+  frames_drawn = 0;
+  frames_skipped = 0;
+  render_cycles_total = 0;
+  render_cycles_max = 0;
+}
 static void request_weather_and_time_cb(void) {
   // Request time first, then weather callback will be triggered after time
   ESPComm.request_time(on_esp_time_received);
@@ -335,12 +361,13 @@ static void on_esp_status_received(esp_status_t* status) {
     // Request time first, then weather (to match boot status display order)
     ESPComm.request_time(on_esp_time_received);
   }
-  app_log_debug("ESP status: valid=%d connected=%d connecting=%d rssi=%d gsheet=%d ip=%s", status->valid,
-                status->connected, status->connecting, status->rssi, status->gsheet_status, status->ip_address);
+  app_log_debug("ESP status: valid=%d connected=%d connecting=%d rssi=%d gsheet=%d ip=%s assoc=%lums%s",
+                status->valid, status->connected, status->connecting, status->rssi, status->gsheet_status,
+                status->ip_address, (unsigned long)status->assoc_ms, status->assoc_fast ? " (fast)" : "");
 }
 static void on_esp_balance_received(esp_balance_t* balance) {
   if (balance->valid) {
-    app_log_debug("Balance: %ld", (long)balance->balance);
+    app_log_debug("Balance: %ld%s", (long)balance->balance, balance->stale ? " (stale)" : "");
     BankView.set_balance(balance->balance);
   } else {
     app_log_error("Unable to fetch balance!");
@@ -354,7 +381,7 @@ static void on_esp_balance_received(esp_balance_t* balance) {
 }
 static void on_esp_calendar_received(esp_calendar_t* cal) {
   if (cal->valid) {
-    app_log_debug("Received %d calendar events", cal->event_count);
+    app_log_debug("Received %d calendar events%s", cal->event_count, cal->stale ? " (stale)" : "");
     // Update CalendarView with the events
     CalendarView.set_events((calendar_event_t*)cal->events, cal->event_count);
   } else {
@@ -378,8 +405,8 @@ static void on_esp_calendar_received(esp_calendar_t* cal) {
 
 static void on_esp_time_received(esp_time_t* time) {
   if (time->valid) {
-    app_log_debug("Time (UTC): %04d-%02d-%02d %02d:%02d:%02d", time->year, time->month, time->day, time->hour,
-                  time->minute, time->second);
+    app_log_debug("Time (UTC): %04d-%02d-%02d %02d:%02d:%02d.%03d", time->year, time->month, time->day,
+                  time->hour, time->minute, time->second, time->millisecond);
 
     // Apply Eastern timezone offset (handles DST automatically)
     uint16_t local_year = time->year;
@@ -445,8 +472,9 @@ static void on_esp_time_received(esp_time_t* time) {
 static void on_esp_weather_received(esp_weather_t* weather);
 static void on_esp_weather_received(esp_weather_t* weather) {
   if (weather->valid) {
-    app_log_debug("Weather: %d°F, %s, humidity=%d%%, precip=%d%%", weather->temp_f, weather->condition,
-                  weather->humidity, weather->precip_chance);
+    // Stale data was restored from the ESP8266's flash; it pushes fresh data once fetched
+    app_log_debug("Weather: %d°F, %s, humidity=%d%%, precip=%d%%%s", weather->temp_f, weather->condition,
+                  weather->humidity, weather->precip_chance, weather->stale ? " (stale)" : "");
     // Update FlipClockView with weather data
     FlipClockView.set_weather(weather->temp_f, weather->condition, weather->precip_chance);
     // Weather received, mark complete and start balance phase
@@ -503,6 +531,8 @@ static void init() {
 
   gfxInit();
   gdispGSetOrientation(gdispGetDisplay(0), GDISP_ROTATE_0);
+  Display.init();
+  Fonts.init();
   clock_view = ClockView.init();
   flip_clock_view = FlipClockView.init();
   status_view = StatusView.init();
@@ -511,6 +541,7 @@ static void init() {
   bank_view = BankView.init();
 
   Timer.init();
+  Timer.every(DISPLAY_STATS_INTERVAL, log_display_stats_cb);
   DigitalEncoder.init(0x10);
 
   // Show status view and start wifi connection phase
@@ -555,23 +586,42 @@ static void init() {
   VIEW_COUNT = MAX_VIEWS;
 }
 
+// Status view during boot, alarm view if active, or the cycle between flip
+// clock, calendar, and bank
+static View* visible_view(void) {
+  if (!boot_complete) return status_view;
+  if (alarm_view_active) return alarm_view;
+  if (active_view == 0) return flip_clock_view;
+  if (active_view == 1) return calendar_view;
+  return bank_view;
+}
+
+// Draw the visible view only if it changed or its next animation frame is due
+static void render_view(void) {
+  View* view = visible_view();
+  uint32_t now = HAL_GetTick();
+  if (view != shown_view) {
+    // The panel still shows the previous view
+    view_invalidate(view);
+    shown_view = view;
+  }
+  if (!view_schedule_due(&view->schedule, now)) {
+    frames_skipped++;
+    return;
+  }
+  view_schedule_begin_frame(&view->schedule, now);
+  uint32_t start = DWT->CYCCNT;
+  view->render();
+  uint32_t cycles = DWT->CYCCNT - start;
+  frames_drawn++;
+  render_cycles_total += cycles;
+  if (cycles > render_cycles_max) render_cycles_max = cycles;
+}
+
 // TODO: a "settings" screen to control volume and brightness, persist in
 // eeprom, maybe alarm time?
 static void run(void) {
-  // Show status view during boot, alarm view if active, or cycle between flip clock, calendar, and bank
-  if (boot_complete) {
-    if (alarm_view_active) {
-      alarm_view->render();
-    } else if (active_view == 0) {
-      flip_clock_view->render();
-    } else if (active_view == 1) {
-      calendar_view->render();
-    } else {
-      bank_view->render();
-    }
-  } else {
-    status_view->render();
-  }
+  render_view();
   if (DigitalEncoder.irq_raised()) {
     struct DigitalEncoderValue encoder_value = DigitalEncoder.query();
 
@@ -621,6 +671,7 @@ static void run(void) {
   }
   ESPComm.process();
   Disk.process();
+  Display.process();
   NeoPixel.updateEffect();
   // if (ESP_READY && (!ESP_BALANCE_RECEIVED || !ESP_CALENDAR_RECEIVED)) {
   //   if (!ESP_BALANCE_REQUESTED && !ESP_BALANCE_RECEIVED) {
@@ -659,6 +710,10 @@ void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef* htim) {
   NeoPixel.dmaCompleteCallback(htim);
 }
 
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi) {
+  Display.dma_complete(hspi);
+}
+
 const struct application Application = {
     .config = config,
     .init = init,
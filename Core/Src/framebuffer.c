@@ -0,0 +1,184 @@
+#include "framebuffer.h"
+#include <string.h>
+
+void fb_clear(framebuffer_t* fb, bool on) {
+  memset(fb->bits, on ? 0xFF : 0x00, FB_SIZE);
+}
+
+void fb_set_pixel(framebuffer_t* fb, int x, int y, bool on) {
+  uint8_t* byte = &fb->bits[y * FB_STRIDE + (x >> 3)];
+  uint8_t mask = 0x80 >> (x & 7);
+  if (on) {
+    *byte |= mask;
+  } else {
+    *byte &= ~mask;
+  }
+}
+
+bool fb_get_pixel(const framebuffer_t* fb, int x, int y) {
+  return (fb->bits[y * FB_STRIDE + (x >> 3)] & (0x80 >> (x & 7))) != 0;
+}
+
+void fb_fill_rect(framebuffer_t* fb, int x, int y, int cx, int cy, bool on) {
+  if (cx <= 0 || cy <= 0) return;
+
+  int first = x >> 3;
+  int last = (x + cx - 1) >> 3;
+  uint8_t first_mask = 0xFF >> (x & 7);
+  uint8_t last_mask = 0xFF << (7 - ((x + cx - 1) & 7));
+  if (first == last) {
+    first_mask &= last_mask;
+  }
+  uint8_t fill = on ? 0xFF : 0x00;
+
+  for (uint8_t* row = &fb->bits[y * FB_STRIDE]; cy > 0; cy--, row += FB_STRIDE) {
+    row[first] = (row[first] & ~first_mask) | (fill & first_mask);
+    if (first == last) continue;
+    if (last > first + 1) {
+      memset(row + first + 1, fill, last - first - 1);
+    }
+    row[last] = (row[last] & ~last_mask) | (fill & last_mask);
+  }
+}
+
+// Rows are MSB-first bytes; read and write them 32 pixels at a time as
+// big-endian words (unaligned word access is fine on the M4)
+static inline uint32_t load_be32(const uint8_t* p) {
+  uint32_t w;
+  memcpy(&w, p, 4);
+  return __builtin_bswap32(w);
+}
+
+static inline void or_be32(uint8_t* p, uint32_t bits) {
+  uint32_t w;
+  memcpy(&w, p, 4);
+  w |= __builtin_bswap32(bits);
+  memcpy(p, &w, 4);
+}
+
+void fb_blit(framebuffer_t* fb, int x, int y, const fb_sprite_t* sprite) {
+  int row0 = y < 0 ? -y : 0;
+  int row1 = y + sprite->height > FB_HEIGHT ? FB_HEIGHT - y : sprite->height;
+
+  if (x < 0 || x + sprite->width > FB_WIDTH) {
+    // Partly off the side: rare enough to go pixel by pixel
+    for (int r = row0; r < row1; r++) {
+      const uint8_t* src = &sprite->bits[r * sprite->stride];
+      for (int c = 0; c < sprite->width; c++) {
+        if (x + c >= 0 && x + c < FB_WIDTH && (src[c >> 3] & (0x80 >> (c & 7)))) {
+          fb_set_pixel(fb, x + c, y + r, true);
+        }
+      }
+    }
+    return;
+  }
+
+  // 32 pixels at a time, then the odd bytes. Source bits land across two
+  // frame words unless x is byte aligned; carry holds the spill, top aligned.
+  int shift = x & 7;
+  int words = sprite->stride / 4;
+  for (int r = row0; r < row1; r++) {
+    const uint8_t* src = &sprite->bits[r * sprite->stride];
+    uint8_t* dst = &fb->bits[(y + r) * FB_STRIDE + (x >> 3)];
+    uint32_t carry = 0;
+    int i = 0;
+    for (; i < words * 4; i += 4) {
+      uint32_t w = load_be32(&src[i]);
+      or_be32(&dst[i], carry | (w >> shift));
+      carry = shift ? w << (32 - shift) : 0;
+    }
+    for (; i < sprite->stride; i++) {
+      dst[i] |= (uint8_t)((carry >> 24) | (src[i] >> shift));
+      carry = shift ? (uint32_t)src[i] << (32 - shift) : 0;
+    }
+    // Only set when real pixels spill over, which are inside the row
+    if (carry) dst[sprite->stride] |= (uint8_t)(carry >> 24);
+  }
+}
+
+bool fb_rle_unpack(const fb_rle_sprite_t* rle, uint8_t* bits, fb_sprite_t* sprite) {
+  size_t size = (size_t)rle->stride * rle->height;
+  size_t out = 0;
+  for (size_t in = 0; in < rle->size;) {
+    uint8_t n = rle->data[in++];
+    if (n < 128) {
+      size_t count = n + 1;
+      if (in + count > rle->size || out + count > size) return false;
+      memcpy(&bits[out], &rle->data[in], count);
+      in += count;
+      out += count;
+    } else if (n > 128) {
+      size_t count = 257 - n;
+      if (in >= rle->size || out + count > size) return false;
+      memset(&bits[out], rle->data[in++], count);
+      out += count;
+    }
+  }
+  if (out != size) return false;
+
+  sprite->width = rle->width;
+  sprite->height = rle->height;
+  sprite->stride = rle->stride;
+  sprite->bits = bits;
+  return true;
+}
+
+// First and last differing byte of a row, or false if it is unchanged
+static bool row_diff(const uint8_t* a, const uint8_t* b, int* first, int* last) {
+  // Compare a word at a time (FB_STRIDE is a multiple of 4), so most
+  // unchanged rows are rejected in five compares; memcpy keeps it within
+  // the aliasing rules and still compiles to one LDR each
+  int i = 0;
+  for (; i < FB_STRIDE; i += 4) {
+    uint32_t wa, wb;
+    memcpy(&wa, &a[i], 4);
+    memcpy(&wb, &b[i], 4);
+    if (wa != wb) break;
+  }
+  if (i == FB_STRIDE) return false;
+
+  while (a[i] == b[i]) i++;
+  *first = i;
+  i = FB_STRIDE - 1;
+  while (a[i] == b[i]) i--;
+  *last = i;
+  return true;
+}
+
+int fb_diff(const framebuffer_t* frame, const framebuffer_t* sent, int align, fb_band_t* bands, int max) {
+  int count = 0;
+  int last_dirty = -FB_BAND_MERGE_ROWS - 1;
+
+  for (int y = 0; y < FB_HEIGHT; y++) {
+    int first, last;
+    if (!row_diff(&frame->bits[y * FB_STRIDE], &sent->bits[y * FB_STRIDE], &first, &last)) continue;
+
+    uint16_t x0 = first * 8;
+    uint16_t x1 = (last + 1) * 8;
+    if (count > 0 && (y - last_dirty <= FB_BAND_MERGE_ROWS || count == max)) {
+      fb_band_t* band = &bands[count - 1];
+      if (x0 < band->x0) band->x0 = x0;
+      if (x1 > band->x1) band->x1 = x1;
+      band->y1 = y + 1;
+    } else {
+      bands[count].x0 = x0;
+      bands[count].x1 = x1;
+      bands[count].y0 = y;
+      bands[count].y1 = y + 1;
+      count++;
+    }
+    last_dirty = y;
+  }
+
+  for (int i = 0; i < count; i++) {
+    bands[i].x0 -= bands[i].x0 % align;
+    bands[i].x1 += (align - bands[i].x1 % align) % align;
+  }
+  return count;
+}
+
+void fb_commit(framebuffer_t* sent, const framebuffer_t* frame, const fb_band_t* band) {
+  // Whole rows: the columns outside the band did not differ
+  size_t offset = band->y0 * FB_STRIDE;
+  memcpy(&sent->bits[offset], &frame->bits[offset], (band->y1 - band->y0) * FB_STRIDE);
+}
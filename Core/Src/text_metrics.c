@@ -0,0 +1,56 @@
+#include "text_metrics.h"
+#include <stdint.h>
+#include <string.h>
+
+int text_width(const text_metrics_t* metrics, const char* str) {
+  return text_width_n(metrics, str, SIZE_MAX);
+}
+
+int text_width_n(const text_metrics_t* metrics, const char* str, size_t len) {
+  int width = 0;
+  for (const unsigned char* p = (const unsigned char*)str; len > 0 && *p; p++, len--) {
+    if (*p < TEXT_FIRST_CHAR || *p > TEXT_LAST_CHAR) return -1;
+    width += metrics->widths[*p - TEXT_FIRST_CHAR];
+  }
+  return width;
+}
+
+void text_cache_clear(text_cache_t* cache) {
+  for (int i = 0; i < TEXT_CACHE_SLOTS; i++) {
+    cache->slots[i].font = -1;
+  }
+  cache->hits = 0;
+  cache->misses = 0;
+}
+
+// Direct mapped on font and contents; FNV-1a, which also yields the length
+static text_cache_entry_t* slot_for(text_cache_t* cache, int font, const char* str, size_t* len) {
+  uint32_t hash = 2166136261u ^ (uint32_t)font;
+  const char* p = str;
+  for (; *p; p++) {
+    hash = (hash ^ (uint8_t)*p) * 16777619u;
+  }
+  *len = p - str;
+  return &cache->slots[hash % TEXT_CACHE_SLOTS];
+}
+
+bool text_cache_lookup(text_cache_t* cache, int font, const char* str, int* width) {
+  size_t len;
+  text_cache_entry_t* slot = slot_for(cache, font, str, &len);
+  if (len <= TEXT_CACHE_MAX_LEN && slot->font == font && strcmp(slot->text, str) == 0) {
+    *width = slot->width;
+    cache->hits++;
+    return true;
+  }
+  cache->misses++;
+  return false;
+}
+
+void text_cache_store(text_cache_t* cache, int font, const char* str, int width) {
+  size_t len;
+  text_cache_entry_t* slot = slot_for(cache, font, str, &len);
+  if (len > TEXT_CACHE_MAX_LEN) return;
+  slot->font = font;
+  slot->width = width;
+  memcpy(slot->text, str, len + 1);
+}
@@ -0,0 +1,31 @@
+#include "view_schedule.h"
+
+void view_schedule_init(view_schedule_t* s, uint32_t interval) {
+  s->interval = interval;
+  s->next_wake = 0;
+  s->waking = false;
+  s->dirty = true;
+}
+
+void view_schedule_invalidate(view_schedule_t* s) {
+  s->dirty = true;
+}
+
+bool view_schedule_due(const view_schedule_t* s, uint32_t now) {
+  // Signed difference so the 49-day tick wrap is harmless
+  return s->dirty || (s->waking && (int32_t)(now - s->next_wake) >= 0);
+}
+
+void view_schedule_begin_frame(view_schedule_t* s, uint32_t now) {
+  s->dirty = false;
+  s->waking = s->interval != 0;
+  s->next_wake = now + s->interval;
+}
+
+void view_schedule_wake_in(view_schedule_t* s, uint32_t now, uint32_t ms) {
+  uint32_t wake = now + ms;
+  if (!s->waking || (int32_t)(wake - s->next_wake) < 0) {
+    s->next_wake = wake;
+    s->waking = true;
+  }
+}
@@ -0,0 +1,32 @@
+#include "weather_condition.h"
+#include <ctype.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+  const char* keyword;  // Lower case
+  precip_type_t type;
+} weather_keyword_t;
+
+static const weather_keyword_t keywords[] = {
+    {"sleet", PRECIP_SLEET}, {"ice", PRECIP_SLEET},   {"freezing", PRECIP_SLEET}, {"wintry", PRECIP_SLEET},
+    {"snow", PRECIP_SNOW},   {"flurr", PRECIP_SNOW},  {"blizzard", PRECIP_SNOW},
+    {"rain", PRECIP_RAIN},   {"drizzle", PRECIP_RAIN}, {"shower", PRECIP_RAIN},  {"thunder", PRECIP_RAIN},
+};
+
+static bool contains_nocase(const char* text, const char* keyword) {
+  for (; *text; text++) {
+    size_t i = 0;
+    while (keyword[i] && tolower((unsigned char)text[i]) == keyword[i]) i++;
+    if (!keyword[i]) return true;
+  }
+  return false;
+}
+
+precip_type_t weather_classify(const char* condition) {
+  if (!condition) return PRECIP_NONE;
+  for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+    if (contains_nocase(condition, keywords[i].keyword)) return keywords[i].type;
+  }
+  return PRECIP_NONE;
+}
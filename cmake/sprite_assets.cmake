@@ -0,0 +1,35 @@
+# Build-time conversion of images into packed 1bpp sprite headers
+# (tools/bmp2sprite.py), so the firmware blits them without decoding.
+#
+#   add_sprite_assets(<target> OUTPUT_DIR <dir> IMAGES <bmp>... [RLE])
+#
+# Each image becomes <dir>/<name>.h defining <name>_sprite (or <name>_rle
+# with RLE). Add <dir> to the include path and depend on <target>.
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(SPRITE_ASSET_TOOL ${CMAKE_CURRENT_LIST_DIR}/../tools/bmp2sprite.py)
+
+function(add_sprite_assets TARGET)
+    cmake_parse_arguments(ARG "RLE" "OUTPUT_DIR" "IMAGES" ${ARGN})
+    set(flags)
+    if(ARG_RLE)
+        list(APPEND flags --rle)
+    endif()
+
+    set(headers)
+    foreach(image ${ARG_IMAGES})
+        get_filename_component(image ${image} ABSOLUTE)
+        get_filename_component(name ${image} NAME_WE)
+        set(header ${ARG_OUTPUT_DIR}/${name}.h)
+        add_custom_command(
+            OUTPUT ${header}
+            COMMAND Python3::Interpreter ${SPRITE_ASSET_TOOL} ${flags} ${image} ${header}
+            DEPENDS ${image} ${SPRITE_ASSET_TOOL}
+            COMMENT "Converting ${name} to a 1bpp sprite"
+            VERBATIM
+        )
+        list(APPEND headers ${header})
+    endforeach()
+    add_custom_target(${TARGET} DEPENDS ${headers})
+endfunction()
@@ -0,0 +1,210 @@
+/*
+ * ICalParser - cached event records for conditional fetches
+ *
+ * Only events whose next occurrence existed at fetch time are stored: "now"
+ * only moves forward, so an event with no occurrence left can never come
+ * back. Re-expanding the cached records (with their EXDATEs and the feed's
+ * RECURRENCE-ID overrides) for a later "now" therefore gives the same list a
+ * full download and parse of an unchanged feed would.
+ */
+
+#include "ICalParser.h"
+
+ICalEventCache::ICalEventCache() {
+  clear();
+}
+
+void ICalEventCache::clear() {
+  _count = 0;
+  _poolUsed = 0;
+  _exdateUsed = 0;
+  _overrideCount = 0;
+  _overflow = false;
+  _valid = false;
+  _stale = false;
+  _urlHash = 0;
+  _fetchedAt = 0;
+  _etag[0] = '\0';
+  _lastModified[0] = '\0';
+}
+
+// FNV-1a, so the cache can be tied to a URL (and events to their UID)
+// without storing it
+uint32_t ICalEventCache::hash(const char* text) {
+  uint32_t hash = 2166136261u;
+  while (text && *text) {
+    hash ^= (uint8_t)*text++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+void ICalEventCache::begin(const char* url) {
+  clear();
+  _urlHash = hash(url);
+}
+
+bool ICalEventCache::add(const ICalSeries& series, const char* title) {
+  if (_overflow) return false;
+
+  size_t len = title ? strnlen(title, ICAL_MAX_TITLE_LEN - 1) : 0;
+  if (_count >= ICAL_CACHE_MAX_RECORDS || _poolUsed + len + 1 > ICAL_CACHE_POOL_SIZE ||
+      _exdateUsed + series.exdateCount > ICAL_CACHE_MAX_EXDATES) {
+    _overflow = true;
+    return false;
+  }
+
+  Record& r = _records[_count++];
+  r.dtstart = series.dtstart;
+  r.rule = series.rule;
+  r.duration = (int32_t)series.duration;
+  r.uidHash = series.uidHash;
+  r.titleOffset = _poolUsed;
+  if (len > 0) memcpy(_pool + _poolUsed, title, len);
+  _pool[_poolUsed + len] = '\0';
+  _poolUsed += len + 1;
+  r.exdateOffset = _exdateUsed;
+  r.exdateCount = series.exdateCount;
+  if (series.exdateCount > 0) {
+    memcpy(_exdates + _exdateUsed, series.exdates, series.exdateCount * sizeof(time_t));
+  }
+  _exdateUsed += series.exdateCount;
+  return true;
+}
+
+bool ICalEventCache::add(time_t dtstart, time_t duration, const ICalRRule& rule, const char* title) {
+  ICalSeries series = {dtstart, duration, rule, 0, nullptr, 0};
+  return add(series, title);
+}
+
+bool ICalEventCache::addOverride(uint32_t uidHash, time_t start) {
+  if (_overrideCount >= ICAL_MAX_OVERRIDES) return false;
+  _overrides[_overrideCount].uidHash = uidHash;
+  _overrides[_overrideCount].start = start;
+  _overrideCount++;
+  return true;
+}
+
+static bool copyValidator(char* dst, const char* src) {
+  size_t len = src ? strlen(src) : 0;
+  if (len >= ICAL_VALIDATOR_LEN) {
+    dst[0] = '\0';
+    return false;
+  }
+  memcpy(dst, src ? src : "", len + 1);
+  return true;
+}
+
+void ICalEventCache::commit(const char* etag, const char* lastModified, unsigned long fetchedAt) {
+  if (_overflow) {
+    clear();
+    return;
+  }
+  // An oversized validator is dropped; the other one may still be usable
+  copyValidator(_etag, etag);
+  copyValidator(_lastModified, lastModified);
+  _fetchedAt = fetchedAt;
+  _valid = true;
+  _stale = false;
+}
+
+bool ICalEventCache::validFor(const char* url) const {
+  return _valid && _urlHash == hash(url);
+}
+
+bool ICalEventCache::freshFor(const char* url, unsigned long now, unsigned long maxAge) const {
+  return maxAge > 0 && !_stale && validFor(url) && now - _fetchedAt < maxAge;
+}
+
+// Snapshot layout: header, then the validators, records, used pool bytes,
+// EXDATEs and overrides as they are in memory. Only ever read back by the same firmware build
+// family, so host byte order is fine; the version bumps on layout changes.
+#define CACHE_FILE_MAGIC 0x43434349UL  // "ICCC"
+#define CACHE_FILE_VERSION 2
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recordSize;
+  uint32_t urlHash;
+  uint16_t poolUsed;
+  uint8_t count;
+  uint8_t exdateCount;
+  uint8_t overrideCount;
+  uint8_t reserved[3];
+} CacheFileHeader;
+
+bool ICalEventCache::save(Print& out) const {
+  if (!_valid) return false;
+
+  CacheFileHeader header = {CACHE_FILE_MAGIC, CACHE_FILE_VERSION, (uint16_t)sizeof(Record),
+                            _urlHash, _poolUsed, _count, _exdateUsed, _overrideCount, {0, 0, 0}};
+  size_t recordBytes = _count * sizeof(Record);
+  size_t exdateBytes = _exdateUsed * sizeof(time_t);
+  size_t overrideBytes = _overrideCount * sizeof(ICalOverride);
+  return out.write((const uint8_t*)&header, sizeof(header)) == sizeof(header) &&
+         out.write((const uint8_t*)_etag, sizeof(_etag)) == sizeof(_etag) &&
+         out.write((const uint8_t*)_lastModified, sizeof(_lastModified)) == sizeof(_lastModified) &&
+         out.write((const uint8_t*)_records, recordBytes) == recordBytes &&
+         out.write((const uint8_t*)_pool, _poolUsed) == _poolUsed &&
+         out.write((const uint8_t*)_exdates, exdateBytes) == exdateBytes &&
+         out.write((const uint8_t*)_overrides, overrideBytes) == overrideBytes;
+}
+
+bool ICalEventCache::load(Stream& in) {
+  clear();
+
+  CacheFileHeader header;
+  if (in.readBytes((char*)&header, sizeof(header)) != sizeof(header) ||
+      header.magic != CACHE_FILE_MAGIC || header.version != CACHE_FILE_VERSION ||
+      header.recordSize != sizeof(Record) || header.count > ICAL_CACHE_MAX_RECORDS ||
+      header.poolUsed > ICAL_CACHE_POOL_SIZE || header.exdateCount > ICAL_CACHE_MAX_EXDATES ||
+      header.overrideCount > ICAL_MAX_OVERRIDES) {
+    return false;
+  }
+
+  size_t recordBytes = header.count * sizeof(Record);
+  size_t exdateBytes = header.exdateCount * sizeof(time_t);
+  size_t overrideBytes = header.overrideCount * sizeof(ICalOverride);
+  if (in.readBytes(_etag, sizeof(_etag)) != sizeof(_etag) ||
+      in.readBytes(_lastModified, sizeof(_lastModified)) != sizeof(_lastModified) ||
+      in.readBytes((char*)_records, recordBytes) != recordBytes ||
+      in.readBytes(_pool, header.poolUsed) != header.poolUsed ||
+      in.readBytes((char*)_exdates, exdateBytes) != exdateBytes ||
+      in.readBytes((char*)_overrides, overrideBytes) != overrideBytes) {
+    clear();
+    return false;
+  }
+
+  // Reject anything that would let a title or validator run off its buffer
+  _etag[ICAL_VALIDATOR_LEN - 1] = '\0';
+  _lastModified[ICAL_VALIDATOR_LEN - 1] = '\0';
+  if (header.count > 0 && (header.poolUsed == 0 || _pool[header.poolUsed - 1] != '\0')) {
+    clear();
+    return false;
+  }
+  for (int i = 0; i < header.count; i++) {
+    if (_records[i].titleOffset >= header.poolUsed ||
+        _records[i].exdateOffset + _records[i].exdateCount > header.exdateCount) {
+      clear();
+      return false;
+    }
+  }
+
+  _urlHash = header.urlHash;
+  _poolUsed = header.poolUsed;
+  _count = header.count;
+  _exdateUsed = header.exdateCount;
+  _overrideCount = header.overrideCount;
+  _valid = true;
+  _stale = true;
+  return true;
+}
+
+void ICalEventCache::expand(time_t now, ICalTopK* top, time_t horizon) const {
+  for (int i = 0; i < _count; i++) {
+    const Record& r = _records[i];
+    ICalSeries series = {r.dtstart, r.duration, r.rule, r.uidHash, _exdates + r.exdateOffset, r.exdateCount};
+    ICalParser::offerOccurrences(series, _pool + r.titleOffset, now, horizon, _overrides, _overrideCount, top);
+  }
+}
@@ -0,0 +1,258 @@
+/*
+ * ICalParser - configuration and the streaming feed parser
+ *
+ * Nothing here touches the network: parseStream() reads whatever WiFiClient
+ * it is given, so the host build can feed it .ics files from disk. Lines go
+ * to an ICalFeedReader.
+ */
+
+#include "ICalParser.h"
+#include <stdarg.h>
+
+ICalParser::ICalParser()
+    : _debugCallback(nullptr), _parseTimeout(30000), _dataTimeout(5000),
+      _horizon(ICAL_DEFAULT_HORIZON), _cache(nullptr), _cacheMaxAge(0), _tlsSession(nullptr) {}
+
+void ICalParser::setDebugCallback(ICalDebugCallback callback) {
+  _debugCallback = callback;
+}
+
+void ICalParser::setParseTimeout(unsigned long timeout) {
+  _parseTimeout = timeout;
+}
+
+void ICalParser::setDataTimeout(unsigned long timeout) {
+  _dataTimeout = timeout;
+}
+
+void ICalParser::setHorizon(time_t horizon) {
+  _horizon = horizon;
+}
+
+void ICalParser::setCache(ICalEventCache* cache, unsigned long maxAge) {
+  _cache = cache;
+  _cacheMaxAge = maxAge;
+}
+
+void ICalParser::setTlsSession(BearSSL::Session* session) {
+  _tlsSession = session;
+}
+
+void ICalParser::debug(const char* msg) {
+  if (_debugCallback) {
+    _debugCallback(msg);
+  }
+}
+
+void ICalParser::debugf(const char* fmt, ...) {
+  if (_debugCallback) {
+    char buf[128];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    _debugCallback(buf);
+  }
+}
+
+bool ICalParser::parseStream(WiFiClient& stream, time_t now, ICalTopK* events, ICalResult* result) {
+  _reader.begin(now, _horizon, events, _cache);
+  int lineLen = 0;
+
+  debugf("Parsing calendar (next %d events)...", events->capacity());
+  char nowStr[ICAL_DATETIME_LEN];
+  formatDateTime(now, nowStr, sizeof(nowStr));
+  debugf("Current: %s", nowStr);
+
+  unsigned long parseStart = millis();
+  unsigned long lastData = millis();
+  int lineCount = 0;
+
+  while (millis() - parseStart < _parseTimeout) {
+    if (stream.available()) {
+      lastData = millis();
+      char c = stream.read();
+
+      if (c == '\n') {
+        // A fixed buffer rather than a String: no heap churn per line
+        while (lineLen > 0 && (_line[lineLen - 1] == ' ' || _line[lineLen - 1] == '\t')) lineLen--;
+        _line[lineLen] = '\0';
+        lineCount++;
+        _reader.line(_line);
+        lineLen = 0;
+        yield();  // Prevent watchdog timeout
+      } else if (c != '\r') {
+        if (lineLen < ICAL_MAX_LINE_LEN) {
+          _line[lineLen++] = c;
+        }
+      }
+    } else {
+      // No data available
+      if (millis() - lastData > _dataTimeout) {
+        debug("Data timeout, stopping parse");
+        break;
+      }
+      if (!stream.connected()) {
+        debug("Connection closed");
+        break;
+      }
+      yield();
+      delay(1);
+    }
+  }
+
+  _reader.finish();
+  result->totalEventsParsed = _reader.eventsSeen();
+  result->recurringEventsParsed = _reader.recurringSeen();
+  result->complete = _reader.complete();
+  debugf("Parsed %d lines, %d events (%d recurring)",
+         lineCount, result->totalEventsParsed, result->recurringEventsParsed);
+  return result->complete;
+}
+
+// Feed reader
+
+ICalFeedReader::ICalFeedReader() {
+  begin(0, 0, nullptr, nullptr);
+}
+
+void ICalFeedReader::begin(time_t now, time_t horizon, ICalTopK* top, ICalEventCache* cache) {
+  _now = now;
+  _horizon = horizon;
+  _top = top;
+  _cache = cache;
+  _inEvent = false;
+  _overrideCount = 0;
+  _complete = false;
+  _eventsSeen = 0;
+  _recurringSeen = 0;
+}
+
+void ICalFeedReader::startEvent() {
+  _inEvent = true;
+  _dtstart[0] = '\0';
+  _dtend[0] = '\0';
+  _summary[0] = '\0';
+  _rrule[0] = '\0';
+  _exdateCount = 0;
+  _recurrenceId = 0;
+  _uidHash = 0;
+  _nested = 0;
+  _cancelled = false;
+  _override = false;
+}
+
+// Copy a property value (after the first ':') into a fixed buffer
+static void copyValue(char* out, size_t outSize, const char* text) {
+  const char* colon = strchr(text, ':');
+  const char* value = colon ? colon + 1 : "";
+  strncpy(out, value, outSize - 1);
+  out[outSize - 1] = '\0';
+}
+
+// EXDATE may list several instances, and may appear more than once
+void ICalFeedReader::addExdates(const char* value) {
+  while (value && *value && _exdateCount < ICAL_MAX_EXDATES) {
+    time_t t = ICalParser::parseDate(value);
+    if (t != 0) _exdates[_exdateCount++] = t;
+    value = strchr(value, ',');
+    if (value) value++;
+  }
+}
+
+void ICalFeedReader::line(const char* text) {
+  if (strcmp(text, "END:VCALENDAR") == 0) {
+    _complete = true;
+    return;
+  }
+  if (!_inEvent) {
+    if (strcmp(text, "BEGIN:VEVENT") == 0) {
+      startEvent();
+    }
+    return;
+  }
+
+  if (strcmp(text, "END:VEVENT") == 0) {
+    _inEvent = false;
+    endEvent();
+    return;
+  }
+
+  // Properties of a VALARM inside the event are not the event's
+  if (strncmp(text, "BEGIN:", 6) == 0) {
+    _nested++;
+    return;
+  }
+  if (strncmp(text, "END:", 4) == 0) {
+    if (_nested > 0) _nested--;
+    return;
+  }
+  if (_nested > 0) return;
+
+  if (strncmp(text, "DTSTART", 7) == 0) {
+    copyValue(_dtstart, sizeof(_dtstart), text);
+  } else if (strncmp(text, "DTEND", 5) == 0) {
+    copyValue(_dtend, sizeof(_dtend), text);
+  } else if (strncmp(text, "SUMMARY:", 8) == 0) {
+    strncpy(_summary, text + 8, sizeof(_summary) - 1);
+    _summary[sizeof(_summary) - 1] = '\0';
+  } else if (strncmp(text, "RRULE:", 6) == 0) {
+    strncpy(_rrule, text + 6, sizeof(_rrule) - 1);
+    _rrule[sizeof(_rrule) - 1] = '\0';
+  } else if (strncmp(text, "STATUS:", 7) == 0) {
+    if (strstr(text, "CANCELLED") != nullptr) {
+      _cancelled = true;
+    }
+  } else if (strncmp(text, "UID:", 4) == 0) {
+    _uidHash = ICalEventCache::hash(text + 4);
+  } else if (strncmp(text, "EXDATE", 6) == 0) {
+    const char* colon = strchr(text, ':');
+    if (colon) addExdates(colon + 1);
+  } else if (strncmp(text, "RECURRENCE-ID", 13) == 0) {
+    const char* colon = strchr(text, ':');
+    _recurrenceId = colon ? ICalParser::parseDate(colon + 1) : 0;
+    _override = true;
+  }
+}
+
+void ICalFeedReader::endEvent() {
+  _eventsSeen++;
+
+  // An override replaces one instance of the event with the same UID; a
+  // cancelled override just removes it
+  if (_override && _uidHash != 0 && _recurrenceId != 0 && _overrideCount < ICAL_MAX_OVERRIDES) {
+    _overrides[_overrideCount].uidHash = _uidHash;
+    _overrides[_overrideCount].start = _recurrenceId;
+    _overrideCount++;
+  }
+
+  if (_cancelled || _dtstart[0] == '\0' || _summary[0] == '\0') return;
+
+  ICalSeries series;
+  series.dtstart = ICalParser::parseDate(_dtstart);
+  time_t dtend = (_dtend[0] != '\0') ? ICalParser::parseDate(_dtend) : series.dtstart;
+  series.duration = dtend - series.dtstart;
+  // The override is a one-off at its own DTSTART
+  series.rule = ICalParser::parseRRule(_override ? "" : _rrule);
+  series.uidHash = _override ? 0 : _uidHash;
+  series.exdates = _exdates;
+  series.exdateCount = _override ? 0 : _exdateCount;
+
+  if (series.rule.freq != ICAL_FREQ_NONE) {
+    _recurringSeen++;
+  }
+
+  // Events with nothing left to show are neither listed nor cached
+  if (ICalParser::getNextOccurrence(series.dtstart, series.rule, _now) == 0) return;
+
+  if (_cache && _cache->add(series, _summary)) return;  // Expanded in finish()
+  ICalParser::offerOccurrences(series, _summary, _now, _horizon, _overrides, _overrideCount, _top);
+}
+
+void ICalFeedReader::finish() {
+  if (!_cache) return;
+  for (int i = 0; i < _overrideCount; i++) {
+    _cache->addOverride(_overrides[i].uidHash, _overrides[i].start);
+  }
+  _cache->expand(_now, _top, _horizon);
+}
@@ -7,10 +7,46 @@
 #include <WiFiClientSecure.h>
 #include <time.h>
 
-// Maximum events that can be returned (reduced to save memory)
-#define ICAL_MAX_EVENTS 12
+// Largest upcoming-event list (ICalTopKN<K>) the library is tested with.
+// Each list is sized by its own K: an event costs a 32-byte key and record
+// plus room for one full-length title, 96 bytes against 120 for an
+// ICalEvent, so ICalTopKN<4> is ~0.4 KB and ICalTopKN<24> ~2.3 KB.
+#define ICAL_MAX_EVENTS 24
 #define ICAL_MAX_TITLE_LEN 64
 
+// Length of a formatted "YYYY-MM-DD HH:MM" string including terminator
+#define ICAL_DATETIME_LEN 17
+
+// Longest feed line kept by parseStream(); the rest of a line is dropped
+#define ICAL_MAX_LINE_LEN 256
+
+// Event cache limits. A feed with more still-recurring events than this is
+// simply not cached and is fetched in full every time. Each record is ~48
+// bytes; builds that keep a cache per feed can lower them (build_flags).
+#ifndef ICAL_CACHE_MAX_RECORDS
+#define ICAL_CACHE_MAX_RECORDS 64
+#endif
+#ifndef ICAL_CACHE_POOL_SIZE
+#define ICAL_CACHE_POOL_SIZE 1536
+#endif
+#ifndef ICAL_CACHE_MAX_EXDATES
+#define ICAL_CACHE_MAX_EXDATES 64
+#endif
+#define ICAL_VALIDATOR_LEN 80   // ETag / Last-Modified, including terminator
+
+// Recurrence exceptions: EXDATE values kept per event, and RECURRENCE-ID
+// overrides tracked per feed. Exceptions beyond these are ignored, so the
+// original instance shows up as well.
+#define ICAL_MAX_EXDATES 16
+#define ICAL_MAX_OVERRIDES 32
+
+// Recurring events contribute every instance starting this soon, not just
+// the next one (seconds; see ICalParser::setHorizon)
+#define ICAL_DEFAULT_HORIZON (7 * 86400L)
+
+// Feeds that can be merged into one upcoming-event list (see ICalMerge)
+#define ICAL_MAX_FEEDS 3
+
 // RRULE frequency types
 typedef enum {
   ICAL_FREQ_NONE = 0,
@@ -29,6 +65,42 @@ typedef struct {
   uint8_t byDay;     // Bitmask: bit 0=SU, 1=MO, 2=TU, 3=WE, 4=TH, 5=FR, 6=SA
 } ICalRRule;
 
+// A recurring event's instance replaced by a RECURRENCE-ID override (moved,
+// edited or cancelled), identified by the event's UID hash and its original
+// start time
+typedef struct {
+  uint32_t uidHash;
+  time_t start;
+} ICalOverride;
+
+// One event as needed to list its occurrences
+typedef struct {
+  time_t dtstart;
+  time_t duration;
+  ICalRRule rule;
+  uint32_t uidHash;        // 0 if the event had no UID
+  const time_t* exdates;   // Instances removed by EXDATE
+  uint8_t exdateCount;
+} ICalSeries;
+
+// Lazily yields the occurrences of a rule in ascending order. Each step is
+// computed directly from dtstart, so the cost is per instance produced, not
+// per period elapsed since dtstart.
+class ICalOccurrences {
+public:
+  // Start with the first occurrence at or after from
+  void begin(time_t dtstart, const ICalRRule& rule, time_t from);
+
+  // Next occurrence, or 0 once the rule is exhausted (COUNT / UNTIL)
+  time_t next();
+
+private:
+  time_t _dtstart;
+  ICalRRule _rule;
+  time_t _from;
+  bool _done;
+};
+
 // Calendar event
 typedef struct {
   time_t occurrence;       // When this event starts
@@ -38,15 +110,269 @@ typedef struct {
   char title[ICAL_MAX_TITLE_LEN];
 } ICalEvent;
 
-// Parser result
+// Selects the K earliest occurrences from a stream of candidates.
+// A max-heap of (occurrence, slot) keys holds the current top K, so each
+// candidate costs O(log K) and rejected ones cost a single compare. Event
+// records never move; titles live in a compact string pool.
+//
+// The storage belongs to ICalTopKN<K>, which is what callers declare;
+// everything that reads or fills a list takes an ICalTopK.
+class ICalTopK {
+public:
+  ICalTopK(const ICalTopK&) = delete;
+  ICalTopK& operator=(const ICalTopK&) = delete;
+
+  // Reset and keep at most k events (clamped to 1..maxCapacity())
+  void begin(int k);
+
+  // Offer a candidate; returns false if it did not make the current top K.
+  // Ties keep the earlier candidate, as the old sorted insertion did.
+  bool offer(time_t occurrence, time_t endOccurrence, const char* title);
+
+  // Sort the kept events by start time; call once after the last offer()
+  void finish();
+
+  int count() const { return _count; }
+  int capacity() const { return _k; }
+  int maxCapacity() const { return _maxK; }
+
+  // Accessors for the i-th event in start order (valid after finish())
+  time_t occurrence(int i) const { return _keys[i].occurrence; }
+  time_t endOccurrence(int i) const { return _records[_keys[i].slot].endOccurrence; }
+  const char* title(int i) const {
+    const Record& r = _records[_keys[i].slot];
+    return r.titleLen ? _pool + r.titleOffset : "";
+  }
+
+  // Fill an ICalEvent, formatting its datetimes (valid after finish())
+  void getEvent(int i, ICalEvent* out) const;
+
+protected:
+  typedef struct {
+    time_t occurrence;
+    uint8_t slot;
+  } Key;
+
+  typedef struct {
+    time_t endOccurrence;
+    uint32_t seq;          // Arrival order, breaks occurrence ties
+    uint16_t titleOffset;
+    uint8_t titleLen;      // Excluding terminator
+  } Record;
+
+  // Storage is the derived class's; it calls begin() once it exists
+  ICalTopK(Key* keys, Record* records, uint8_t maxK, char* pool, uint16_t poolSize)
+      : _keys(keys), _records(records), _pool(pool), _poolSize(poolSize), _maxK(maxK) {}
+
+private:
+  Key* _keys;
+  Record* _records;
+  char* _pool;
+  uint16_t _poolSize;
+  uint16_t _poolUsed;
+  uint32_t _seq;
+  uint8_t _maxK;
+  uint8_t _k;
+  uint8_t _count;
+
+  bool keyLess(const Key& a, const Key& b) const;
+  void siftUp(int i);
+  void siftDown(int i, int n);
+  void storeTitle(uint8_t slot, const char* title);
+  void compactPool();
+};
+
+// An ICalTopK that can keep up to K events
+template <int K>
+class ICalTopKN : public ICalTopK {
+  static_assert(K >= 1 && K <= 255, "slots are bytes");
+  static_assert(K * ICAL_MAX_TITLE_LEN <= 65535, "pool offsets are 16-bit");
+
+public:
+  ICalTopKN() : ICalTopK(_keyStore, _recordStore, K, _poolStore, sizeof(_poolStore)) { begin(K); }
+
+private:
+  Key _keyStore[K];
+  Record _recordStore[K];
+  char _poolStore[K * ICAL_MAX_TITLE_LEN];  // K full-length titles, never truncated
+};
+
+// Streams the events of several finished ICalTopK lists (one per feed) in
+// start order, without copying them. Each list is already sorted, so the
+// next event is the earliest of the list heads; with at most ICAL_MAX_FEEDS
+// heads a linear scan beats keeping them in a heap.
+class ICalMerge {
+public:
+  // Lists beyond ICAL_MAX_FEEDS are ignored; nullptr entries are skipped
+  void begin(const ICalTopK* const* lists, int count);
+
+  // Total events left to stream
+  int remaining() const;
+
+  // Next event in start order; false once every list is exhausted. Equal
+  // starts come from the earlier list first.
+  bool next(const ICalTopK** list, int* index);
+
+private:
+  const ICalTopK* _lists[ICAL_MAX_FEEDS];
+  uint8_t _pos[ICAL_MAX_FEEDS];
+  uint8_t _count;
+};
+
+// Compact copy of a feed's events that can still occur, plus the HTTP
+// validators (ETag / Last-Modified) of the response they came from.
+// Lets a caller revalidate with If-None-Match / If-Modified-Since and, on
+// 304 or while the cache is fresh, re-expand recurrences for a new "now"
+// without downloading or parsing the feed again.
+class ICalEventCache {
+public:
+  ICalEventCache();
+
+  // Drop everything (next fetch is unconditional)
+  void clear();
+
+  // Start refilling from a fresh 200 response for url
+  void begin(const char* url);
+
+  // Record an event seen while parsing; returns false once the cache is full
+  bool add(const ICalSeries& series, const char* title);
+  bool add(time_t dtstart, time_t duration, const ICalRRule& rule, const char* title);
+
+  // Record a RECURRENCE-ID override; returns false if the table is full
+  bool addOverride(uint32_t uidHash, time_t start);
+
+  // Finish a complete parse; the cache is only usable after this succeeds.
+  // fetchedAt is the caller's clock (millis()) for freshness checks.
+  void commit(const char* etag, const char* lastModified, unsigned long fetchedAt);
+
+  // Mark a successful revalidation (304) at the caller's clock
+  void touch(unsigned long fetchedAt) {
+    _fetchedAt = fetchedAt;
+    _stale = false;
+  }
+
+  // True if the cache holds a complete event list for url
+  bool validFor(const char* url) const;
+
+  // True if validFor(url) and it was fetched or revalidated within maxAge
+  bool freshFor(const char* url, unsigned long now, unsigned long maxAge) const;
+
+  // True after load() until the feed is fetched or revalidated again
+  bool stale() const { return _stale; }
+
+  // Persist / restore a committed cache (e.g. a LittleFS File). A restored
+  // cache is stale: usable for expansion and revalidation, never fresh.
+  bool save(Print& out) const;
+  bool load(Stream& in);
+
+  const char* etag() const { return _etag; }
+  const char* lastModified() const { return _lastModified; }
+  int count() const { return _count; }
+
+  // Offer every cached event's occurrences to top: those starting within
+  // horizon seconds of now, and at least the next one. Records added since
+  // begin() are included, so a parser can defer expansion until it has seen
+  // every override in the feed.
+  void expand(time_t now, ICalTopK* top, time_t horizon = 0) const;
+
+  // FNV-1a of a string (feed URLs, event UIDs)
+  static uint32_t hash(const char* text);
+
+private:
+  typedef struct {
+    time_t dtstart;
+    ICalRRule rule;
+    int32_t duration;
+    uint32_t uidHash;
+    uint16_t titleOffset;
+    uint8_t exdateOffset;
+    uint8_t exdateCount;
+  } Record;
+
+  Record _records[ICAL_CACHE_MAX_RECORDS];
+  char _pool[ICAL_CACHE_POOL_SIZE];
+  time_t _exdates[ICAL_CACHE_MAX_EXDATES];
+  ICalOverride _overrides[ICAL_MAX_OVERRIDES];
+  char _etag[ICAL_VALIDATOR_LEN];
+  char _lastModified[ICAL_VALIDATOR_LEN];
+  uint32_t _urlHash;
+  unsigned long _fetchedAt;
+  uint16_t _poolUsed;
+  uint8_t _count;
+  uint8_t _exdateUsed;
+  uint8_t _overrideCount;
+  bool _overflow;
+  bool _valid;
+  bool _stale;
+};
+
+// Reads an iCalendar feed one line at a time (CR/LF and trailing blanks
+// removed) and offers the occurrences of its events to a top-K selection.
+// EXDATEs and RECURRENCE-ID overrides are honoured; the overridden instance
+// itself is listed as a one-off event.
+//
+// Overrides may come before or after their recurring event in the feed, so
+// with a cache every event is only recorded while reading and all of them
+// are expanded in finish(). Without a cache (or once it is full) events are
+// expanded as they are read, and only overrides seen earlier apply to them.
+class ICalFeedReader {
+public:
+  ICalFeedReader();
+
+  // Start a feed: occurrences in [now, now + horizon] go to top (started by
+  // the caller), events to cache if set (cache->begin() is the caller's)
+  void begin(time_t now, time_t horizon, ICalTopK* top, ICalEventCache* cache);
+
+  void line(const char* text);
+
+  // Expand deferred events; call once after the last line
+  void finish();
+
+  // True once END:VCALENDAR was read
+  bool complete() const { return _complete; }
+  int eventsSeen() const { return _eventsSeen; }
+  int recurringSeen() const { return _recurringSeen; }
+
+private:
+  time_t _now;
+  time_t _horizon;
+  ICalTopK* _top;
+  ICalEventCache* _cache;
+
+  // Current VEVENT
+  char _dtstart[32];
+  char _dtend[32];
+  char _summary[ICAL_MAX_TITLE_LEN];
+  char _rrule[128];
+  time_t _exdates[ICAL_MAX_EXDATES];
+  time_t _recurrenceId;
+  uint32_t _uidHash;
+  uint8_t _exdateCount;
+  uint8_t _nested;  // Depth of components inside it (VALARM)
+  bool _inEvent;
+  bool _cancelled;
+  bool _override;  // Has a RECURRENCE-ID
+
+  ICalOverride _overrides[ICAL_MAX_OVERRIDES];
+  uint8_t _overrideCount;
+  bool _complete;
+  int _eventsSeen;
+  int _recurringSeen;
+
+  void startEvent();
+  void endEvent();
+  void addExdates(const char* value);
+};
+
+// Parser result. The events themselves go to the caller's ICalTopK.
 typedef struct {
-  ICalEvent events[ICAL_MAX_EVENTS];
-  int eventCount;
   int totalEventsParsed;
   int recurringEventsParsed;
   bool success;
-  int httpCode;
-  const char* errorMsg;
+  bool complete;      // The whole feed was read (END:VCALENDAR)
+  int httpCode;       // 0 if no request was made
+  bool fromCache;     // Events were re-expanded from the cache (no download)
+  const char* errorMsg;  // URL_NOT_SET, NO_WIFI, HTTP_BEGIN_FAILED or HTTP_ERROR
 } ICalResult;
 
 // Debug callback type
@@ -65,30 +391,64 @@ public:
   // Set data timeout in milliseconds (default 5000)
   void setDataTimeout(unsigned long timeout);
 
-  // Fetch and parse calendar, returning up to maxEvents upcoming events
+  // List every instance of a recurring event starting within this many
+  // seconds, not just the next one (default ICAL_DEFAULT_HORIZON, 0 = next)
+  void setHorizon(time_t horizon);
+
+  // Use cache for conditional requests. Within maxAge ms of the last
+  // fetch the network is skipped entirely (0 = always revalidate).
+  void setCache(ICalEventCache* cache, unsigned long maxAge = 0);
+
+  // Keep TLS session state here between fetches so reconnects to the same
+  // host use an abbreviated handshake (caller owns it, one per host)
+  void setTlsSession(BearSSL::Session* session);
+
+  // Fetch and parse calendar, offering its upcoming occurrences to events.
+  // The caller begin()s events with the number it wants and finish()es it
+  // afterwards, so on failure it can still fill the list some other way.
+  // With a cache the network is skipped while it is fresh, a 304 re-expands
+  // it, and a complete download refills it (an incomplete one clears it).
   // currentTime: epoch time for "now" (use NTPClient.getEpochTime())
-  // Returns result structure with events and status
-  ICalResult fetch(const char* url, time_t currentTime, int maxEvents = 10);
+  ICalResult fetch(const char* url, time_t currentTime, ICalTopK* events);
+
+  // Parse a feed body as it arrives on stream, offering each event's
+  // occurrences after currentTime to events (started by the caller) and
+  // recording it in the cache if one is set. Stops at the parse or data
+  // timeout or when the connection closes; returns true if END:VCALENDAR
+  // was read. fetch() uses this on the HTTP response stream.
+  bool parseStream(WiFiClient& stream, time_t currentTime, ICalTopK* events, ICalResult* result);
 
   // Parse iCal date string (YYYYMMDD or YYYYMMDDTHHMMSS or YYYYMMDDTHHMMSSZ)
   static time_t parseDate(const char* dateStr);
 
+  // Format epoch as "YYYY-MM-DD HH:MM" (outSize >= ICAL_DATETIME_LEN)
+  static void formatDateTime(time_t t, char* out, size_t outSize);
+
   // Parse RRULE string
   static ICalRRule parseRRule(const char* rruleStr);
 
   // Calculate next occurrence of recurring event after 'after' time
   static time_t getNextOccurrence(time_t dtstart, ICalRRule rule, time_t after);
 
+  // Offer series' occurrences starting in [now, now + horizon] to top, or
+  // at least its first one at or after now, skipping EXDATEs and overridden
+  // instances. Stops as soon as top rejects one. Returns the number offered.
+  static int offerOccurrences(const ICalSeries& series, const char* title, time_t now, time_t horizon,
+                              const ICalOverride* overrides, int overrideCount, ICalTopK* top);
+
 private:
   ICalDebugCallback _debugCallback;
   unsigned long _parseTimeout;
   unsigned long _dataTimeout;
+  time_t _horizon;
+  ICalEventCache* _cache;
+  unsigned long _cacheMaxAge;
+  BearSSL::Session* _tlsSession;
+  ICalFeedReader _reader;
+  char _line[ICAL_MAX_LINE_LEN + 1];
 
   void debug(const char* msg);
   void debugf(const char* fmt, ...);
-
-  void insertSortedEvent(ICalEvent* events, int* count, int maxEvents,
-                         time_t occurrence, time_t endOccurrence, const char* title);
 };
 
 #endif // ICAL_PARSER_H
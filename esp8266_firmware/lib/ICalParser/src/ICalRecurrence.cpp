@@ -0,0 +1,361 @@
+/*
+ * ICalParser - date, RRULE and recurrence arithmetic
+ *
+ * Everything in this file is pure computation with no network or Arduino
+ * runtime dependencies, so it can also be built and tested on the host.
+ *
+ * The ESP8266 runs with TZ unset, so mktime()/localtime() treat struct tm as
+ * UTC and every time_t handled here is "local wall clock seconds". Plain day
+ * arithmetic on those values therefore matches what mktime() would produce.
+ */
+
+#include "ICalParser.h"
+
+#define SECS_PER_DAY 86400L
+
+// Floor division for possibly negative epoch values
+static int64_t floorDiv(int64_t a, int64_t b) {
+  int64_t q = a / b;
+  if ((a % b != 0) && ((a < 0) != (b < 0))) q--;
+  return q;
+}
+
+// Ceiling division for a non-negative numerator
+static int64_t ceilDiv(int64_t a, int64_t b) {
+  return (a + b - 1) / b;
+}
+
+static bool isLeapYear(int64_t year) {
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static int daysInMonth(int64_t year, int month) {
+  static const uint8_t days[] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  if (month == 2 && isLeapYear(year)) return 29;
+  return days[month];
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date (month 1-12)
+static int64_t daysFromCivil(int64_t year, int month, int day) {
+  year -= (month <= 2) ? 1 : 0;
+  int64_t era = floorDiv(year, 400);
+  int64_t yoe = year - era * 400;
+  int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+// Inverse of daysFromCivil
+static void civilFromDays(int64_t days, int64_t* year, int* month, int* day) {
+  days += 719468;
+  int64_t era = floorDiv(days, 146097);
+  int64_t doe = days - era * 146097;
+  int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int64_t mp = (5 * doy + 2) / 153;
+  *day = (int)(doy - (153 * mp + 2) / 5 + 1);
+  *month = (int)(mp < 10 ? mp + 3 : mp - 9);
+  *year = yoe + era * 400 + (*month <= 2 ? 1 : 0);
+}
+
+// Epoch seconds for a month index (year * 12 + month - 1), day and time of day
+static int64_t monthIndexToEpoch(int64_t monthIndex, int day, int64_t timeOfDay) {
+  int64_t year = floorDiv(monthIndex, 12);
+  int month = (int)(monthIndex - year * 12) + 1;
+  return daysFromCivil(year, month, day) * SECS_PER_DAY + timeOfDay;
+}
+
+// Number of day offsets in [1, days] whose weekday is set in byDay
+static int64_t countByDayMatches(uint8_t byDay, int startWday, int64_t days) {
+  int perWeek = 0;
+  for (int i = 0; i < 7; i++) {
+    perWeek += (byDay >> i) & 1;
+  }
+  int64_t matches = (days / 7) * perWeek;
+  for (int64_t j = 1; j <= days % 7; j++) {
+    matches += (byDay >> ((startWday + j) % 7)) & 1;
+  }
+  return matches;
+}
+
+// Parse exactly 'width' decimal digits, or return -1. Stops at the first
+// non-digit, so it never reads past a string's terminator.
+static int parseDigits(const char* str, int width) {
+  int value = 0;
+  for (int i = 0; i < width; i++) {
+    char c = str[i];
+    if (c < '0' || c > '9') return -1;
+    value = value * 10 + (c - '0');
+  }
+  return value;
+}
+
+// Day of week for a day count from daysFromCivil (0=Sunday)
+static int weekdayFromDays(int64_t days) {
+  return (int)(((days % 7) + 7 + 4) % 7);  // 1970-01-01 was a Thursday
+}
+
+// US Eastern DST for a UTC date/time: from 2nd Sunday of March 07:00 UTC
+// to 1st Sunday of November 06:00 UTC
+static bool isEasternDst(int year, int month, int day, int hour) {
+  if (month > 3 && month < 11) return true;
+  if (month == 3) {
+    int firstSunday = 1 + (7 - weekdayFromDays(daysFromCivil(year, 3, 1))) % 7;
+    int secondSunday = firstSunday + 7;
+    return (day > secondSunday) || (day == secondSunday && hour >= 7);
+  }
+  if (month == 11) {
+    int firstSunday = 1 + (7 - weekdayFromDays(daysFromCivil(year, 11, 1))) % 7;
+    return (day < firstSunday) || (day == firstSunday && hour < 6);
+  }
+  return false;
+}
+
+time_t ICalParser::parseDate(const char* dateStr) {
+  if (!dateStr) return 0;
+
+  // Fields are fixed width: YYYYMMDD[THHMMSS[Z]]
+  int year = parseDigits(dateStr, 4);
+  if (year < 0) return 0;
+  int month = parseDigits(dateStr + 4, 2);
+  if (month < 1 || month > 12) return 0;
+  int day = parseDigits(dateStr + 6, 2);
+  if (day < 0) return 0;
+
+  int hour = 0, minute = 0, second = 0;
+  bool utc = false;
+  if (dateStr[8] == 'T') {
+    hour = parseDigits(dateStr + 9, 2);
+    minute = (hour >= 0) ? parseDigits(dateStr + 11, 2) : -1;
+    second = (minute >= 0) ? parseDigits(dateStr + 13, 2) : -1;
+    if (second < 0) {
+      hour = minute = second = 0;
+    } else {
+      utc = (dateStr[15] == 'Z');
+    }
+  }
+
+  int64_t epoch = daysFromCivil(year, month, day) * SECS_PER_DAY + hour * 3600L + minute * 60L + second;
+
+  // Convert UTC to Eastern time if 'Z' suffix present
+  if (utc) {
+    epoch += (isEasternDst(year, month, day, hour) ? -4 : -5) * 3600L;  // EDT = UTC-4, EST = UTC-5
+  }
+
+  return (time_t)epoch;
+}
+
+// Write 'value' as exactly 'width' zero-padded digits
+static char* writeDigits(char* out, int64_t value, int width) {
+  for (int i = width - 1; i >= 0; i--) {
+    out[i] = (char)('0' + value % 10);
+    value /= 10;
+  }
+  return out + width;
+}
+
+void ICalParser::formatDateTime(time_t t, char* out, size_t outSize) {
+  if (!out || outSize == 0) return;
+  if (outSize < ICAL_DATETIME_LEN) {
+    out[0] = '\0';
+    return;
+  }
+
+  int64_t days = floorDiv(t, SECS_PER_DAY);
+  int64_t secs = (int64_t)t - days * SECS_PER_DAY;
+  int64_t year;
+  int month, day;
+  civilFromDays(days, &year, &month, &day);
+
+  // "YYYY-MM-DD HH:MM"
+  char* p = writeDigits(out, year, 4);
+  *p++ = '-';
+  p = writeDigits(p, month, 2);
+  *p++ = '-';
+  p = writeDigits(p, day, 2);
+  *p++ = ' ';
+  p = writeDigits(p, secs / 3600, 2);
+  *p++ = ':';
+  p = writeDigits(p, (secs / 60) % 60, 2);
+  *p = '\0';
+}
+
+
+ICalRRule ICalParser::parseRRule(const char* rruleStr) {
+  ICalRRule rule = {ICAL_FREQ_NONE, 1, 0, 0, 0};
+
+  if (!rruleStr || strlen(rruleStr) == 0) {
+    return rule;
+  }
+
+  if (strstr(rruleStr, "FREQ=DAILY"))
+    rule.freq = ICAL_FREQ_DAILY;
+  else if (strstr(rruleStr, "FREQ=WEEKLY"))
+    rule.freq = ICAL_FREQ_WEEKLY;
+  else if (strstr(rruleStr, "FREQ=MONTHLY"))
+    rule.freq = ICAL_FREQ_MONTHLY;
+  else if (strstr(rruleStr, "FREQ=YEARLY"))
+    rule.freq = ICAL_FREQ_YEARLY;
+
+  // Parse INTERVAL
+  const char* intervalPtr = strstr(rruleStr, "INTERVAL=");
+  if (intervalPtr) {
+    rule.interval = atoi(intervalPtr + 9);
+    if (rule.interval < 1) rule.interval = 1;
+  }
+
+  // Parse UNTIL
+  const char* untilPtr = strstr(rruleStr, "UNTIL=");
+  if (untilPtr) {
+    rule.until = parseDate(untilPtr + 6);
+  }
+
+  // Parse COUNT
+  const char* countPtr = strstr(rruleStr, "COUNT=");
+  if (countPtr) {
+    rule.count = atoi(countPtr + 6);
+  }
+
+  // Parse BYDAY for weekly recurrence
+  const char* byDayPtr = strstr(rruleStr, "BYDAY=");
+  if (byDayPtr) {
+    if (strstr(byDayPtr, "SU")) rule.byDay |= (1 << 0);
+    if (strstr(byDayPtr, "MO")) rule.byDay |= (1 << 1);
+    if (strstr(byDayPtr, "TU")) rule.byDay |= (1 << 2);
+    if (strstr(byDayPtr, "WE")) rule.byDay |= (1 << 3);
+    if (strstr(byDayPtr, "TH")) rule.byDay |= (1 << 4);
+    if (strstr(byDayPtr, "FR")) rule.byDay |= (1 << 5);
+    if (strstr(byDayPtr, "SA")) rule.byDay |= (1 << 6);
+  }
+
+  return rule;
+}
+
+// Occurrences are numbered from dtstart (step 0). For each frequency the
+// first step landing at or after 'after' is computed directly instead of
+// walking forward with mktime(), and COUNT/UNTIL are checked once against
+// that step: candidates only grow, so an earlier step can never pass a limit
+// that a later one fails.
+time_t ICalParser::getNextOccurrence(time_t dtstart, ICalRRule rule, time_t after) {
+  if (rule.freq == ICAL_FREQ_NONE) {
+    // Non-recurring: return dtstart if it's in the future
+    return (dtstart >= after) ? dtstart : 0;
+  }
+
+  // Check if recurrence has ended by UNTIL date
+  if (rule.until > 0 && after > rule.until) {
+    return 0;
+  }
+
+  // If first occurrence is already past 'after', return it
+  if (dtstart >= after) {
+    return dtstart;
+  }
+
+  int64_t interval = (rule.interval < 1) ? 1 : rule.interval;
+  int64_t startDay = floorDiv(dtstart, SECS_PER_DAY);
+  int64_t timeOfDay = (int64_t)dtstart - startDay * SECS_PER_DAY;
+  int64_t gap = (int64_t)after - (int64_t)dtstart;  // > 0
+  int64_t step = 0;       // Occurrences after dtstart, up to and including candidate
+  int64_t candidate = 0;
+
+  switch (rule.freq) {
+    case ICAL_FREQ_DAILY:
+    case ICAL_FREQ_WEEKLY:
+      if (rule.freq == ICAL_FREQ_WEEKLY && rule.byDay != 0) {
+        // Weekly with specific days: every day whose weekday is in the mask
+        // counts as an occurrence (INTERVAL is not applied to BYDAY rules)
+        int startWday = weekdayFromDays(startDay);
+        int64_t days = ceilDiv(gap, SECS_PER_DAY);
+        while (!((rule.byDay >> ((startWday + days) % 7)) & 1)) {
+          days++;  // At most 6 extra days
+        }
+        step = countByDayMatches(rule.byDay, startWday, days);
+        candidate = (int64_t)dtstart + days * SECS_PER_DAY;
+      } else {
+        int64_t period = interval * SECS_PER_DAY * ((rule.freq == ICAL_FREQ_WEEKLY) ? 7 : 1);
+        step = ceilDiv(gap, period);
+        candidate = (int64_t)dtstart + step * period;
+      }
+      break;
+
+    case ICAL_FREQ_MONTHLY:
+    case ICAL_FREQ_YEARLY: {
+      int64_t monthsPerStep = (rule.freq == ICAL_FREQ_YEARLY) ? interval * 12 : interval;
+      int64_t startYear;
+      int startMonth, day;
+      civilFromDays(startDay, &startYear, &startMonth, &day);
+      int64_t baseMonth = startYear * 12 + (startMonth - 1);
+
+      // mktime() normalises an overflowing day (Jan 31 + 1 month = Mar 3,
+      // Feb 29 + 1 year = Mar 1) and later steps continue from the normalised
+      // date. Days 29-31 can overflow, so walk those steps in plain integer
+      // arithmetic until either the overflow happens or 'after' is reached.
+      // Once the day is <= 28 it can never overflow again.
+      bool found = false;
+      while (day > 28) {
+        step++;
+        int64_t monthIndex = baseMonth + step * monthsPerStep;
+        int64_t year = floorDiv(monthIndex, 12);
+        int dim = daysInMonth(year, (int)(monthIndex - year * 12) + 1);
+        if (day > dim) {
+          day -= dim;
+          baseMonth++;
+        }
+        candidate = monthIndexToEpoch(baseMonth + step * monthsPerStep, day, timeOfDay);
+        if (candidate >= after) {
+          found = true;
+          break;
+        }
+      }
+
+      if (!found) {
+        // Jump to the step landing in the month of 'after' (or the last one
+        // before it); every earlier step falls in an earlier month.
+        int64_t afterYear;
+        int afterMonth, afterDay;
+        civilFromDays(floorDiv(after, SECS_PER_DAY), &afterYear, &afterMonth, &afterDay);
+        int64_t afterMonthIndex = afterYear * 12 + (afterMonth - 1);
+        int64_t jump = floorDiv(afterMonthIndex - baseMonth, monthsPerStep);
+        if (jump > step) step = jump;
+        if (step < 1) step = 1;
+        candidate = monthIndexToEpoch(baseMonth + step * monthsPerStep, day, timeOfDay);
+        while (candidate < after) {
+          step++;
+          candidate = monthIndexToEpoch(baseMonth + step * monthsPerStep, day, timeOfDay);
+        }
+      }
+      break;
+    }
+
+    default:
+      return 0;
+  }
+
+  // Check COUNT limit - dtstart itself is occurrence number 1
+  if (rule.count > 0 && step + 1 > rule.count) {
+    return 0;
+  }
+
+  // Check UNTIL limit
+  if (rule.until > 0 && candidate > rule.until) {
+    return 0;
+  }
+
+  return (time_t)candidate;
+}
+
+void ICalOccurrences::begin(time_t dtstart, const ICalRRule& rule, time_t from) {
+  _dtstart = dtstart;
+  _rule = rule;
+  _from = from;
+  _done = false;
+}
+
+time_t ICalOccurrences::next() {
+  if (_done) return 0;
+  time_t occurrence = ICalParser::getNextOccurrence(_dtstart, _rule, _from);
+  _done = (occurrence == 0);
+  _from = occurrence + 1;
+  return occurrence;
+}
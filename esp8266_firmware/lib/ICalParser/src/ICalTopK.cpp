@@ -0,0 +1,184 @@
+/*
+ * ICalParser - bounded top-K selection of upcoming events
+ *
+ * Candidates arrive in feed order. Only the K earliest are kept: a max-heap
+ * of small (occurrence, slot) keys has the latest kept event at its root, so
+ * a candidate that starts later is rejected with one compare and an earlier
+ * one replaces the root in O(log K). Event records stay in their slot, and
+ * titles are copied once into a shared pool that is compacted in place when
+ * evicted titles leave it fragmented.
+ */
+
+#include "ICalParser.h"
+
+void ICalTopK::begin(int k) {
+  if (k < 1) k = 1;
+  if (k > _maxK) k = _maxK;
+  _k = (uint8_t)k;
+  _count = 0;
+  _seq = 0;
+  _poolUsed = 0;
+}
+
+bool ICalTopK::keyLess(const Key& a, const Key& b) const {
+  if (a.occurrence != b.occurrence) return a.occurrence < b.occurrence;
+  return _records[a.slot].seq < _records[b.slot].seq;
+}
+
+void ICalTopK::siftUp(int i) {
+  Key key = _keys[i];
+  while (i > 0) {
+    int parent = (i - 1) / 2;
+    if (!keyLess(_keys[parent], key)) break;
+    _keys[i] = _keys[parent];
+    i = parent;
+  }
+  _keys[i] = key;
+}
+
+void ICalTopK::siftDown(int i, int n) {
+  Key key = _keys[i];
+  for (;;) {
+    int child = 2 * i + 1;
+    if (child >= n) break;
+    if (child + 1 < n && keyLess(_keys[child], _keys[child + 1])) child++;
+    if (!keyLess(key, _keys[child])) break;
+    _keys[i] = _keys[child];
+    i = child;
+  }
+  _keys[i] = key;
+}
+
+// Slide live titles down to the start of the pool, preserving their order
+void ICalTopK::compactPool() {
+  uint16_t write = 0;
+  uint16_t scanFrom = write;
+
+  for (;;) {
+    // Next live title at or after scanFrom (K is small, so a linear scan is fine)
+    int next = -1;
+    for (int s = 0; s < _count; s++) {
+      const Record& r = _records[s];
+      if (r.titleLen == 0 || r.titleOffset < scanFrom) continue;
+      if (next < 0 || r.titleOffset < _records[next].titleOffset) next = s;
+    }
+    if (next < 0) break;
+
+    Record& r = _records[next];
+    scanFrom = r.titleOffset + r.titleLen + 1;
+    if (r.titleOffset != write) {
+      memmove(_pool + write, _pool + r.titleOffset, r.titleLen + 1);
+      r.titleOffset = write;
+    }
+    write += r.titleLen + 1;
+  }
+
+  _poolUsed = write;
+}
+
+void ICalTopK::storeTitle(uint8_t slot, const char* title) {
+  Record& r = _records[slot];
+  r.titleOffset = 0;
+  r.titleLen = 0;
+
+  size_t len = title ? strnlen(title, ICAL_MAX_TITLE_LEN - 1) : 0;
+  if (len == 0) return;
+
+  if (_poolUsed + len + 1 > _poolSize) {
+    compactPool();
+  }
+  // ICalTopKN's pool holds K full-length titles, so after compaction this
+  // one always fits; a smaller pool would truncate it
+  size_t room = _poolSize - _poolUsed;
+  if (room < 2) return;
+  if (len + 1 > room) len = room - 1;
+
+  memcpy(_pool + _poolUsed, title, len);
+  _pool[_poolUsed + len] = '\0';
+  r.titleOffset = _poolUsed;
+  r.titleLen = (uint8_t)len;
+  _poolUsed += len + 1;
+}
+
+bool ICalTopK::offer(time_t occurrence, time_t endOccurrence, const char* title) {
+  if (occurrence == 0) return false;
+
+  if (_count < _k) {
+    uint8_t slot = _count;
+    _records[slot].endOccurrence = endOccurrence;
+    _records[slot].seq = _seq++;
+    storeTitle(slot, title);
+    _keys[_count].occurrence = occurrence;
+    _keys[_count].slot = slot;
+    _count++;
+    siftUp(_count - 1);
+    return true;
+  }
+
+  // The candidate arrived last, so on an equal start it ranks after the root
+  if (occurrence >= _keys[0].occurrence) return false;
+
+  // Evict the root; its title space is reclaimed directly if it is the last one
+  uint8_t slot = _keys[0].slot;
+  Record& r = _records[slot];
+  if (r.titleLen > 0 && r.titleOffset + r.titleLen + 1 == _poolUsed) {
+    _poolUsed = r.titleOffset;
+  }
+  r.titleLen = 0;
+
+  r.endOccurrence = endOccurrence;
+  r.seq = _seq++;
+  storeTitle(slot, title);
+  _keys[0].occurrence = occurrence;
+  siftDown(0, _count);
+  return true;
+}
+
+void ICalTopK::finish() {
+  // In-place heapsort: repeatedly move the latest kept event to the end
+  for (int n = _count; n > 1; n--) {
+    Key top = _keys[0];
+    _keys[0] = _keys[n - 1];
+    _keys[n - 1] = top;
+    siftDown(0, n - 1);
+  }
+}
+
+void ICalTopK::getEvent(int i, ICalEvent* out) const {
+  out->occurrence = occurrence(i);
+  out->endOccurrence = endOccurrence(i);
+  ICalParser::formatDateTime(out->occurrence, out->datetime, sizeof(out->datetime));
+  ICalParser::formatDateTime(out->endOccurrence, out->endDatetime, sizeof(out->endDatetime));
+  strncpy(out->title, title(i), ICAL_MAX_TITLE_LEN - 1);
+  out->title[ICAL_MAX_TITLE_LEN - 1] = '\0';
+}
+
+void ICalMerge::begin(const ICalTopK* const* lists, int count) {
+  _count = 0;
+  for (int i = 0; i < count && _count < ICAL_MAX_FEEDS; i++) {
+    if (!lists[i]) continue;
+    _lists[_count] = lists[i];
+    _pos[_count] = 0;
+    _count++;
+  }
+}
+
+int ICalMerge::remaining() const {
+  int total = 0;
+  for (int i = 0; i < _count; i++) {
+    total += _lists[i]->count() - _pos[i];
+  }
+  return total;
+}
+
+bool ICalMerge::next(const ICalTopK** list, int* index) {
+  int best = -1;
+  for (int i = 0; i < _count; i++) {
+    if (_pos[i] >= _lists[i]->count()) continue;
+    if (best < 0 || _lists[i]->occurrence(_pos[i]) < _lists[best]->occurrence(_pos[best])) best = i;
+  }
+  if (best < 0) return false;
+  *list = _lists[best];
+  *index = _pos[best]++;
+  return true;
+}
@@ -0,0 +1,39 @@
+/*
+ * ICalParser - expanding an event's occurrences into a time window
+ *
+ * Instances come from ICalOccurrences in ascending order, so expansion stops
+ * at the first one past the window or the first one the top-K rejects (it is
+ * full and everything later would be rejected too).
+ */
+
+#include "ICalParser.h"
+
+static bool isException(const ICalSeries& series, time_t start, const ICalOverride* overrides,
+                        int overrideCount) {
+  for (int i = 0; i < series.exdateCount; i++) {
+    if (series.exdates[i] == start) return true;
+  }
+  if (series.uidHash != 0) {
+    for (int i = 0; i < overrideCount; i++) {
+      if (overrides[i].uidHash == series.uidHash && overrides[i].start == start) return true;
+    }
+  }
+  return false;
+}
+
+int ICalParser::offerOccurrences(const ICalSeries& series, const char* title, time_t now, time_t horizon,
+                                 const ICalOverride* overrides, int overrideCount, ICalTopK* top) {
+  ICalOccurrences occurrences;
+  occurrences.begin(series.dtstart, series.rule, now);
+  time_t windowEnd = now + horizon;
+  int offered = 0;
+
+  for (time_t start = occurrences.next(); start > 0; start = occurrences.next()) {
+    // The first instance is listed even beyond the window, as a one-off is
+    if (offered > 0 && start > windowEnd) break;
+    if (isException(series, start, overrides, overrideCount)) continue;
+    if (!top->offer(start, start + series.duration, title)) break;
+    offered++;
+  }
+  return offered;
+}
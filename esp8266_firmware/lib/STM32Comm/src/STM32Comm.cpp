@@ -5,21 +5,37 @@
 
 #include "STM32Comm.h"
 #include <stdarg.h>
+#include <math.h>
+
+static_assert((STM32COMM_HASH_SLOTS & (STM32COMM_HASH_SLOTS - 1)) == 0 &&
+                  STM32COMM_HASH_SLOTS >= 2 * STM32COMM_MAX_COMMANDS && STM32COMM_MAX_COMMANDS < 256,
+              "STM32COMM_HASH_SLOTS must be a power of two, at least 2 * STM32COMM_MAX_COMMANDS");
 
 STM32Comm::STM32Comm()
     : _serial(nullptr)
     , _debug(nullptr)
     , _bufferIndex(0)
+    , _bufferOverflow(false)
+    , _txLength(0)
+    , _txOverflow(false)
     , _commandCount(0)
     , _unknownCallback(nullptr)
+    , _logHead(0)
+    , _logTail(0)
+    , _logUsed(0)
+    , _logDropped(0)
+    , _logDroppedReported(0)
 {
     memset(_buffer, 0, sizeof(_buffer));
+    _tx[0] = '\0';
     memset(_commands, 0, sizeof(_commands));
+    memset(_slots, 0, sizeof(_slots));
 }
 
 void STM32Comm::begin(Stream& serial, size_t rxBufferSize) {
     _serial = &serial;
     _bufferIndex = 0;
+    _bufferOverflow = false;
 
 #ifdef ESP8266
     // For ESP8266, we can set RX buffer size if using HardwareSerial
@@ -37,65 +53,105 @@ void STM32Comm::setDebugStream(Stream& debug) {
 }
 
 void STM32Comm::process() {
+    drainLog(false);
     if (!_serial) return;
 
-    while (_serial->available()) {
-        char c = _serial->read();
-
-        if (c == '\n') {
-            // Command complete
+    // Move whatever the driver holds in bulk, then find line ends with memchr
+    char chunk[STM32COMM_RX_CHUNK_SIZE];
+    int available;
+    while ((available = _serial->available()) > 0) {
+        size_t want = (size_t)available < sizeof(chunk) ? (size_t)available : sizeof(chunk);
+        size_t got = _serial->readBytes(chunk, want);
+        if (got == 0) break;
+
+        const char* pos = chunk;
+        const char* end = chunk + got;
+        while (pos < end) {
+            const char* newline = (const char*)memchr(pos, '\n', end - pos);
+            if (!newline) {
+                appendLine(pos, end - pos);
+                break;
+            }
+            appendLine(pos, newline - pos);
             _buffer[_bufferIndex] = '\0';
 
             // Log received command
-            debugLogRx(_buffer);
+            debugLogRx(_buffer, _bufferIndex);
 
             // Process it
-            processCommand(_buffer);
+            processCommand(_buffer, _bufferIndex);
 
             // Reset buffer
             _bufferIndex = 0;
+            _bufferOverflow = false;
             _buffer[0] = '\0';
-        } else if (c != '\r') {
-            // Add to buffer (ignore carriage returns)
-            if (_bufferIndex < STM32COMM_BUFFER_SIZE - 1) {
-                _buffer[_bufferIndex++] = c;
-            }
+            pos = newline + 1;
         }
     }
+
+    drainLog(false);
 }
 
-void STM32Comm::processCommand(const char* cmd) {
-    // Skip empty commands
-    if (cmd[0] == '\0') return;
-
-    // Find the colon (if any) to separate command from params
-    const char* colonPos = strchr(cmd, ':');
-    char commandName[STM32COMM_MAX_CMD_LEN];
-    const char* params = "";
-
-    if (colonPos) {
-        // Copy command name (before colon)
-        size_t cmdLen = colonPos - cmd;
-        if (cmdLen >= STM32COMM_MAX_CMD_LEN) {
-            cmdLen = STM32COMM_MAX_CMD_LEN - 1;
+// Adds part of a line to the command buffer, dropping carriage returns and
+// anything past the buffer size (the line is then processed truncated)
+void STM32Comm::appendLine(const char* data, size_t len) {
+    while (len > 0 && !_bufferOverflow) {
+        const char* cr = (const char*)memchr(data, '\r', len);
+        size_t run = cr ? (size_t)(cr - data) : len;
+        size_t room = STM32COMM_BUFFER_SIZE - 1 - _bufferIndex;
+        if (run > room) {
+            run = room;
+            _bufferOverflow = true;
         }
-        strncpy(commandName, cmd, cmdLen);
-        commandName[cmdLen] = '\0';
-        params = colonPos + 1;
-    } else {
-        // No colon - entire string is command name
-        strncpy(commandName, cmd, STM32COMM_MAX_CMD_LEN - 1);
-        commandName[STM32COMM_MAX_CMD_LEN - 1] = '\0';
+        memcpy(_buffer + _bufferIndex, data, run);
+        _bufferIndex += run;
+        if (!cr) break;
+        len -= (cr - data) + 1;
+        data = cr + 1;
+    }
+}
+
+// FNV-1a over the command name
+uint32_t STM32Comm::hashName(const char* name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
     }
+    return hash;
+}
+
+int STM32Comm::findCommand(const char* name, size_t len, uint32_t hash) const {
+    for (uint8_t probe = 0; probe < STM32COMM_HASH_SLOTS; probe++) {
+        uint8_t slot = _slots[(hash + probe) & (STM32COMM_HASH_SLOTS - 1)];
+        if (slot == 0) return -1;
+        const CommandEntry& entry = _commands[slot - 1];
+        if (entry.hash == hash && entry.length == len && memcmp(entry.command, name, len) == 0) {
+            return slot - 1;
+        }
+    }
+    return -1;
+}
+
+void STM32Comm::processCommand(const char* cmd, size_t len) {
+    // Skip empty commands
+    if (len == 0) return;
+
+    // The name (before the colon, if any) is matched in place
+    const char* colonPos = (const char*)memchr(cmd, ':', len);
+    size_t nameLen = colonPos ? (size_t)(colonPos - cmd) : len;
+    const char* params = colonPos ? colonPos + 1 : "";
 
     // Look for registered handler
-    for (uint8_t i = 0; i < _commandCount; i++) {
-        if (strcmp(_commands[i].command, commandName) == 0) {
-            if (_commands[i].callback) {
-                _commands[i].callback(params);
-            }
-            return;
+    int index = -1;
+    if (nameLen < STM32COMM_MAX_CMD_LEN) {
+        index = findCommand(cmd, nameLen, hashName(cmd, nameLen));
+    }
+    if (index >= 0) {
+        if (_commands[index].callback) {
+            _commands[index].callback(params);
         }
+        return;
     }
 
     // No handler found - try unknown command callback
@@ -107,24 +163,40 @@ void STM32Comm::processCommand(const char* cmd) {
 }
 
 bool STM32Comm::onCommand(const char* command, STM32CommCallback callback) {
-    if (_commandCount >= STM32COMM_MAX_COMMANDS) {
+    size_t len = strlen(command);
+    if (len >= STM32COMM_MAX_CMD_LEN) {
         return false;
     }
+    uint32_t hash = hashName(command, len);
 
     // Check if command already registered (update it)
-    for (uint8_t i = 0; i < _commandCount; i++) {
-        if (strcmp(_commands[i].command, command) == 0) {
-            _commands[i].callback = callback;
-            return true;
-        }
+    int index = findCommand(command, len, hash);
+    if (index >= 0) {
+        _commands[index].callback = callback;
+        return true;
+    }
+
+    if (_commandCount >= STM32COMM_MAX_COMMANDS) {
+        return false;
     }
 
     // Add new command
-    strncpy(_commands[_commandCount].command, command, STM32COMM_MAX_CMD_LEN - 1);
-    _commands[_commandCount].command[STM32COMM_MAX_CMD_LEN - 1] = '\0';
-    _commands[_commandCount].callback = callback;
+    CommandEntry& entry = _commands[_commandCount];
+    memcpy(entry.command, command, len + 1);
+    entry.length = (uint8_t)len;
+    entry.hash = hash;
+    entry.callback = callback;
     _commandCount++;
 
+    // Claim the first free slot along its probe sequence
+    for (uint8_t probe = 0; probe < STM32COMM_HASH_SLOTS; probe++) {
+        uint8_t& slot = _slots[(hash + probe) & (STM32COMM_HASH_SLOTS - 1)];
+        if (slot == 0) {
+            slot = _commandCount;
+            break;
+        }
+    }
+
     return true;
 }
 
@@ -133,12 +205,8 @@ void STM32Comm::onUnknownCommand(STM32CommCallback callback) {
 }
 
 bool STM32Comm::hasCommand(const char* command) {
-    for (uint8_t i = 0; i < _commandCount; i++) {
-        if (strcmp(_commands[i].command, command) == 0) {
-            return true;
-        }
-    }
-    return false;
+    size_t len = strlen(command);
+    return len < STM32COMM_MAX_CMD_LEN && findCommand(command, len, hashName(command, len)) >= 0;
 }
 
 void STM32Comm::sendOK() {
@@ -146,33 +214,149 @@ void STM32Comm::sendOK() {
 }
 
 void STM32Comm::sendError(const char* message) {
-    if (_serial) {
-        _serial->print("ERROR:");
-        _serial->println(message);
-        debugLogTx((String("ERROR:") + message).c_str());
-    }
+    beginResponse("ERROR:").append(message).endResponse();
 }
 
 void STM32Comm::send(const char* response) {
-    if (_serial) {
-        _serial->println(response);
-        debugLogTx(response);
+    // The response just built (response()) goes out as is
+    if (response != _tx) {
+        beginResponse().append(response);
     }
+    endResponse();
 }
 
 void STM32Comm::sendf(const char* format, ...) {
-    char buffer[256];
     va_list args;
     va_start(args, format);
-    vsnprintf(buffer, sizeof(buffer), format, args);
+    beginResponse().vappendf(format, args);
+    va_end(args);
+    endResponse();
+}
+
+// Response builder
+
+STM32Comm& STM32Comm::beginResponse(const char* prefix) {
+    _txLength = 0;
+    _txOverflow = false;
+    _tx[0] = '\0';
+    if (prefix) {
+        append(prefix);
+    }
+    return *this;
+}
+
+STM32Comm& STM32Comm::append(const char* text, size_t len) {
+    if (_txOverflow) return *this;
+    if (len > STM32COMM_TX_BUFFER_SIZE - _txLength) {
+        // All or nothing: a reply is never sent with a field cut short
+        _txOverflow = true;
+        return *this;
+    }
+    memmove(_tx + _txLength, text, len);
+    _txLength += len;
+    _tx[_txLength] = '\0';
+    return *this;
+}
+
+STM32Comm& STM32Comm::append(const char* text) {
+    return text ? append(text, strlen(text)) : *this;
+}
+
+STM32Comm& STM32Comm::appendChar(char c) {
+    return append(&c, 1);
+}
+
+STM32Comm& STM32Comm::appendInt(long value) {
+    char digits[21];  // Sign and digits of a 64-bit long (host builds)
+    size_t pos = sizeof(digits);
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    do {
+        digits[--pos] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) {
+        digits[--pos] = '-';
+    }
+    return append(digits + pos, sizeof(digits) - pos);
+}
+
+STM32Comm& STM32Comm::appendFixed(long scaled, uint8_t decimals) {
+    if (decimals > 9) decimals = 9;
+    unsigned long divisor = 1;
+    for (uint8_t i = 0; i < decimals; i++) {
+        divisor *= 10;
+    }
+
+    unsigned long magnitude = scaled < 0 ? 0UL - (unsigned long)scaled : (unsigned long)scaled;
+    if (scaled < 0) {
+        appendChar('-');
+    }
+    appendInt((long)(magnitude / divisor));
+    if (decimals == 0) return *this;
+
+    char frac[10];
+    unsigned long rest = magnitude % divisor;
+    for (int i = decimals - 1; i >= 0; i--) {
+        frac[i] = '0' + rest % 10;
+        rest /= 10;
+    }
+    return appendChar('.').append(frac, decimals);
+}
+
+STM32Comm& STM32Comm::appendFloat(float value, uint8_t decimals) {
+    if (isnan(value)) return append("nan");
+    if (decimals > 6) decimals = 6;
+    float scale = 1.0f;
+    for (uint8_t i = 0; i < decimals; i++) {
+        scale *= 10.0f;
+    }
+    float scaled = value * scale;
+    if (scaled > 2147483647.0f || scaled < -2147483647.0f) return append("ovf");  // As Print::print(float)
+    return appendFixed((long)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f), decimals);
+}
+
+STM32Comm& STM32Comm::appendf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vappendf(format, args);
     va_end(args);
-    send(buffer);
+    return *this;
+}
+
+STM32Comm& STM32Comm::vappendf(const char* format, va_list args) {
+    if (_txOverflow) return *this;
+    size_t room = STM32COMM_TX_BUFFER_SIZE - _txLength;
+    int written = vsnprintf(_tx + _txLength, room + 1, format, args);
+    if (written < 0 || (size_t)written > room) {
+        _tx[_txLength] = '\0';  // Drop the partial field
+        _txOverflow = true;
+        return *this;
+    }
+    _txLength += written;
+    return *this;
 }
 
+bool STM32Comm::endResponse() {
+    if (!_serial) return false;
+
+    if (_txOverflow) {
+        debugf("Response too long, dropped: %.40s...", _tx);
+        beginResponse("ERROR:RESPONSE_TOO_LONG");
+        endResponse();
+        return false;
+    }
+
+    debugLogTx(_tx, _txLength);
+    _tx[_txLength] = '\n';
+    _serial->write((const uint8_t*)_tx, _txLength + 1);
+    _tx[_txLength] = '\0';
+    return true;
+}
+
+#if STM32COMM_LOG_LEVEL >= STM32COMM_LOG_DEBUG
 void STM32Comm::debug(const char* message) {
     if (_debug) {
-        _debug->print("DBG: ");
-        _debug->println(message);
+        logLine("DBG: ", message, strlen(message));
     }
 }
 
@@ -181,24 +365,101 @@ void STM32Comm::debugf(const char* format, ...) {
         char buffer[256];
         va_list args;
         va_start(args, format);
-        vsnprintf(buffer, sizeof(buffer), format, args);
+        int len = vsnprintf(buffer, sizeof(buffer), format, args);
         va_end(args);
-        debug(buffer);
+        if (len < 0) return;
+        logLine("DBG: ", buffer, (size_t)len < sizeof(buffer) ? (size_t)len : sizeof(buffer) - 1);
     }
 }
+#endif
 
-void STM32Comm::debugLogRx(const char* cmd) {
+void STM32Comm::debugLogRx(const char* cmd, size_t len) {
+#if STM32COMM_LOG_LEVEL >= STM32COMM_LOG_TRACE
     if (_debug) {
-        _debug->print("RX> ");
-        _debug->println(cmd);
+        logLine("RX> ", cmd, len);
     }
+#else
+    (void)cmd;
+    (void)len;
+#endif
 }
 
-void STM32Comm::debugLogTx(const char* response) {
+void STM32Comm::debugLogTx(const char* response, size_t len) {
+#if STM32COMM_LOG_LEVEL >= STM32COMM_LOG_TRACE
     if (_debug) {
-        _debug->print("TX> ");
-        _debug->println(response);
+        logLine("TX> ", response, len);
+    }
+#else
+    (void)response;
+    (void)len;
+#endif
+}
+
+// Debug log queue
+
+void STM32Comm::logCopy(const char* data, size_t len) {
+    size_t first = STM32COMM_LOG_BUFFER_SIZE - _logHead;
+    if (first > len) first = len;
+    memcpy(_log + _logHead, data, first);
+    memcpy(_log, data + first, len - first);
+    _logHead = (_logHead + len) % STM32COMM_LOG_BUFFER_SIZE;
+    _logUsed += len;
+}
+
+// Queues prefix + text + "\r\n" as one line, or drops it whole
+void STM32Comm::logLine(const char* prefix, const char* text, size_t len) {
+    bool cut = len > STM32COMM_LOG_LINE_MAX;
+    if (cut) len = STM32COMM_LOG_LINE_MAX;
+    size_t prefixLen = strlen(prefix);
+    size_t lineLen = prefixLen + len + (cut ? 3 : 0) + 2;
+
+    // Say how much was lost before the first line that fits again
+    char notice[48];
+    size_t noticeLen = 0;
+    if (_logDropped != _logDroppedReported) {
+        noticeLen = snprintf(notice, sizeof(notice), "DBG: %lu log lines dropped\r\n",
+                             (unsigned long)(_logDropped - _logDroppedReported));
     }
+
+    if (_logUsed + noticeLen + lineLen > STM32COMM_LOG_BUFFER_SIZE) {
+        _logDropped++;
+        return;
+    }
+    if (noticeLen > 0) {
+        logCopy(notice, noticeLen);
+        _logDroppedReported = _logDropped;
+    }
+    logCopy(prefix, prefixLen);
+    logCopy(text, len);
+    if (cut) logCopy("...", 3);
+    logCopy("\r\n", 2);
+}
+
+// Writes queued output; without wait, only what the stream takes at once
+void STM32Comm::drainLog(bool wait) {
+    if (!_debug || _logUsed == 0) return;
+
+    size_t budget = _logUsed;
+    if (!wait) {
+        int room = _debug->availableForWrite();
+        if (room <= 0) return;
+        if (budget > (size_t)room) budget = room;
+    }
+
+    // At most two writes: up to the end of the ring, then from its start
+    while (budget > 0) {
+        size_t chunk = STM32COMM_LOG_BUFFER_SIZE - _logTail;
+        if (chunk > budget) chunk = budget;
+        size_t written = _debug->write((const uint8_t*)_log + _logTail, chunk);
+        if (written == 0) break;
+        _logTail = (_logTail + written) % STM32COMM_LOG_BUFFER_SIZE;
+        _logUsed -= written;
+        budget -= written;
+    }
+}
+
+void STM32Comm::flushLog() {
+    drainLog(true);
 }
 
 // Helper function implementations
@@ -37,6 +37,7 @@
 #define STM32COMM_H
 
 #include <Arduino.h>
+#include <stdarg.h>
 
 // Configuration
 #ifndef STM32COMM_MAX_COMMANDS
@@ -47,10 +48,49 @@
 #define STM32COMM_MAX_CMD_LEN 64
 #endif
 
+// Open-addressed command table: a power of two, at least twice
+// STM32COMM_MAX_COMMANDS so probes stay short
+#ifndef STM32COMM_HASH_SLOTS
+#define STM32COMM_HASH_SLOTS 32
+#endif
+
+// Bytes moved from the serial driver per readBytes() call in process()
+#ifndef STM32COMM_RX_CHUNK_SIZE
+#define STM32COMM_RX_CHUNK_SIZE 128
+#endif
+
+// Debug log levels. Messages above STM32COMM_LOG_LEVEL are compiled out;
+// set it for the sketch and the library alike (e.g. PlatformIO build_flags)
+#define STM32COMM_LOG_NONE 0
+#define STM32COMM_LOG_DEBUG 1  // debug() / debugf()
+#define STM32COMM_LOG_TRACE 2  // Every RX> and TX> line
+
+#ifndef STM32COMM_LOG_LEVEL
+#define STM32COMM_LOG_LEVEL STM32COMM_LOG_TRACE
+#endif
+
+// Log lines are queued here and written out from process() as the debug
+// UART has room, so logging never waits on the 115200 baud line. Lines that
+// do not fit are dropped whole and counted.
+#ifndef STM32COMM_LOG_BUFFER_SIZE
+#define STM32COMM_LOG_BUFFER_SIZE 2048
+#endif
+
+// Longer log lines (e.g. a 2 KB GCP_KEY command) are cut here with "..."
+#ifndef STM32COMM_LOG_LINE_MAX
+#define STM32COMM_LOG_LINE_MAX 160
+#endif
+
 #ifndef STM32COMM_BUFFER_SIZE
 #define STM32COMM_BUFFER_SIZE 2560
 #endif
 
+// Largest response line, excluding the newline. Sized for a full CALENDAR
+// reply; a response that does not fit is replaced by ERROR:RESPONSE_TOO_LONG
+#ifndef STM32COMM_TX_BUFFER_SIZE
+#define STM32COMM_TX_BUFFER_SIZE 2560
+#endif
+
 // Callback type for command handlers
 // params contains everything after "COMMAND:" (or empty string if no colon)
 typedef void (*STM32CommCallback)(const char* params);
@@ -74,6 +114,7 @@ public:
 
     /**
      * Process incoming serial data - call this in loop()
+     * Also writes queued debug output as far as the debug stream has room.
      */
     void process();
 
@@ -108,8 +149,73 @@ public:
      */
     void sendf(const char* format, ...);
 
+    /**
+     * Start building a response in the preallocated TX buffer
+     * Fields are appended in place and the line goes out with a single
+     * write() in endResponse(); nothing is allocated on the heap. Only one
+     * response can be built at a time (send* also use the buffer).
+     *
+     *   comm.beginResponse("WEATHER:").appendInt(72).appendChar(',')...;
+     *   comm.endResponse();
+     *
+     * @param prefix Optional leading text (e.g., "WEATHER:")
+     */
+    STM32Comm& beginResponse(const char* prefix = nullptr);
+
+    /**
+     * Append text to the response being built
+     */
+    STM32Comm& append(const char* text);
+    STM32Comm& append(const char* text, size_t len);
+
+    /**
+     * Append a single character, typically a field separator
+     */
+    STM32Comm& appendChar(char c);
+
+    /**
+     * Append a decimal integer
+     */
+    STM32Comm& appendInt(long value);
+
+    /**
+     * Append a fixed-point number: appendFixed(-1234, 2) gives "-12.34"
+     * @param scaled Value multiplied by 10^decimals
+     * @param decimals Digits after the point (0-9)
+     */
+    STM32Comm& appendFixed(long scaled, uint8_t decimals);
+
+    /**
+     * Append a float rounded to a fixed number of decimals (like String(f, n))
+     */
+    STM32Comm& appendFloat(float value, uint8_t decimals);
+
+    /**
+     * Append printf-style formatted text
+     */
+    STM32Comm& appendf(const char* format, ...);
+
+    /**
+     * @return The response built so far (NUL-terminated, no newline)
+     */
+    const char* response() const { return _tx; }
+    size_t responseLength() const { return _txLength; }
+
+    /**
+     * @return false once something did not fit in the TX buffer
+     */
+    bool responseFits() const { return !_txOverflow; }
+
+    /**
+     * Send the built response and its newline with a single write()
+     * @return false if it did not fit; ERROR:RESPONSE_TOO_LONG is sent instead
+     */
+    bool endResponse();
+
+#if STM32COMM_LOG_LEVEL >= STM32COMM_LOG_DEBUG
     /**
      * Log a debug message (only if debug stream is set)
+     * The line is queued and written out later from process().
      * @param message Debug message
      */
     void debug(const char* message);
@@ -119,6 +225,21 @@ public:
      * @param format Printf-style format string
      */
     void debugf(const char* format, ...);
+#else
+    void debug(const char*) {}
+    void debugf(const char*, ...) {}
+#endif
+
+    /**
+     * Write out all queued debug output, waiting for the debug stream
+     * (e.g. before a restart)
+     */
+    void flushLog();
+
+    /**
+     * @return Number of log lines dropped because the queue was full
+     */
+    uint32_t droppedLogLines() const { return _logDropped; }
 
     /**
      * Check if a command handler is registered
@@ -140,22 +261,46 @@ private:
     // Command buffer
     char _buffer[STM32COMM_BUFFER_SIZE];
     size_t _bufferIndex;
+    bool _bufferOverflow;
+
+    // Response buffer: content plus room for the newline
+    char _tx[STM32COMM_TX_BUFFER_SIZE + 1];
+    size_t _txLength;
+    bool _txOverflow;
 
-    // Registered commands
+    // Registered commands, found through _slots by name hash
     struct CommandEntry {
         char command[STM32COMM_MAX_CMD_LEN];
+        uint8_t length;
+        uint32_t hash;
         STM32CommCallback callback;
     };
     CommandEntry _commands[STM32COMM_MAX_COMMANDS];
     uint8_t _commandCount;
+    uint8_t _slots[STM32COMM_HASH_SLOTS];  // Index + 1 into _commands, 0 = empty
 
     // Unknown command handler
     STM32CommCallback _unknownCallback;
 
+    // Queued debug output
+    char _log[STM32COMM_LOG_BUFFER_SIZE];
+    size_t _logHead;  // Next byte written
+    size_t _logTail;  // Next byte sent
+    size_t _logUsed;
+    uint32_t _logDropped;
+    uint32_t _logDroppedReported;
+
     // Internal methods
-    void processCommand(const char* cmd);
-    void debugLogRx(const char* cmd);
-    void debugLogTx(const char* response);
+    void appendLine(const char* data, size_t len);
+    void processCommand(const char* cmd, size_t len);
+    int findCommand(const char* name, size_t len, uint32_t hash) const;
+    static uint32_t hashName(const char* name, size_t len);
+    STM32Comm& vappendf(const char* format, va_list args);
+    void debugLogRx(const char* cmd, size_t len);
+    void debugLogTx(const char* response, size_t len);
+    void logLine(const char* prefix, const char* text, size_t len);
+    void logCopy(const char* data, size_t len);
+    void drainLog(bool wait);
 };
 
 // Helper function to parse comma-separated parameters
@@ -0,0 +1,83 @@
+/*
+ * SntpClient - request scheduling and the UDP socket (device only)
+ */
+
+#include "SntpClient.h"
+#include <ESP8266WiFi.h>
+
+void SntpClient::begin() {
+  _udp.begin(SNTP_LOCAL_PORT);
+  _burstLeft = SNTP_BURST_SAMPLES;
+  _nextRequestUs = (int64_t)micros64();
+}
+
+void SntpClient::setPollInterval(unsigned long pollInterval) {
+  _pollInterval = pollInterval;
+}
+
+uint64_t SntpClient::epochMs() const {
+  return (uint64_t)(epochUsAt((int64_t)micros64()) / 1000);
+}
+
+unsigned long SntpClient::getEpochTime() const {
+  return (unsigned long)(epochMs() / 1000);
+}
+
+void SntpClient::schedule(unsigned long delayMs, int64_t now) {
+  _nextRequestUs = now + (int64_t)delayMs * 1000;
+}
+
+void SntpClient::update() {
+  int64_t now = (int64_t)micros64();
+
+  if (_pending) {
+    if (_udp.parsePacket() > 0) {
+      // A reply that waited for loop() shows up as extra delay, so the
+      // filter ranks it down rather than trusting its offset
+      uint8_t packet[SNTP_PACKET_SIZE];
+      int len = _udp.read(packet, sizeof(packet));
+      _udp.flush();
+      _pending = false;
+      if (len > 0 && handleReply(packet, len, _cookie, _sentUs, now)) {
+        _failures = 0;
+        if (_burstLeft > 0) _burstLeft--;
+      }
+      schedule((_burstLeft > 0 || !_synced) ? SNTP_BURST_INTERVAL_MS : _pollInterval, now);
+    } else if (now - _sentUs >= (int64_t)SNTP_TIMEOUT_MS * 1000) {
+      _pending = false;
+      if (++_failures >= SNTP_RESOLVE_AFTER_FAILURES) {
+        _failures = 0;
+        _serverResolved = false;  // Pool servers come and go
+      }
+      schedule(SNTP_BURST_INTERVAL_MS, now);
+    }
+    return;
+  }
+
+  // Drop late replies to requests that already timed out
+  while (_udp.parsePacket() > 0) {
+    _udp.flush();
+  }
+  if (now < _nextRequestUs) return;
+
+  // The DNS lookup does block, but only before the first request and after
+  // repeated timeouts
+  if (!_serverResolved) {
+    if (!WiFi.hostByName(_server, _serverIp)) {
+      schedule(SNTP_BURST_INTERVAL_MS, now);
+      return;
+    }
+    _serverResolved = true;
+  }
+
+  uint8_t packet[SNTP_PACKET_SIZE];
+  _cookie = ((uint64_t)ESP.random() << 32) | ESP.random();
+  buildRequest(packet, _cookie);
+  if (!_udp.beginPacket(_serverIp, SNTP_PORT) || _udp.write(packet, sizeof(packet)) != sizeof(packet) ||
+      !_udp.endPacket()) {
+    schedule(SNTP_BURST_INTERVAL_MS, now);
+    return;
+  }
+  _sentUs = (int64_t)micros64();
+  _pending = true;
+}
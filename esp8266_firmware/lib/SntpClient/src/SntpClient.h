@@ -0,0 +1,114 @@
+/*
+ * SntpClient - non-blocking SNTP client for ESP8266
+ *
+ * update() is meant to be called on every loop(): it sends a request when
+ * one is due and picks the reply up on a later call, so nothing ever waits
+ * on the network. Each reply yields the offset between the local monotonic
+ * clock (micros64) and UTC plus the round-trip delay; the time is then read
+ * at any moment as local clock + offset, with millisecond resolution.
+ *
+ * Filtering: the offset comes from the lowest-delay sample of the last
+ * SNTP_FILTER_SAMPLES (a delayed reply carries the most error, including a
+ * reply left waiting while loop() was busy). A sample that disagrees with
+ * the clock by more than SNTP_STEP_THRESHOLD_US is held back until a second
+ * one confirms it and then stepped. A smaller correction is spread evenly
+ * over the poll interval, the clock running at most half again as fast or
+ * half as slow meanwhile, so the reported time never goes backwards except
+ * on a step.
+ *
+ * Usage:
+ *   SntpClient sntp("pool.ntp.org");
+ *
+ *   void setup() { sntp.begin(); }
+ *   void loop() {
+ *     if (WiFi.status() == WL_CONNECTED) sntp.update();
+ *     if (sntp.isTimeSet()) uint64_t ms = sntp.epochMs();
+ *   }
+ */
+
+#ifndef SNTPCLIENT_H
+#define SNTPCLIENT_H
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+#define SNTP_PACKET_SIZE 48
+#define SNTP_PORT 123
+#define SNTP_LOCAL_PORT 2390
+#define SNTP_FILTER_SAMPLES 8
+#define SNTP_BURST_SAMPLES 4              // Quick samples after boot to fill the filter
+#define SNTP_BURST_INTERVAL_MS 2000       // Also the retry interval after a timeout
+#define SNTP_TIMEOUT_MS 1500
+#define SNTP_MAX_DELAY_US 1000000LL       // Slower replies are useless
+#define SNTP_STEP_THRESHOLD_US 128000LL   // Larger corrections step, smaller ones slew
+#define SNTP_SLEW_DIVISOR 4               // Fraction of a small correction applied per sample
+#define SNTP_RESOLVE_AFTER_FAILURES 3     // Look the server up again after this many timeouts
+
+struct SntpSample {
+  int64_t offsetUs;  // UTC minus local clock
+  int64_t delayUs;   // Round trip minus server processing time
+  int64_t localUs;   // Local clock when the reply arrived
+};
+
+class SntpClient {
+public:
+  explicit SntpClient(const char* server = "pool.ntp.org", unsigned long pollInterval = 60000);
+
+  void begin();
+  void update();
+  void setPollInterval(unsigned long pollInterval);
+
+  bool isTimeSet() const { return _synced; }
+  uint64_t epochMs() const;
+  unsigned long getEpochTime() const;  // Whole seconds, as NTPClient
+  int64_t epochUsAt(int64_t localUs) const { return localUs + offsetAt(localUs); }
+
+  int64_t offsetUs() const { return _offsetUs; }  // Once any slew completes
+  int64_t lastDelayUs() const { return _lastDelayUs; }
+  uint32_t acceptedSamples() const { return _accepted; }
+  uint32_t rejectedSamples() const { return _rejected; }
+
+  // Packet handling, kept apart from the socket so it runs on the host.
+  // cookie goes out as the request's transmit timestamp and must come back
+  // as the reply's originate timestamp; sentUs/receivedUs are local clock.
+  static void buildRequest(uint8_t* packet, uint64_t cookie);
+  bool handleReply(const uint8_t* packet, size_t len, uint64_t cookie, int64_t sentUs, int64_t receivedUs);
+
+private:
+  bool addSample(const SntpSample& sample);
+  void applyFilter();
+  int64_t offsetAt(int64_t localUs) const;
+  void schedule(unsigned long delayMs, int64_t now);
+
+  const char* _server;
+  unsigned long _pollInterval;
+  WiFiUDP _udp;
+  IPAddress _serverIp;
+  bool _serverResolved;
+
+  // Request in flight
+  bool _pending;
+  uint64_t _cookie;
+  int64_t _sentUs;
+  int64_t _nextRequestUs;
+  uint8_t _burstLeft;
+  uint8_t _failures;
+
+  // Clock filter
+  SntpSample _samples[SNTP_FILTER_SAMPLES];
+  uint8_t _sampleCount;
+  uint8_t _sampleNext;
+  bool _haveSuspect;
+  SntpSample _suspect;
+
+  bool _synced;
+  int64_t _offsetUs;
+  int64_t _slewUs;          // Part of _offsetUs not yet applied at _slewStartUs
+  int64_t _slewStartUs;
+  int64_t _slewDurationUs;
+  int64_t _lastDelayUs;
+  uint32_t _accepted;
+  uint32_t _rejected;
+};
+
+#endif // SNTPCLIENT_H
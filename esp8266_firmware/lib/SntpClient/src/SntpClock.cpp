@@ -0,0 +1,168 @@
+/*
+ * SntpClient - reply validation, offset/delay math and the clock filter
+ *
+ * Timestamps: T1 = request sent and T4 = reply received (local clock),
+ * T2 = request received and T3 = reply sent (server, UTC). Then
+ *   offset = ((T2 - T1) + (T3 - T4)) / 2
+ *   delay  = (T4 - T1) - (T3 - T2)
+ * and the true offset lies within delay / 2 of the computed one, which is
+ * why the lowest-delay sample is the one trusted.
+ */
+
+#include "SntpClient.h"
+
+// Seconds from the NTP epoch (1900) to the Unix epoch (1970)
+#define NTP_UNIX_OFFSET 2208988800LL
+
+// Age penalty when picking a sample: ~60 ppm, about the worst drift of the
+// ESP8266 crystal, so a fresh sample beats an old one with slightly less delay
+#define SNTP_AGE_PENALTY_DIVISOR 16384
+
+static uint64_t read64(const uint8_t* p) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++) {
+    value = (value << 8) | p[i];
+  }
+  return value;
+}
+
+static void write64(uint8_t* p, uint64_t value) {
+  for (int i = 7; i >= 0; i--) {
+    p[i] = (uint8_t)value;
+    value >>= 8;
+  }
+}
+
+// 32.32 fixed point NTP time to Unix microseconds. Seconds without the top
+// bit set are taken to be in NTP era 1 (from February 2036).
+static int64_t ntpToUnixUs(uint64_t timestamp) {
+  uint32_t seconds = (uint32_t)(timestamp >> 32);
+  uint32_t fraction = (uint32_t)timestamp;
+  int64_t unixSeconds = (int64_t)seconds - NTP_UNIX_OFFSET;
+  if (!(seconds & 0x80000000UL)) unixSeconds += 0x100000000LL;
+  return unixSeconds * 1000000LL + (int64_t)(((uint64_t)fraction * 1000000ULL) >> 32);
+}
+
+static int64_t absUs(int64_t value) {
+  return value < 0 ? -value : value;
+}
+
+SntpClient::SntpClient(const char* server, unsigned long pollInterval)
+    : _server(server), _pollInterval(pollInterval), _serverResolved(false),
+      _pending(false), _cookie(0), _sentUs(0), _nextRequestUs(0),
+      _burstLeft(SNTP_BURST_SAMPLES), _failures(0),
+      _sampleCount(0), _sampleNext(0), _haveSuspect(false),
+      _synced(false), _offsetUs(0), _slewUs(0), _slewStartUs(0), _slewDurationUs(0),
+      _lastDelayUs(0), _accepted(0), _rejected(0) {}
+
+void SntpClient::buildRequest(uint8_t* packet, uint64_t cookie) {
+  memset(packet, 0, SNTP_PACKET_SIZE);
+  packet[0] = (0 << 6) | (4 << 3) | 3;  // No leap warning, version 4, client
+  write64(packet + 40, cookie);
+}
+
+bool SntpClient::handleReply(const uint8_t* packet, size_t len, uint64_t cookie, int64_t sentUs,
+                             int64_t receivedUs) {
+  if (len < SNTP_PACKET_SIZE) {
+    _rejected++;
+    return false;
+  }
+
+  uint8_t leap = packet[0] >> 6;
+  uint8_t version = (packet[0] >> 3) & 7;
+  uint8_t mode = packet[0] & 7;
+  uint8_t stratum = packet[1];
+  // Server mode only; leap 3 means unsynchronized and stratum 0 is a
+  // kiss-o'-death (rate limit or deny)
+  if (mode != 4 || version < 3 || version > 4 || leap == 3 || stratum == 0 || stratum > 15) {
+    _rejected++;
+    return false;
+  }
+
+  // Must answer our request, not an older or forged one
+  uint64_t originate = read64(packet + 24);
+  uint64_t received = read64(packet + 32);
+  uint64_t transmitted = read64(packet + 40);
+  if (originate != cookie || received == 0 || transmitted == 0) {
+    _rejected++;
+    return false;
+  }
+
+  int64_t t2 = ntpToUnixUs(received);
+  int64_t t3 = ntpToUnixUs(transmitted);
+  int64_t delay = (receivedUs - sentUs) - (t3 - t2);
+  if (delay < 0) delay = 0;  // Clock resolution on very fast round trips
+  if (delay > SNTP_MAX_DELAY_US || t3 < t2) {
+    _rejected++;
+    return false;
+  }
+
+  SntpSample sample;
+  sample.offsetUs = ((t2 - sentUs) + (t3 - receivedUs)) / 2;
+  sample.delayUs = delay;
+  sample.localUs = receivedUs;
+  _lastDelayUs = delay;
+  return addSample(sample);
+}
+
+bool SntpClient::addSample(const SntpSample& sample) {
+  if (_synced && absUs(sample.offsetUs - _offsetUs) > SNTP_STEP_THRESHOLD_US) {
+    // One sample far off is more likely a bad server than a wrong clock:
+    // step only once a second sample agrees with it
+    if (!_haveSuspect || absUs(sample.offsetUs - _suspect.offsetUs) > SNTP_STEP_THRESHOLD_US) {
+      _suspect = sample;
+      _haveSuspect = true;
+      _rejected++;
+      return false;
+    }
+    // The kept samples describe the old clock
+    _sampleCount = 0;
+    _sampleNext = 0;
+    _synced = false;
+  }
+  _haveSuspect = false;
+
+  _samples[_sampleNext] = sample;
+  _sampleNext = (_sampleNext + 1) % SNTP_FILTER_SAMPLES;
+  if (_sampleCount < SNTP_FILTER_SAMPLES) _sampleCount++;
+  _accepted++;
+  applyFilter();
+  return true;
+}
+
+void SntpClient::applyFilter() {
+  const SntpSample& newest = _samples[(_sampleNext + SNTP_FILTER_SAMPLES - 1) % SNTP_FILTER_SAMPLES];
+  const SntpSample* best = nullptr;
+  int64_t bestScore = 0;
+  for (int i = 0; i < _sampleCount; i++) {
+    const SntpSample& s = _samples[i];
+    int64_t score = s.delayUs + (newest.localUs - s.localUs) / SNTP_AGE_PENALTY_DIVISOR;
+    if (!best || score < bestScore) {
+      best = &s;
+      bestScore = score;
+    }
+  }
+
+  if (!_synced) {
+    _offsetUs = best->offsetUs;
+    _slewUs = 0;
+    _synced = true;
+    return;
+  }
+  // Small corrections are taken a fraction at a time, so jitter that got
+  // past the filter is smoothed out, and each is applied gradually from
+  // where the clock stands now, so the reported time never jumps
+  int64_t appliedUs = offsetAt(newest.localUs);
+  _offsetUs += (best->offsetUs - _offsetUs) / SNTP_SLEW_DIVISOR;
+  _slewUs = _offsetUs - appliedUs;
+  _slewStartUs = newest.localUs;
+  _slewDurationUs = (int64_t)_pollInterval * 1000;
+  if (_slewDurationUs < 2 * absUs(_slewUs)) _slewDurationUs = 2 * absUs(_slewUs);
+}
+
+int64_t SntpClient::offsetAt(int64_t localUs) const {
+  int64_t elapsed = localUs - _slewStartUs;
+  if (_slewUs == 0 || elapsed >= _slewDurationUs) return _offsetUs;
+  if (elapsed < 0) elapsed = 0;
+  return _offsetUs - _slewUs * (_slewDurationUs - elapsed) / _slewDurationUs;
+}
@@ -12,12 +12,14 @@
 #include <WiFiClient.h>
 #include <WiFiClientSecure.h>
 #include <WiFiUdp.h>
-#include <NTPClient.h>
 #include <ArduinoJson.h>
 #include <EEPROM.h>
+#include <LittleFS.h>
 #include <ESP_Google_Sheet_Client.h>
 #include <STM32Comm.h>
+#include <SntpClient.h>
 #include <ICalParser.h>
+#include <new>
 
 // ============================================================================
 // CONFIGURATION
@@ -37,9 +39,8 @@ char weatherCountry[MAX_WEATHER_COUNTRY_LEN + 1] = "US";
 // Stock API (Alpha Vantage)
 const char* STOCK_API_KEY = "your_api_key_here";
 
-// NTP Configuration
-const long UTC_OFFSET_SEC = 0;  // Return UTC, STM32 handles timezone conversion
-const int NTP_UPDATE_INTERVAL = 60000;
+// NTP Configuration (time is returned in UTC, STM32 handles timezone conversion)
+const unsigned long NTP_UPDATE_INTERVAL = 60000;
 
 // ============================================================================
 // CREDENTIALS STORAGE
@@ -52,7 +53,9 @@ const int NTP_UPDATE_INTERVAL = 60000;
 #define MAX_PROJECT_ID_LEN 128
 #define MAX_EMAIL_LEN 256
 #define MAX_PRIVATE_KEY_LEN 2048
-#define MAX_CALENDAR_URL_LEN 256
+#define MAX_CALENDAR_URL_LEN 256   // Per feed
+#define CALENDAR_MAX_FEEDS 3
+#define CALENDAR_MAX_EVENTS 20         // Most a CALENDAR command can ask for
 
 struct WiFiCredentials {
   uint16_t magic;
@@ -69,7 +72,75 @@ struct GCPCredentials {
 
 WiFiCredentials wifiCreds;
 GCPCredentials gcpCreds;
-char calendarUrl[MAX_CALENDAR_URL_LEN + 1];
+// iCal feed URLs, filled from the first slot; an empty one ends the list
+char calendarUrls[CALENDAR_MAX_FEEDS][MAX_CALENDAR_URL_LEN + 1];
+
+// Every setting the STM32 can push is kept here, so after a reset the ESP
+// can rejoin WiFi and start the GSheet token flow before anyone asks.
+//
+// Layout: a SettingsHeader, then one record per entry of settingSlots[] at a
+// fixed offset sized for its maximum length: a SettingRecordHeader (id,
+// length, CRC32 of id + length + value) followed by the value bytes without
+// terminator. Records are checked one at a time, so a corrupt one only loses
+// that setting. New settings are appended to the table (recordCount tells
+// older layouts apart); moving or resizing a record needs a version bump.
+#define SETTINGS_MAGIC 0x53505345UL  // "ESPS"
+#define SETTINGS_VERSION 1
+
+struct SettingsHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recordCount;
+};
+
+struct SettingRecordHeader {
+  uint8_t id;
+  uint8_t reserved;
+  uint16_t length;
+  uint32_t crc;
+};
+
+enum SettingId : uint8_t {
+  SETTING_WIFI_SSID = 1,
+  SETTING_WIFI_PASSWORD,
+  SETTING_GCP_PROJECT,
+  SETTING_GCP_EMAIL,
+  SETTING_GCP_KEY,
+  SETTING_CALENDAR_URL,
+  SETTING_WEATHER_API_KEY,
+  SETTING_WEATHER_CITY,
+  SETTING_WEATHER_COUNTRY,
+  SETTING_CALENDAR_URL_2,
+  SETTING_CALENDAR_URL_3,
+};
+
+struct SettingSlot {
+  SettingId id;
+  char* value;
+  uint16_t capacity;  // Longest value, excluding the terminator
+};
+
+// Order is the on-flash order: append only
+SettingSlot settingSlots[] = {
+  {SETTING_WIFI_SSID, wifiCreds.ssid, MAX_SSID_LEN},
+  {SETTING_WIFI_PASSWORD, wifiCreds.password, MAX_PASS_LEN},
+  {SETTING_GCP_PROJECT, gcpCreds.project_id, MAX_PROJECT_ID_LEN},
+  {SETTING_GCP_EMAIL, gcpCreds.client_email, MAX_EMAIL_LEN},
+  {SETTING_GCP_KEY, gcpCreds.private_key, MAX_PRIVATE_KEY_LEN},
+  {SETTING_CALENDAR_URL, calendarUrls[0], MAX_CALENDAR_URL_LEN},
+  {SETTING_WEATHER_API_KEY, weatherApiKey, MAX_WEATHER_API_KEY_LEN},
+  {SETTING_WEATHER_CITY, weatherCity, MAX_WEATHER_CITY_LEN},
+  {SETTING_WEATHER_COUNTRY, weatherCountry, MAX_WEATHER_COUNTRY_LEN},
+  {SETTING_CALENDAR_URL_2, calendarUrls[1], MAX_CALENDAR_URL_LEN},
+  {SETTING_CALENDAR_URL_3, calendarUrls[2], MAX_CALENDAR_URL_LEN},
+};
+const size_t SETTING_COUNT = sizeof(settingSlots) / sizeof(settingSlots[0]);
+
+static_assert(sizeof(SettingsHeader) + SETTING_COUNT * sizeof(SettingRecordHeader) + MAX_SSID_LEN + MAX_PASS_LEN +
+                  MAX_PROJECT_ID_LEN + MAX_EMAIL_LEN + MAX_PRIVATE_KEY_LEN + CALENDAR_MAX_FEEDS * MAX_CALENDAR_URL_LEN +
+                  MAX_WEATHER_API_KEY_LEN + MAX_WEATHER_CITY_LEN + MAX_WEATHER_COUNTRY_LEN <= EEPROM_SIZE,
+              "settings do not fit in EEPROM_SIZE");
+static_assert(CALENDAR_MAX_FEEDS <= ICAL_MAX_FEEDS, "more calendar feeds than ICalMerge takes");
 
 // ============================================================================
 // GLOBALS
@@ -77,8 +148,7 @@ char calendarUrl[MAX_CALENDAR_URL_LEN + 1];
 
 STM32Comm comm;
 FirebaseJson gSheetResponse;
-WiFiUDP ntpUDP;
-NTPClient timeClient(ntpUDP, "pool.ntp.org", UTC_OFFSET_SEC, NTP_UPDATE_INTERVAL);
+SntpClient timeClient("pool.ntp.org", NTP_UPDATE_INTERVAL);
 
 // State flags
 bool gsheetInitialized = false;
@@ -90,6 +160,10 @@ enum AppWiFiState { WIFI_IDLE, WIFI_CONNECTING, WIFI_CONNECTED };
 AppWiFiState wifiState = WIFI_IDLE;
 unsigned long wifiConnectStartTime = 0;
 const unsigned long WIFI_CONNECT_TIMEOUT = 10000;
+const unsigned long WIFI_FAST_CONNECT_TIMEOUT = 3000;  // Then fall back to a full scan
+bool wifiConnectFast = false;         // Current attempt uses the cached AP and lease
+unsigned long wifiAssocMs = 0;        // Duration of the last successful association
+bool wifiAssocFast = false;
 const unsigned long WIFI_CHECK_INTERVAL = 100;
 unsigned long lastWifiCheck = 0;
 
@@ -97,18 +171,337 @@ unsigned long lastWifiCheck = 0;
 struct {
   unsigned long lastWeatherUpdate = 0;
   String weatherData = "";
+  String weatherLocation = "";    // "city,country" the restored data is for
+  bool weatherStale = false;      // Restored from flash, not yet refreshed
+  int balance = -1;
+  bool balanceStale = false;
   unsigned long lastStockUpdate = 0;
   String stockSymbol = "";
   String stockData = "";
 } cache;
 
+// Fresh fetches owed to the STM32 after it was answered from stale data
+struct {
+  bool weather = false;
+  bool balance = false;
+  bool calendar = false;
+  int calendarEvents = 10;
+  unsigned long lastAttempt = 0;
+} refreshPending;
+
 const unsigned long WEATHER_CACHE_TIME = 900000;  // 15 minutes
 const unsigned long STOCK_CACHE_TIME = 60000;     // 1 minute
+const unsigned long CALENDAR_CACHE_TIME = 900000; // 15 minutes, then revalidate
+const time_t CALENDAR_HORIZON = 7 * 86400L;  // Every instance of a recurring event this week
+const unsigned long STALE_REFRESH_INTERVAL = 30000; // Min gap between background refresh attempts
+
+// Each feed keeps its own cache (compact events and ETag/Last-Modified of
+// its last full download) and upcoming-event list; replies merge the lists.
+// At ~6 KB a feed this is allocated only for configured URLs (see
+// syncCalendarFeeds), so a single calendar does not pay for three.
+struct CalendarFeed {
+  ICalEventCache cache;
+  ICalTopKN<CALENDAR_MAX_EVENTS> events;
+};
+CalendarFeed* calendarFeeds[CALENDAR_MAX_FEEDS];
+
+// One parser for every feed: each fetch points it at that feed's cache and
+// TLS session
+ICalParser calendarParser;
 
 // ============================================================================
-// WIFI CREDENTIALS (EEPROM)
+// CONNECTION REUSE
 // ============================================================================
 
+// Plain HTTP endpoints keep one client and HTTPClient each, so repeated
+// requests to the same host reuse the kept-alive TCP connection. TLS hosts
+// keep a BearSSL session instead, so the next connect is an abbreviated
+// handshake; their connections are closed after each fetch to free the
+// BearSSL buffers (they are only fetched hourly and may redirect).
+const unsigned long KEEPALIVE_IDLE_TIME = 60000;  // Close idle kept-alive sockets
+
+struct HttpEndpoint {
+  const char* name;
+  WiFiClient client;
+  HTTPClient http;
+  unsigned long lastUsed;
+};
+
+HttpEndpoint weatherEndpoint = {"weather"};
+HttpEndpoint stockEndpoint = {"stock"};
+
+#define TLS_SESSION_HOSTS 2
+#define MAX_HOST_LEN 64
+
+struct TlsSessionSlot {
+  char host[MAX_HOST_LEN];
+  unsigned long lastUsed;
+  BearSSL::Session session;
+};
+TlsSessionSlot tlsSessions[TLS_SESSION_HOSTS];
+
+// Splits "http(s)://host[:port]/..." into host and port
+bool parseUrlHost(const char* url, char* host, size_t hostSize, uint16_t* port) {
+  const char* start = strstr(url, "://");
+  *port = (strncmp(url, "https:", 6) == 0) ? 443 : 80;
+  start = start ? start + 3 : url;
+  size_t len = strcspn(start, ":/?");
+  if (len == 0 || len >= hostSize) return false;
+  memcpy(host, start, len);
+  host[len] = '\0';
+  if (start[len] == ':') *port = (uint16_t)atoi(start + len + 1);
+  return true;
+}
+
+// Session for host, recycling the least recently used slot for a new host.
+// known is set if the host was seen before, i.e. resumption will be offered.
+BearSSL::Session* tlsSessionFor(const char* host, bool* known) {
+  TlsSessionSlot* lru = &tlsSessions[0];
+  *known = false;
+  for (int i = 0; i < TLS_SESSION_HOSTS; i++) {
+    if (strcmp(tlsSessions[i].host, host) == 0) {
+      tlsSessions[i].lastUsed = millis();
+      *known = true;
+      return &tlsSessions[i].session;
+    }
+    if (tlsSessions[i].lastUsed < lru->lastUsed) lru = &tlsSessions[i];
+  }
+  strncpy(lru->host, host, MAX_HOST_LEN - 1);
+  lru->host[MAX_HOST_LEN - 1] = '\0';
+  lru->session = BearSSL::Session();
+  lru->lastUsed = millis();
+  return &lru->session;
+}
+
+// requestMs is the GET() itself: connecting (unless reused), sending the
+// request and reading the response headers
+void logFetchTiming(const char* name, unsigned long requestMs, const char* how, unsigned long startedAt) {
+  comm.debugf("%s: GET %lu ms (%s), total %lu ms", name, requestMs, how, millis() - startedAt);
+}
+
+// Close kept-alive sockets nobody has used for a while
+void closeIdleConnections() {
+  unsigned long now = millis();
+  HttpEndpoint* endpoints[] = {&weatherEndpoint, &stockEndpoint};
+  for (HttpEndpoint* endpoint : endpoints) {
+    if (endpoint->client.connected() && now - endpoint->lastUsed > KEEPALIVE_IDLE_TIME) {
+      endpoint->client.stop();
+    }
+  }
+}
+
+// GET url on a kept-alive endpoint; on 200 the body is returned in payload
+int keepAliveGet(HttpEndpoint& endpoint, const String& url, String& payload) {
+  unsigned long startedAt = millis();
+  endpoint.lastUsed = startedAt;
+
+  endpoint.http.setReuse(true);
+  endpoint.http.begin(endpoint.client, url);
+  // end() leaves the socket open only if the server kept it alive, and
+  // GET() reuses any socket still open
+  bool reused = endpoint.client.connected();
+  int httpCode = endpoint.http.GET();
+  unsigned long requestMs = millis() - startedAt;
+  if (httpCode < 0) {
+    comm.debugf("%s: %s", endpoint.name, endpoint.http.errorToString(httpCode).c_str());
+  }
+  if (httpCode == 200) {
+    payload = endpoint.http.getString();
+  }
+  endpoint.http.end();  // Keeps the socket open if the server allows it
+  logFetchTiming(endpoint.name, requestMs, reused ? "kept alive" : "new connection", startedAt);
+  return httpCode;
+}
+
+// ============================================================================
+// PERSISTENT CACHE (LittleFS)
+// ============================================================================
+
+// Last good results survive a reset so the STM32 can be answered at once,
+// marked stale, while fresh data is fetched. Each file starts with the NTP
+// epoch it was saved at, followed by a newline and the payload.
+const char* WEATHER_CACHE_FILE = "/weather.txt";
+const char* BALANCE_CACHE_FILE = "/balance.txt";
+const char* CALENDAR_CACHE_FILES[CALENDAR_MAX_FEEDS] = {"/calendar.bin", "/calendar2.bin", "/calendar3.bin"};
+
+bool cacheFsMounted = false;
+
+File openCacheFileForWrite(const char* path) {
+  File f = LittleFS.open(path, "w");
+  if (f) {
+    f.printf("%lu\n", (unsigned long)timeClient.getEpochTime());
+  }
+  return f;
+}
+
+// Opens path and skips the timestamp line; returns a closed File on failure
+File openCacheFileForRead(const char* path, unsigned long* savedAt) {
+  File f = LittleFS.open(path, "r");
+  if (f) {
+    *savedAt = strtoul(f.readStringUntil('\n').c_str(), nullptr, 10);
+  }
+  return f;
+}
+
+void persistText(const char* path, const String& data) {
+  if (!cacheFsMounted) return;
+  File f = openCacheFileForWrite(path);
+  if (f) {
+    f.print(data);
+    f.close();
+  }
+}
+
+void persistCalendar(int feed) {
+  if (!cacheFsMounted) return;
+  File f = openCacheFileForWrite(CALENDAR_CACHE_FILES[feed]);
+  if (f) {
+    bool ok = calendarFeeds[feed]->cache.save(f);
+    f.close();
+    if (!ok) LittleFS.remove(CALENDAR_CACHE_FILES[feed]);
+  }
+}
+
+void loadPersistedCache() {
+  unsigned long savedAt = 0;
+
+  File f = openCacheFileForRead(WEATHER_CACHE_FILE, &savedAt);
+  if (f) {
+    cache.weatherLocation = f.readStringUntil('\n');
+    cache.weatherData = f.readString();
+    cache.weatherStale = cache.weatherData.startsWith("WEATHER:");
+    if (!cache.weatherStale) cache.weatherData = "";
+    f.close();
+    comm.debugf("Restored weather saved at %lu", savedAt);
+  }
+
+  f = openCacheFileForRead(BALANCE_CACHE_FILE, &savedAt);
+  if (f) {
+    cache.balance = f.readString().toInt();
+    cache.balanceStale = cache.balance >= 0;
+    f.close();
+    comm.debugf("Restored balance saved at %lu", savedAt);
+  }
+}
+
+// Calendars are restored as their feeds get state, once settings are loaded
+void restoreCalendar(int feed) {
+  if (!cacheFsMounted) return;
+  unsigned long savedAt = 0;
+  File f = openCacheFileForRead(CALENDAR_CACHE_FILES[feed], &savedAt);
+  if (f) {
+    if (calendarFeeds[feed]->cache.load(f)) {
+      comm.debugf("Restored %d events of calendar %d saved at %lu", calendarFeeds[feed]->cache.count(), feed + 1,
+                  savedAt);
+    }
+    f.close();
+  }
+}
+
+void mountCacheFs() {
+  cacheFsMounted = LittleFS.begin();
+  if (!cacheFsMounted) {
+    comm.debug("LittleFS mount failed, formatting...");
+    cacheFsMounted = LittleFS.format() && LittleFS.begin();
+  }
+  if (cacheFsMounted) {
+    loadPersistedCache();
+  }
+}
+
+// ============================================================================
+// SETTINGS (EEPROM)
+// ============================================================================
+
+uint32_t settingsCrc32(uint32_t crc, const uint8_t* data, size_t len) {
+  while (len--) {
+    crc ^= *data++;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+  }
+  return crc;
+}
+
+uint32_t settingRecordCrc(uint8_t id, const uint8_t* value, uint16_t length) {
+  uint8_t prefix[3] = {id, (uint8_t)(length & 0xFF), (uint8_t)(length >> 8)};
+  return ~settingsCrc32(settingsCrc32(0xFFFFFFFFUL, prefix, sizeof(prefix)), value, length);
+}
+
+size_t settingOffset(size_t index) {
+  size_t offset = sizeof(SettingsHeader);
+  for (size_t i = 0; i < index; i++) {
+    offset += sizeof(SettingRecordHeader) + settingSlots[i].capacity;
+  }
+  return offset;
+}
+
+int settingIndex(SettingId id) {
+  for (size_t i = 0; i < SETTING_COUNT; i++) {
+    if (settingSlots[i].id == id) return i;
+  }
+  return -1;
+}
+
+// Copies a record into its variable if it checks out; otherwise the
+// variable keeps its default
+bool loadSetting(size_t index) {
+  const SettingSlot& slot = settingSlots[index];
+  size_t offset = settingOffset(index);
+  SettingRecordHeader header;
+  EEPROM.get(offset, header);
+  if (header.id != slot.id || header.length > slot.capacity) return false;
+
+  const uint8_t* value = EEPROM.getConstDataPtr() + offset + sizeof(header);
+  if (settingRecordCrc(header.id, value, header.length) != header.crc) return false;
+
+  memcpy(slot.value, value, header.length);
+  slot.value[header.length] = '\0';
+  return true;
+}
+
+// Writes a record into the EEPROM buffer; returns false if it was unchanged
+bool storeSetting(size_t index) {
+  const SettingSlot& slot = settingSlots[index];
+  size_t offset = settingOffset(index);
+  SettingRecordHeader header = {};
+  header.id = slot.id;
+  header.length = strnlen(slot.value, slot.capacity);
+  header.crc = settingRecordCrc(header.id, (const uint8_t*)slot.value, header.length);
+
+  SettingRecordHeader stored;
+  EEPROM.get(offset, stored);
+  const uint8_t* storedValue = EEPROM.getConstDataPtr() + offset + sizeof(header);
+  if (memcmp(&stored, &header, sizeof(header)) == 0 &&
+      memcmp(storedValue, slot.value, header.length) == 0) {
+    return false;
+  }
+
+  EEPROM.put(offset, header);
+  for (uint16_t i = 0; i < header.length; i++) {
+    EEPROM.write(offset + sizeof(header) + i, slot.value[i]);
+  }
+  return true;
+}
+
+void commitSettings() {
+  SettingsHeader header = {SETTINGS_MAGIC, SETTINGS_VERSION, (uint16_t)SETTING_COUNT};
+  EEPROM.put(0, header);
+  EEPROM.commit();
+}
+
+// Persist one setting after its variable changed; the flash sector is only
+// rewritten if the record actually differs from what is stored
+void saveSetting(SettingId id) {
+  int index = settingIndex(id);
+  if (index < 0) return;
+  if (storeSetting(index)) {
+    commitSettings();
+    comm.debugf("Setting %d saved", id);
+  }
+}
+
+// Layout used before the settings records: WiFi credentials only
 uint8_t calculateChecksum(const WiFiCredentials& creds) {
   uint8_t sum = 0;
   const uint8_t* data = (const uint8_t*)&creds;
@@ -118,26 +511,42 @@ uint8_t calculateChecksum(const WiFiCredentials& creds) {
   return sum;
 }
 
-bool loadWiFiCredentials() {
-  EEPROM.get(0, wifiCreds);
-  if (wifiCreds.magic != EEPROM_MAGIC) return false;
-  if (calculateChecksum(wifiCreds) != wifiCreds.checksum) return false;
+bool loadLegacyWiFiCredentials() {
+  WiFiCredentials legacy;
+  EEPROM.get(0, legacy);
+  if (legacy.magic != EEPROM_MAGIC) return false;
+  if (calculateChecksum(legacy) != legacy.checksum) return false;
+  legacy.ssid[MAX_SSID_LEN] = '\0';
+  legacy.password[MAX_PASS_LEN] = '\0';
+  strcpy(wifiCreds.ssid, legacy.ssid);
+  strcpy(wifiCreds.password, legacy.password);
   return true;
 }
 
-void saveWiFiCredentials(const char* ssid, const char* password) {
-  wifiCreds.magic = EEPROM_MAGIC;
-  strncpy(wifiCreds.ssid, ssid, MAX_SSID_LEN);
-  wifiCreds.ssid[MAX_SSID_LEN] = '\0';
-  strncpy(wifiCreds.password, password, MAX_PASS_LEN);
-  wifiCreds.password[MAX_PASS_LEN] = '\0';
-  wifiCreds.checksum = calculateChecksum(wifiCreds);
-  EEPROM.put(0, wifiCreds);
-  EEPROM.commit();
+// Call after EEPROM.begin() with every variable set to its default
+void loadSettings() {
+  SettingsHeader header;
+  EEPROM.get(0, header);
+  if (header.magic != SETTINGS_MAGIC || header.version != SETTINGS_VERSION) {
+    if (loadLegacyWiFiCredentials()) {
+      comm.debug("Migrating WiFi credentials to settings records");
+      for (size_t i = 0; i < SETTING_COUNT; i++) {
+        storeSetting(i);
+      }
+      commitSettings();
+    }
+    return;
+  }
+
+  int loaded = 0;
+  for (size_t i = 0; i < SETTING_COUNT && i < header.recordCount; i++) {
+    if (loadSetting(i)) loaded++;
+  }
+  comm.debugf("Loaded %d of %d settings", loaded, (int)SETTING_COUNT);
 }
 
 // ============================================================================
-// GCP CREDENTIALS (RAM only)
+// GCP CREDENTIALS
 // ============================================================================
 
 void tryInitGSheet() {
@@ -169,12 +578,78 @@ void tryInitGSheet() {
 // WIFI CONNECTION (NON-BLOCKING)
 // ============================================================================
 
+// The AP and DHCP lease of the last association are kept in RTC user
+// memory: it survives resets (not power loss) and costs no flash writes.
+// With them the next connect skips the channel scan and DHCP, joining the
+// known BSSID directly with the old lease as static config. A DHCP server
+// normally hands the same client its lease back, and any failure falls
+// back to a full scan with DHCP.
+#define WIFI_FAST_RTC_OFFSET 32  // 4-byte blocks; the first 128 bytes are eboot's (OTA)
+
+struct WiFiFastConnect {
+  uint32_t crc;
+  uint32_t credsCrc;  // Only valid for the credentials it was learned with
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t reserved;
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns1;
+  uint32_t dns2;
+};
+
+WiFiFastConnect wifiFast;
+
+uint32_t wifiCredsCrc() {
+  uint32_t crc = settingsCrc32(0xFFFFFFFFUL, (const uint8_t*)wifiCreds.ssid, strlen(wifiCreds.ssid) + 1);
+  return ~settingsCrc32(crc, (const uint8_t*)wifiCreds.password, strlen(wifiCreds.password));
+}
+
+uint32_t wifiFastCrc() {
+  return ~settingsCrc32(0xFFFFFFFFUL, (const uint8_t*)&wifiFast + sizeof(wifiFast.crc),
+                        sizeof(wifiFast) - sizeof(wifiFast.crc));
+}
+
+bool loadWiFiFastConnect() {
+  if (!ESP.rtcUserMemoryRead(WIFI_FAST_RTC_OFFSET, (uint32_t*)&wifiFast, sizeof(wifiFast))) return false;
+  return wifiFast.crc == wifiFastCrc() && wifiFast.credsCrc == wifiCredsCrc() && wifiFast.ip != 0;
+}
+
+void saveWiFiFastConnect() {
+  memset(&wifiFast, 0, sizeof(wifiFast));
+  wifiFast.credsCrc = wifiCredsCrc();
+  memcpy(wifiFast.bssid, WiFi.BSSID(), sizeof(wifiFast.bssid));
+  wifiFast.channel = WiFi.channel();
+  wifiFast.ip = WiFi.localIP();
+  wifiFast.gateway = WiFi.gatewayIP();
+  wifiFast.subnet = WiFi.subnetMask();
+  wifiFast.dns1 = WiFi.dnsIP(0);
+  wifiFast.dns2 = WiFi.dnsIP(1);
+  wifiFast.crc = wifiFastCrc();
+  ESP.rtcUserMemoryWrite(WIFI_FAST_RTC_OFFSET, (uint32_t*)&wifiFast, sizeof(wifiFast));
+}
+
+void clearWiFiFastConnect() {
+  memset(&wifiFast, 0, sizeof(wifiFast));
+  ESP.rtcUserMemoryWrite(WIFI_FAST_RTC_OFFSET, (uint32_t*)&wifiFast, sizeof(wifiFast));
+}
+
 void startWiFiConnect() {
   if (wifiState == WIFI_CONNECTING) return;
 
-  comm.debugf("Starting WiFi connection to: %s", wifiCreds.ssid);
   WiFi.mode(WIFI_STA);
-  WiFi.begin(wifiCreds.ssid, wifiCreds.password);
+  wifiConnectFast = loadWiFiFastConnect();
+  if (wifiConnectFast) {
+    comm.debugf("Starting fast WiFi connection to: %s (channel %d)", wifiCreds.ssid, wifiFast.channel);
+    WiFi.config(IPAddress(wifiFast.ip), IPAddress(wifiFast.gateway), IPAddress(wifiFast.subnet),
+                IPAddress(wifiFast.dns1), IPAddress(wifiFast.dns2));
+    WiFi.begin(wifiCreds.ssid, wifiCreds.password, wifiFast.channel, wifiFast.bssid);
+  } else {
+    comm.debugf("Starting WiFi connection to: %s", wifiCreds.ssid);
+    WiFi.config(IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0), IPAddress(0, 0, 0, 0));  // DHCP
+    WiFi.begin(wifiCreds.ssid, wifiCreds.password);
+  }
 
   wifiState = WIFI_CONNECTING;
   wifiConnectStartTime = millis();
@@ -196,7 +671,18 @@ void handleAppWiFiState() {
         lastWifiCheck = now;
         if (WiFi.status() == WL_CONNECTED) {
           wifiState = WIFI_CONNECTED;
-          comm.debugf("WiFi connected, IP: %s", WiFi.localIP().toString().c_str());
+          wifiAssocMs = now - wifiConnectStartTime;
+          wifiAssocFast = wifiConnectFast;
+          comm.debugf("WiFi connected (%s) in %lu ms, IP: %s", wifiAssocFast ? "fast" : "full scan",
+                      wifiAssocMs, WiFi.localIP().toString().c_str());
+          if (!wifiConnectFast) saveWiFiFastConnect();
+        } else if (wifiConnectFast && now - wifiConnectStartTime >= WIFI_FAST_CONNECT_TIMEOUT) {
+          // AP moved, changed channel or dropped the lease: forget it and scan
+          comm.debug("Fast WiFi connect failed, falling back to full scan");
+          clearWiFiFastConnect();
+          WiFi.disconnect();
+          wifiState = WIFI_IDLE;
+          startWiFiConnect();
         } else if (now - wifiConnectStartTime >= WIFI_CONNECT_TIMEOUT) {
           wifiState = WIFI_IDLE;
           comm.debug("WiFi connection timeout");
@@ -252,10 +738,19 @@ void handleWifiCommand(const char* params) {
     return;
   }
 
+  // Same network pushed again (the STM32 does so on every boot): keep the
+  // connection instead of dropping it
+  if (strcmp(ssid, wifiCreds.ssid) == 0 && strcmp(password, wifiCreds.password) == 0 &&
+      wifiState != WIFI_IDLE) {
+    comm.sendOK();
+    return;
+  }
+
   // Save and reconnect
-  saveWiFiCredentials(ssid, password);
-  strncpy(wifiCreds.ssid, ssid, MAX_SSID_LEN);
-  strncpy(wifiCreds.password, password, MAX_PASS_LEN);
+  strcpy(wifiCreds.ssid, ssid);
+  strcpy(wifiCreds.password, password);
+  saveSetting(SETTING_WIFI_SSID);
+  saveSetting(SETTING_WIFI_PASSWORD);
 
   WiFi.disconnect();
   wifiState = WIFI_IDLE;
@@ -278,7 +773,10 @@ void handleStatusCommand(const char* params) {
   }
 
   if (WiFi.status() == WL_CONNECTED) {
-    comm.sendf("STATUS:CONNECTED,%s,%d,%s", WiFi.localIP().toString().c_str(), WiFi.RSSI(), gsheetStatus);
+    // Trailing fields: how long the last association took and whether it
+    // used the cached AP (FAST) or a full scan with DHCP (FULL)
+    comm.sendf("STATUS:CONNECTED,%s,%d,%s,%lu,%s", WiFi.localIP().toString().c_str(), WiFi.RSSI(),
+               gsheetStatus, wifiAssocMs, wifiAssocFast ? "FAST" : "FULL");
   } else if (wifiState == WIFI_CONNECTING) {
     comm.sendf("STATUS:CONNECTING,%s", gsheetStatus);
   } else {
@@ -286,29 +784,47 @@ void handleStatusCommand(const char* params) {
   }
 }
 
+// Answered from the local clock; SNTP runs in the background from loop().
+// Until the first reply the STM32 gets NTP_FAILED and retries.
 void handleTimeCommand(const char* params) {
   (void)params;
-  if (!timeClient.isTimeSet()) {
-    timeClient.forceUpdate();
-  }
-
   if (!timeClient.isTimeSet()) {
     comm.sendError("NTP_FAILED");
     return;
   }
 
-  unsigned long epochTime = timeClient.getEpochTime();
-  time_t rawTime = epochTime;
+  uint64_t epochMs = timeClient.epochMs();
+  time_t rawTime = (time_t)(epochMs / 1000);
   struct tm* timeInfo = gmtime(&rawTime);
 
-  comm.sendf("TIME:%04d-%02d-%02dT%02d:%02d:%02dZ",
+  comm.sendf("TIME:%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
              timeInfo->tm_year + 1900, timeInfo->tm_mon + 1, timeInfo->tm_mday,
-             timeInfo->tm_hour, timeInfo->tm_min, timeInfo->tm_sec);
+             timeInfo->tm_hour, timeInfo->tm_min, timeInfo->tm_sec, (int)(epochMs % 1000));
+}
+
+bool fetchWeather(char* error, size_t errorSize);
+
+// Key the persisted weather is stored under ("city,country")
+String currentWeatherLocation() {
+  return String(weatherCity) + "," + weatherCountry;
 }
 
 void handleWeatherCommand(const char* params) {
   (void)params;
 
+  // Restored after a reset: answer now, loop() fetches and pushes fresh data.
+  // Data saved for another location is dropped and fetched instead.
+  if (cache.weatherStale) {
+    if (cache.weatherLocation == currentWeatherLocation()) {
+      comm.sendf("%s,STALE", cache.weatherData.c_str());
+      refreshPending.weather = true;
+      return;
+    }
+    cache.weatherData = "";
+    cache.weatherStale = false;
+    cache.lastWeatherUpdate = 0;
+  }
+
   // Check cache
   unsigned long now = millis();
   if (cache.weatherData.length() > 0 &&
@@ -317,15 +833,26 @@ void handleWeatherCommand(const char* params) {
     return;
   }
 
+  char error[24];
+  if (!fetchWeather(error, sizeof(error))) {
+    comm.sendError(error);
+  }
+}
+
+// Fetches the forecast and sends the WEATHER reply. On failure nothing is
+// sent and error names the reason.
+bool fetchWeather(char* error, size_t errorSize) {
+  unsigned long now = millis();
+
   if (WiFi.status() != WL_CONNECTED) {
-    comm.sendError("NO_WIFI");
-    return;
+    snprintf(error, errorSize, "NO_WIFI");
+    return false;
   }
 
   // Check if weather API key is configured
   if (strlen(weatherApiKey) == 0 || strcmp(weatherApiKey, "your_api_key_here") == 0) {
-    comm.sendError("WEATHER_API_KEY_NOT_SET");
-    return;
+    snprintf(error, errorSize, "WEATHER_API_KEY_NOT_SET");
+    return false;
   }
 
   // Use forecast API to get precipitation probability (pop)
@@ -337,27 +864,21 @@ void handleWeatherCommand(const char* params) {
   url += weatherApiKey;
   url += "&units=metric&cnt=1";  // Only get first forecast period
 
-  WiFiClient client;
-  HTTPClient http;
-  http.begin(client, url);
-  int httpCode = http.GET();
+  String payload;
+  int httpCode = keepAliveGet(weatherEndpoint, url, payload);
 
   if (httpCode != 200) {
-    http.end();
-    comm.sendf("ERROR:HTTP_%d", httpCode);
-    return;
+    snprintf(error, errorSize, "HTTP_%d", httpCode);
+    return false;
   }
 
-  String payload = http.getString();
-  http.end();
-
   // Forecast API response is larger than current weather API
   StaticJsonDocument<2048> doc;
   DeserializationError err = deserializeJson(doc, payload);
   if (err) {
     comm.debugf("JSON parse error: %s", err.c_str());
-    comm.sendError("JSON_PARSE");
-    return;
+    snprintf(error, errorSize, "JSON_PARSE");
+    return false;
   }
 
   // Forecast API returns data in list[0] for first period
@@ -371,13 +892,22 @@ void handleWeatherCommand(const char* params) {
   float pop = forecast["pop"] | 0.0;
   int precip_chance = (int)(pop * 100);
 
-  String response = "WEATHER:";
-  response += String(temp_f) + "," + String((int)temp_c) + "," + String(condition) + "," + String(humidity) + "," + String(precip_chance);
+  comm.beginResponse("WEATHER:")
+      .appendInt(temp_f).appendChar(',')
+      .appendInt((int)temp_c).appendChar(',')
+      .append(condition).appendChar(',')
+      .appendInt(humidity).appendChar(',')
+      .appendInt(precip_chance);
 
-  cache.weatherData = response;
+  if (cache.weatherData != comm.response()) {
+    persistText(WEATHER_CACHE_FILE, currentWeatherLocation() + "\n" + comm.response());
+  }
+  cache.weatherData = comm.response();
+  cache.weatherStale = false;
   cache.lastWeatherUpdate = now;
 
-  comm.send(response.c_str());
+  comm.endResponse();
+  return true;
 }
 
 void handleStockCommand(const char* params) {
@@ -402,20 +932,14 @@ void handleStockCommand(const char* params) {
   url += "&apikey=";
   url += STOCK_API_KEY;
 
-  WiFiClient client;
-  HTTPClient http;
-  http.begin(client, url);
-  int httpCode = http.GET();
+  String payload;
+  int httpCode = keepAliveGet(stockEndpoint, url, payload);
 
   if (httpCode != 200) {
-    http.end();
     comm.sendf("ERROR:HTTP_%d", httpCode);
     return;
   }
 
-  String payload = http.getString();
-  http.end();
-
   StaticJsonDocument<1024> doc;
   if (deserializeJson(doc, payload)) {
     comm.sendError("JSON_PARSE");
@@ -429,34 +953,63 @@ void handleStockCommand(const char* params) {
   }
 
   float price = atof(priceStr);
-  String response = "STOCK:" + symbol + ":" + String(price, 2);
+  comm.beginResponse("STOCK:").append(symbol.c_str()).appendChar(':').appendFloat(price, 2);
 
   cache.stockSymbol = symbol;
-  cache.stockData = response;
+  cache.stockData = comm.response();
   cache.lastStockUpdate = now;
 
-  comm.send(response.c_str());
+  comm.endResponse();
+}
+
+// Remember a freshly fetched balance, persisting it if it changed
+void storeBalance(int balance) {
+  if (balance != cache.balance) {
+    persistText(BALANCE_CACHE_FILE, String(balance));
+  }
+  cache.balance = balance;
+  cache.balanceStale = false;
 }
 
+bool fetchBalance(char* error, size_t errorSize);
+
 void handleBalanceCommand(const char* params) {
   (void)params;
 
-  if (!gsheetInitialized) {
-    comm.sendError("GSHEET_NOT_INIT");
+  // Restored after a reset: answer now, loop() fetches and pushes fresh data
+  if (cache.balanceStale) {
+    comm.sendf("BALANCE:%d,STALE", cache.balance);
+    refreshPending.balance = true;
     return;
   }
 
+  char error[24];
+  if (!fetchBalance(error, sizeof(error))) {
+    comm.sendError(error);
+  }
+}
+
+// Queries the sheet and sends the BALANCE reply. On failure nothing is sent
+// and error names the reason.
+bool fetchBalance(char* error, size_t errorSize) {
+  if (!gsheetInitialized) {
+    snprintf(error, errorSize, "GSHEET_NOT_INIT");
+    return false;
+  }
+
   if (!GSheet.ready()) {
-    comm.sendError("GSHEET_NOT_READY");
-    return;
+    snprintf(error, errorSize, "GSHEET_NOT_READY");
+    return false;
   }
 
   int balance = getBalance();
-  if (balance >= 0) {
-    comm.sendf("BALANCE:%d", balance);
-  } else {
-    comm.sendError("BALANCE_QUERY_FAILED");
+  if (balance < 0) {
+    snprintf(error, errorSize, "BALANCE_QUERY_FAILED");
+    return false;
   }
+  storeBalance(balance);
+  comm.sendf("BALANCE:%d", balance);
+  return true;
 }
 
 void handleGCPProjectCommand(const char* params) {
@@ -466,6 +1019,7 @@ void handleGCPProjectCommand(const char* params) {
   }
   strncpy(gcpCreds.project_id, params, MAX_PROJECT_ID_LEN);
   gcpCreds.project_id[MAX_PROJECT_ID_LEN] = '\0';
+  saveSetting(SETTING_GCP_PROJECT);
   tryInitGSheet();
   comm.sendOK();
 }
@@ -477,6 +1031,7 @@ void handleGCPEmailCommand(const char* params) {
   }
   strncpy(gcpCreds.client_email, params, MAX_EMAIL_LEN);
   gcpCreds.client_email[MAX_EMAIL_LEN] = '\0';
+  saveSetting(SETTING_GCP_EMAIL);
   tryInitGSheet();
   comm.sendOK();
 }
@@ -489,18 +1044,74 @@ void handleGCPKeyCommand(const char* params) {
   // Convert \n literals to actual newlines for PEM format
   stm32comm_unescapeNewlines(params, gcpCreds.private_key, MAX_PRIVATE_KEY_LEN + 1);
   comm.debugf("Private key converted, new len: %d", strlen(gcpCreds.private_key));
+  saveSetting(SETTING_GCP_KEY);
   tryInitGSheet();
   comm.sendOK();
 }
 
+// Feeds in use: the leading configured URLs that have state
+int calendarFeedCount() {
+  int count = 0;
+  while (count < CALENDAR_MAX_FEEDS && calendarUrls[count][0] && calendarFeeds[count]) count++;
+  return count;
+}
+
+// Give each configured URL its feed state and free the state of cleared
+// ones; a feed that gets state picks up what was persisted for it
+void syncCalendarFeeds() {
+  for (int i = 0; i < CALENDAR_MAX_FEEDS; i++) {
+    if (!calendarUrls[i][0]) {
+      delete calendarFeeds[i];
+      calendarFeeds[i] = nullptr;
+    } else if (!calendarFeeds[i]) {
+      calendarFeeds[i] = new (std::nothrow) CalendarFeed;
+      if (!calendarFeeds[i]) {
+        comm.debugf("No memory for calendar %d", i + 1);
+        continue;
+      }
+      restoreCalendar(i);
+    }
+  }
+  comm.debugf("Calendar feeds: %d of %d bytes each, free heap %d", calendarFeedCount(), (int)sizeof(CalendarFeed),
+              ESP.getFreeHeap());
+}
+
+// SET_CALENDAR_URL:url[ url...] - up to CALENDAR_MAX_FEEDS feeds separated
+// by spaces, merged into one CALENDAR reply
 void handleSetCalendarUrlCommand(const char* params) {
-  if (strlen(params) == 0 || strlen(params) > MAX_CALENDAR_URL_LEN) {
+  static char urls[CALENDAR_MAX_FEEDS][MAX_CALENDAR_URL_LEN + 1];  // Static to reduce stack usage
+  int count = 0;
+  const char* p = params;
+  for (;;) {
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p == '\0') break;
+    size_t len = strcspn(p, " \t");
+    if (count == CALENDAR_MAX_FEEDS) {
+      comm.sendError("TOO_MANY_CALENDAR_URLS");
+      return;
+    }
+    if (len > MAX_CALENDAR_URL_LEN) {
+      comm.sendError("INVALID_CALENDAR_URL");
+      return;
+    }
+    memcpy(urls[count], p, len);
+    urls[count][len] = '\0';
+    count++;
+    p += len;
+  }
+  if (count == 0) {
     comm.sendError("INVALID_CALENDAR_URL");
     return;
   }
-  strncpy(calendarUrl, params, MAX_CALENDAR_URL_LEN);
-  calendarUrl[MAX_CALENDAR_URL_LEN] = '\0';
-  comm.debugf("Calendar URL set, len: %d", strlen(calendarUrl));
+
+  static const SettingId slots[CALENDAR_MAX_FEEDS] = {SETTING_CALENDAR_URL, SETTING_CALENDAR_URL_2,
+                                                      SETTING_CALENDAR_URL_3};
+  for (int i = 0; i < CALENDAR_MAX_FEEDS; i++) {
+    strcpy(calendarUrls[i], i < count ? urls[i] : "");
+    saveSetting(slots[i]);
+  }
+  syncCalendarFeeds();
+  comm.debugf("Calendar URLs set: %d feeds", count);
   comm.sendOK();
 }
 
@@ -509,11 +1120,16 @@ void handleSetWeatherApiKeyCommand(const char* params) {
     comm.sendError("INVALID_WEATHER_API_KEY");
     return;
   }
+  bool changed = strcmp(weatherApiKey, params) != 0;
   strncpy(weatherApiKey, params, MAX_WEATHER_API_KEY_LEN);
   weatherApiKey[MAX_WEATHER_API_KEY_LEN] = '\0';
-  // Clear weather cache when API key changes
-  cache.weatherData = "";
-  cache.lastWeatherUpdate = 0;
+  saveSetting(SETTING_WEATHER_API_KEY);
+  // Clear weather cache when API key changes (restored data is kept until
+  // refreshed: it does not depend on the key)
+  if (changed && !cache.weatherStale) {
+    cache.weatherData = "";
+    cache.lastWeatherUpdate = 0;
+  }
   comm.debugf("Weather API key set, len: %d", strlen(weatherApiKey));
   comm.sendOK();
 }
@@ -536,253 +1152,210 @@ void handleSetWeatherLocationCommand(const char* params) {
     return;
   }
 
+  bool changed = strcmp(weatherCity, city) != 0 || strcmp(weatherCountry, country) != 0;
   strncpy(weatherCity, city, MAX_WEATHER_CITY_LEN);
   weatherCity[MAX_WEATHER_CITY_LEN] = '\0';
   strncpy(weatherCountry, country, MAX_WEATHER_COUNTRY_LEN);
   weatherCountry[MAX_WEATHER_COUNTRY_LEN] = '\0';
-
-  // Clear weather cache when location changes
-  cache.weatherData = "";
-  cache.lastWeatherUpdate = 0;
+  saveSetting(SETTING_WEATHER_CITY);
+  saveSetting(SETTING_WEATHER_COUNTRY);
+
+  // Clear weather cache when location changes (restored data only survives
+  // if it was saved for this same location)
+  if (changed && (!cache.weatherStale || cache.weatherLocation != currentWeatherLocation())) {
+    cache.weatherData = "";
+    cache.weatherStale = false;
+    cache.lastWeatherUpdate = 0;
+  }
 
   comm.debugf("Weather location set: %s, %s", weatherCity, weatherCountry);
   comm.sendOK();
 }
 
+// Build response: CALENDAR:count,start|end|title;start|end|title;...
+// The feeds' lists are merged in start order as the reply is written. A
+// reply built from a restored cache, or missing a feed that could not be
+// fetched, gets a trailing ";STALE" (",STALE" when empty)
+void sendCalendarResponse(int feedCount, int maxEvents, bool stale = false) {
+  const ICalTopK* lists[CALENDAR_MAX_FEEDS];
+  for (int i = 0; i < feedCount; i++) {
+    lists[i] = &calendarFeeds[i]->events;
+  }
+  ICalMerge merge;
+  merge.begin(lists, feedCount);
+
+  int calEventCount = min(merge.remaining(), maxEvents);
+  if (calEventCount == 0) {
+    comm.send(stale ? "CALENDAR:0,STALE" : "CALENDAR:0");
+    return;
+  }
+
+  comm.beginResponse("CALENDAR:").appendInt(calEventCount);
+  char startStr[ICAL_DATETIME_LEN];
+  char endStr[ICAL_DATETIME_LEN];
+  const ICalTopK* list;
+  int index;
+  for (int i = 0; i < calEventCount && merge.next(&list, &index); i++) {
+    // Times are formatted only for the events that made the final list
+    ICalParser::formatDateTime(list->occurrence(index), startStr, sizeof(startStr));
+    ICalParser::formatDateTime(list->endOccurrence(index), endStr, sizeof(endStr));
+    comm.appendChar(i == 0 ? ',' : ';')
+        .append(startStr).appendChar('|')
+        .append(endStr).appendChar('|')
+        .append(list->title(index));
+  }
+  if (stale) comm.append(";STALE");
+  comm.endResponse();
+}
+
+// Re-expand one feed's cache for the current time into its event list
+void expandCachedFeed(int feed) {
+  CalendarFeed& f = *calendarFeeds[feed];
+  f.cache.expand(timeClient.getEpochTime(), &f.events, CALENDAR_HORIZON);
+}
+
+// Reply from every feed's cache; false if none has one
+bool sendCachedCalendar(int feedCount, int maxEvents) {
+  bool any = false;
+  bool stale = false;
+  for (int i = 0; i < feedCount; i++) {
+    CalendarFeed& f = *calendarFeeds[i];
+    f.events.begin(maxEvents);
+    if (f.cache.validFor(calendarUrls[i])) {
+      expandCachedFeed(i);
+      any = true;
+      stale = stale || f.cache.stale();
+    } else {
+      stale = true;
+    }
+    f.events.finish();
+  }
+  if (!any) return false;
+  comm.debug("Calendar answered from cache");
+  sendCalendarResponse(feedCount, maxEvents, stale);
+  return true;
+}
+
+bool fetchCalendar(int maxEvents, char* error, size_t errorSize);
+
 void handleCalendarCommand(const char* params) {
   // Parse optional event count parameter (default 10)
   int maxEvents = 10;
   if (params && strlen(params) > 0) {
     maxEvents = atoi(params);
     if (maxEvents < 1) maxEvents = 1;
-    if (maxEvents > 20) maxEvents = 20;
+    if (maxEvents > CALENDAR_MAX_EVENTS) maxEvents = CALENDAR_MAX_EVENTS;
   }
 
-  if (strlen(calendarUrl) == 0) {
+  int feedCount = calendarFeedCount();
+  if (feedCount == 0) {
     comm.sendError("CALENDAR_URL_NOT_SET");
     return;
   }
 
-  if (WiFi.status() != WL_CONNECTED) {
-    comm.sendError("NO_WIFI");
-    return;
+  // Restored after a reset: answer now, loop() fetches and pushes fresh data.
+  // Needs NTP time, as the cached events are re-expanded for "now".
+  bool restored = false;
+  for (int i = 0; i < feedCount; i++) {
+    restored = restored || (calendarFeeds[i]->cache.stale() && calendarFeeds[i]->cache.validFor(calendarUrls[i]));
   }
-
-  comm.debug("Fetching calendar...");
-  comm.debugf("Free heap: %d", ESP.getFreeHeap());
-
-  WiFiClientSecure client;
-  client.setInsecure();
-  client.setBufferSizes(4096, 512);
-
-  HTTPClient http;
-  http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-  http.setRedirectLimit(5);
-  http.setTimeout(15000);
-
-  if (!http.begin(client, calendarUrl)) {
-    comm.sendError("HTTP_BEGIN_FAILED");
+  if (restored && timeClient.isTimeSet() && sendCachedCalendar(feedCount, maxEvents)) {
+    refreshPending.calendar = true;
+    refreshPending.calendarEvents = maxEvents;
     return;
   }
 
-  http.addHeader("User-Agent", "ESP8266");
-  http.addHeader("Accept", "*/*");
-
-  comm.debug("Sending request...");
-  int httpCode = http.GET();
-  comm.debugf("HTTP code: %d", httpCode);
+  char error[24];
+  if (!fetchCalendar(maxEvents, error, sizeof(error))) {
+    comm.sendError(error);
+  }
+}
 
-  if (httpCode != 200) {
-    http.end();
-    comm.sendf("ERROR:HTTP_%d", httpCode);
-    return;
+// Brings one feed's event list up to date through the library fetch: from
+// its cache while that is fresh or the server answers 304 (ETag /
+// Last-Modified unchanged), otherwise by downloading and parsing it. On
+// failure error names the reason.
+bool fetchCalendarFeed(int feed, const char** source, char* error, size_t errorSize) {
+  CalendarFeed& f = *calendarFeeds[feed];
+  const char* url = calendarUrls[feed];
+
+  // Offer the last session with this host for an abbreviated handshake
+  char host[MAX_HOST_LEN];
+  uint16_t port;
+  bool sessionKnown = false;
+  BearSSL::Session* session = nullptr;
+  if (parseUrlHost(url, host, sizeof(host), &port)) {
+    session = tlsSessionFor(host, &sessionKnown);
   }
 
-  // Stream the response to avoid memory issues
-  WiFiClient* stream = http.getStreamPtr();
-  time_t now = timeClient.getEpochTime();
-
-  // Use static storage to reduce stack usage (reduced from 20 to save memory)
-  static ICalEvent calEvents[12];
-  int calEventCount = 0;
-  if (maxEvents > 12) maxEvents = 12;
-
-  // Use static buffers instead of String to reduce heap fragmentation
-  static char lineBuf[257];
-  static char currentDtStart[32];
-  static char currentDtEnd[32];
-  static char currentSummary[ICAL_MAX_TITLE_LEN];
-  static char currentRRule[128];
-  int lineLen = 0;
-  currentDtStart[0] = '\0';
-  currentDtEnd[0] = '\0';
-  currentSummary[0] = '\0';
-  currentRRule[0] = '\0';
-  bool inEvent = false;
-  bool currentCancelled = false;
-  bool hasRecurrenceId = false;
-
-  comm.debugf("Parsing (max %d events)...", maxEvents);
-  yield();  // Prevent watchdog reset
-  comm.debugf("Heap before parse: %d", ESP.getFreeHeap());
-
-  unsigned long parseStart = millis();
-  unsigned long lastData = millis();
-  const unsigned long PARSE_TIMEOUT = 30000;
-  const unsigned long DATA_TIMEOUT = 5000;
-  int lineCount = 0;
-  int eventsSeen = 0;
-  int recurringCount = 0;
-
-  while (millis() - parseStart < PARSE_TIMEOUT) {
-    if (stream->available()) {
-      lastData = millis();
-      char c = stream->read();
-
-      if (c == '\n') {
-        lineBuf[lineLen] = '\0';
-        // Trim trailing whitespace
-        while (lineLen > 0 && (lineBuf[lineLen-1] == ' ' || lineBuf[lineLen-1] == '\t')) {
-          lineBuf[--lineLen] = '\0';
-        }
-        lineCount++;
-
-        if (strcmp(lineBuf, "BEGIN:VEVENT") == 0) {
-          inEvent = true;
-          currentDtStart[0] = '\0';
-          currentDtEnd[0] = '\0';
-          currentSummary[0] = '\0';
-          currentRRule[0] = '\0';
-          currentCancelled = false;
-          hasRecurrenceId = false;
-        } else if (strcmp(lineBuf, "END:VEVENT") == 0 && inEvent) {
-          inEvent = false;
-          eventsSeen++;
-
-          if (currentCancelled || hasRecurrenceId) {
-            lineLen = 0;
-            continue;
-          }
-
-          if (strlen(currentDtStart) > 0 && strlen(currentSummary) > 0) {
-            time_t dtstart = ICalParser::parseDate(currentDtStart);
-            time_t dtend = (strlen(currentDtEnd) > 0) ? ICalParser::parseDate(currentDtEnd) : dtstart;
-            time_t duration = dtend - dtstart;  // Duration in seconds
-
-            ICalRRule rule = ICalParser::parseRRule(currentRRule);
-
-            if (rule.freq != ICAL_FREQ_NONE) {
-              recurringCount++;
-            }
-
-            time_t nextOccur = ICalParser::getNextOccurrence(dtstart, rule, now);
-
-            if (nextOccur > 0) {
-              time_t endOccur = nextOccur + duration;  // Calculate end time
-
-              // Insert sorted
-              int insertIdx = calEventCount;
-              for (int i = 0; i < calEventCount; i++) {
-                if (nextOccur < calEvents[i].occurrence) {
-                  insertIdx = i;
-                  break;
-                }
-              }
-
-              if (insertIdx < maxEvents) {
-                int shiftEnd = (calEventCount < maxEvents) ? calEventCount : maxEvents - 1;
-                for (int i = shiftEnd; i > insertIdx; i--) {
-                  calEvents[i] = calEvents[i - 1];
-                }
-
-                calEvents[insertIdx].occurrence = nextOccur;
-                calEvents[insertIdx].endOccurrence = endOccur;
-
-                struct tm* tmInfo = localtime(&nextOccur);
-                snprintf(calEvents[insertIdx].datetime, 20, "%04d-%02d-%02d %02d:%02d",
-                         tmInfo->tm_year + 1900, tmInfo->tm_mon + 1, tmInfo->tm_mday,
-                         tmInfo->tm_hour, tmInfo->tm_min);
-
-                struct tm* endTmInfo = localtime(&endOccur);
-                snprintf(calEvents[insertIdx].endDatetime, 20, "%04d-%02d-%02d %02d:%02d",
-                         endTmInfo->tm_year + 1900, endTmInfo->tm_mon + 1, endTmInfo->tm_mday,
-                         endTmInfo->tm_hour, endTmInfo->tm_min);
-
-                strncpy(calEvents[insertIdx].title, currentSummary, ICAL_MAX_TITLE_LEN - 1);
-                calEvents[insertIdx].title[ICAL_MAX_TITLE_LEN - 1] = '\0';
-
-                if (calEventCount < maxEvents) calEventCount++;
-              }
-            }
-          }
-        } else if (inEvent) {
-          if (strncmp(lineBuf, "DTSTART", 7) == 0) {
-            char* colon = strchr(lineBuf, ':');
-            if (colon) {
-              strncpy(currentDtStart, colon + 1, sizeof(currentDtStart) - 1);
-              currentDtStart[sizeof(currentDtStart) - 1] = '\0';
-            }
-          } else if (strncmp(lineBuf, "DTEND", 5) == 0) {
-            char* colon = strchr(lineBuf, ':');
-            if (colon) {
-              strncpy(currentDtEnd, colon + 1, sizeof(currentDtEnd) - 1);
-              currentDtEnd[sizeof(currentDtEnd) - 1] = '\0';
-            }
-          } else if (strncmp(lineBuf, "SUMMARY:", 8) == 0) {
-            strncpy(currentSummary, lineBuf + 8, sizeof(currentSummary) - 1);
-            currentSummary[sizeof(currentSummary) - 1] = '\0';
-          } else if (strncmp(lineBuf, "RRULE:", 6) == 0) {
-            strncpy(currentRRule, lineBuf + 6, sizeof(currentRRule) - 1);
-            currentRRule[sizeof(currentRRule) - 1] = '\0';
-          } else if (strncmp(lineBuf, "STATUS:", 7) == 0) {
-            if (strstr(lineBuf, "CANCELLED") != nullptr) {
-              currentCancelled = true;
-            }
-          } else if (strncmp(lineBuf, "RECURRENCE-ID", 13) == 0) {
-            hasRecurrenceId = true;
-          }
-        }
+  calendarParser.setCache(&f.cache, CALENDAR_CACHE_TIME);
+  calendarParser.setTlsSession(session);
+  ICalResult result = calendarParser.fetch(url, timeClient.getEpochTime(), &f.events);
+  if (result.httpCode != 0) {
+    comm.debugf("Calendar %d: TLS %s", feed + 1, sessionKnown ? "resumption offered" : "full handshake");
+  }
 
-        lineLen = 0;
-        yield();
-      } else if (c != '\r') {
-        if (lineLen < 256) {
-          lineBuf[lineLen++] = c;
-        }
-      }
+  if (!result.success) {
+    if (result.httpCode != 0) {
+      snprintf(error, errorSize, "HTTP_%d", result.httpCode);
     } else {
-      if (millis() - lastData > DATA_TIMEOUT) {
-        comm.debug("Data timeout");
-        break;
-      }
-      if (!http.connected()) {
-        break;
-      }
-      yield();
-      delay(1);
+      snprintf(error, errorSize, "%s", result.errorMsg);
     }
+    return false;
   }
 
-  comm.debugf("Parsed %d lines, %d events (%d recurring)", lineCount, eventsSeen, recurringCount);
-  http.end();
-  comm.debugf("Found %d upcoming events", calEventCount);
-
-  // Build response: CALENDAR:count,start|end|title;start|end|title;...
-  if (calEventCount == 0) {
-    comm.send("CALENDAR:0");
+  if (result.fromCache) {
+    *source = result.httpCode == HTTP_CODE_NOT_MODIFIED ? "not modified" : "cached";
+  } else if (result.complete) {
+    persistCalendar(feed);
+    *source = "downloaded";
   } else {
-    String response = "CALENDAR:";
-    response += String(calEventCount);
-    for (int i = 0; i < calEventCount; i++) {
-      response += (i == 0) ? "," : ";";
-      response += calEvents[i].datetime;
-      response += "|";
-      response += calEvents[i].endDatetime;
-      response += "|";
-      response += calEvents[i].title;
+    *source = "downloaded, incomplete";
+  }
+  return true;
+}
+
+// Update every feed, one at a time so only one TLS connection is open, and
+// reply with their merged lists. Fails, sending nothing, only when no feed
+// has anything to show; error then names the first feed's reason.
+bool fetchCalendar(int maxEvents, char* error, size_t errorSize) {
+  int feedCount = calendarFeedCount();
+  bool stale = false;
+  int failed = 0;
+  error[0] = '\0';
+
+  for (int i = 0; i < feedCount; i++) {
+    CalendarFeed& f = *calendarFeeds[i];
+    // Each feed keeps its own earliest maxEvents; the merge takes the first
+    // maxEvents of all of them
+    f.events.begin(maxEvents);
+
+    unsigned long started = millis();
+    const char* source = "";
+    char feedError[24];
+    if (!fetchCalendarFeed(i, &source, feedError, sizeof(feedError))) {
+      // Keep what the feed had last time rather than dropping it from the reply
+      f.events.begin(maxEvents);
+      if (f.cache.validFor(calendarUrls[i])) {
+        expandCachedFeed(i);
+        source = "stale cache";
+      } else {
+        source = "missing";
+        failed++;
+        if (!error[0]) snprintf(error, errorSize, "%s", feedError);
+      }
+      stale = true;
+      comm.debugf("Calendar %d failed: %s", i + 1, feedError);
     }
-    comm.send(response.c_str());
+    f.events.finish();
+    comm.debugf("Calendar %d: %d upcoming (%s) in %lu ms", i + 1, f.events.count(), source, millis() - started);
   }
+
+  if (failed == feedCount) {
+    return false;
+  }
+  sendCalendarResponse(feedCount, maxEvents, stale);
+  return true;
 }
 
 // ============================================================================
@@ -801,6 +1374,8 @@ void setup() {
   // Initialize communication library
   comm.begin(Serial);
   comm.setDebugStream(Serial1);
+  calendarParser.setDebugCallback([](const char* message) { comm.debug(message); });
+  calendarParser.setHorizon(CALENDAR_HORIZON);
 
   // Register command handlers
   comm.onCommand("WIFI", handleWifiCommand);
@@ -817,17 +1392,23 @@ void setup() {
   comm.onCommand("GCP_EMAIL", handleGCPEmailCommand);
   comm.onCommand("GCP_KEY", handleGCPKeyCommand);
 
-  // Initialize EEPROM and credentials
+  // Restore last good weather/balance/calendar before anything asks for them
+  mountCacheFs();
+
+  // Initialize EEPROM and restore every setting over the defaults, so
+  // WiFi and GSheet can start without waiting for the STM32 to push config
   EEPROM.begin(EEPROM_SIZE);
   memset(&gcpCreds, 0, sizeof(gcpCreds));
-  memset(calendarUrl, 0, sizeof(calendarUrl));
-
-  if (!loadWiFiCredentials()) {
-    strncpy(wifiCreds.ssid, DEFAULT_WIFI_SSID, MAX_SSID_LEN);
-    strncpy(wifiCreds.password, DEFAULT_WIFI_PASSWORD, MAX_PASS_LEN);
-  }
-
-  // Start WiFi and NTP
+  memset(calendarUrls, 0, sizeof(calendarUrls));
+  strncpy(wifiCreds.ssid, DEFAULT_WIFI_SSID, MAX_SSID_LEN);
+  strncpy(wifiCreds.password, DEFAULT_WIFI_PASSWORD, MAX_PASS_LEN);
+  loadSettings();
+  syncCalendarFeeds();
+
+  // Start WiFi and NTP. The SDK's own copy of the WiFi config in flash is not
+  // needed (settings and the fast-connect cache are kept above), and would be
+  // rewritten on every begin() with a BSSID
+  WiFi.persistent(false);
   startWiFiConnect();
   timeClient.begin();
 
@@ -838,6 +1419,43 @@ void setup() {
 // MAIN LOOP
 // ============================================================================
 
+// Fetch and push fresh data for anything answered from the restored cache.
+// The STM32 accepts unsolicited replies, so they simply replace stale views.
+// An unsolicited ERROR would make it retry or restart its boot sequence, so
+// failures are only logged: the data stays stale and the next request for
+// it, answered from the cache again, schedules another attempt.
+void refreshStaleData() {
+  if (!refreshPending.weather && !refreshPending.balance && !refreshPending.calendar) return;
+  if (wifiState != WIFI_CONNECTED) return;
+
+  unsigned long now = millis();
+  if (refreshPending.lastAttempt != 0 && now - refreshPending.lastAttempt < STALE_REFRESH_INTERVAL) return;
+
+  // One blocking fetch per pass keeps comm.process() responsive
+  char error[24];
+  const char* what;
+  bool ok;
+  if (refreshPending.weather) {
+    refreshPending.weather = false;
+    what = "Weather";
+    ok = fetchWeather(error, sizeof(error));
+  } else if (refreshPending.calendar && timeClient.isTimeSet()) {
+    refreshPending.calendar = false;
+    what = "Calendar";
+    ok = fetchCalendar(refreshPending.calendarEvents, error, sizeof(error));
+  } else if (refreshPending.balance && gsheetInitialized && GSheet.ready()) {
+    refreshPending.balance = false;
+    what = "Balance";
+    ok = fetchBalance(error, sizeof(error));
+  } else {
+    return;
+  }
+  if (!ok) {
+    comm.debugf("%s refresh failed: %s", what, error);
+  }
+  refreshPending.lastAttempt = now;
+}
+
 void loop() {
   // Handle WiFi state machine
   handleAppWiFiState();
@@ -873,6 +1491,7 @@ void loop() {
         int balance = getBalance();
         if (balance >= 0) {
           comm.debugf("Balance: %d", balance);
+          storeBalance(balance);
           taskComplete = true;
         } else {
           comm.debug("getBalance failed, will retry...");
@@ -886,5 +1505,8 @@ void loop() {
     }
   }
 
+  refreshStaleData();
+  closeIdleConnections();
+
   yield();
 }
@@ -0,0 +1,237 @@
+// Host benchmark for the ESP8266 libraries: parses .ics feeds with
+// ICalParser::parseStream() and replays STM32 command transcripts through
+// STM32Comm, reporting throughput, peak heap and per-event cost.
+//
+//   bench_esp_libs [-n repeats] [file.ics | transcript.txt ...]
+//
+// With no files it runs the bundled corpus (tests/corpus). Heap is counted
+// through operator new, which is what the String shim allocates with.
+
+#include "ICalParser.h"
+#include "STM32Comm.h"
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NOW ((time_t)1768469400)  // 2026-01-15 09:30 UTC
+#define DEFAULT_REPEATS 20
+
+// Heap accounting
+
+static size_t heapLive = 0;
+static size_t heapPeak = 0;
+static size_t heapAllocs = 0;
+
+// Each block is prefixed with its size so delete can account for it
+static const size_t HEAP_HEADER = 16;
+
+void* operator new(size_t size) {
+  char* block = (char*)malloc(size + HEAP_HEADER);
+  if (!block) throw std::bad_alloc();
+  *(size_t*)block = size;
+  heapLive += size;
+  heapAllocs++;
+  if (heapLive > heapPeak) heapPeak = heapLive;
+  return block + HEAP_HEADER;
+}
+
+void operator delete(void* ptr) noexcept {
+  if (!ptr) return;
+  char* block = (char*)ptr - HEAP_HEADER;
+  heapLive -= *(size_t*)block;
+  free(block);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  operator delete(ptr);
+}
+
+static void heapReset() {
+  heapPeak = heapLive;
+  heapAllocs = 0;
+}
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool endsWith(const char* text, const char* suffix) {
+  size_t len = strlen(text), suffixLen = strlen(suffix);
+  return len >= suffixLen && strcmp(text + len - suffixLen, suffix) == 0;
+}
+
+// iCal feeds
+
+static bool benchFeed(const char* path, int repeats) {
+  static WiFiClient file;
+  if (!file.open(path)) {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return false;
+  }
+  // TLS records arrive in chunks; make available() report them one at a time
+  file.setSegmentSize(1460);
+
+  static ICalParser parser;
+  static ICalEventCache cache;
+  static ICalResult result;
+  static ICalTopKN<ICAL_MAX_EVENTS> upcoming;
+  parser.setCache(&cache);
+
+  bool complete = true;
+  size_t peak = 0, allocs = 0;
+  double start = seconds();
+  for (int i = 0; i < repeats; i++) {
+    memset(&result, 0, sizeof(result));
+    upcoming.begin(ICAL_MAX_EVENTS);
+    file.rewind();
+    cache.begin(path);
+
+    heapReset();
+    complete = parser.parseStream(file, NOW, &upcoming, &result) && complete;
+    upcoming.finish();
+    if (heapPeak > peak) peak = heapPeak;
+    allocs = heapAllocs;
+  }
+  double elapsed = seconds() - start;
+
+  double perRun = elapsed / repeats;
+  int events = result.totalEventsParsed;
+  printf("%s: %zu bytes, %d events (%d recurring), %d upcoming%s\n", path, file.size(), events,
+         result.recurringEventsParsed, upcoming.count(), complete ? "" : ", INCOMPLETE");
+  printf("  %.2f ms per parse, %.2f MB/s, %.2f us per event\n", perRun * 1e3,
+         file.size() / perRun / 1e6, events > 0 ? perRun * 1e6 / events : 0.0);
+  printf("  peak heap %zu bytes, %zu allocations per parse\n", peak, allocs);
+
+  file.close();
+  return complete;
+}
+
+// Command transcripts: each handler builds a reply of the size main.ino sends
+
+static STM32Comm comm;
+static int commandsHandled = 0;
+
+static void replyOK(const char*) {
+  commandsHandled++;
+  comm.sendOK();
+}
+static void replyStatus(const char*) {
+  commandsHandled++;
+  comm.beginResponse("STATUS:CONNECTED,").append("192.168.1.42").appendChar(',')
+      .appendInt(-61).append(",GSHEET_READY,").appendInt(412).append(",FAST").endResponse();
+}
+static void replyTime(const char*) {
+  commandsHandled++;
+  comm.send("TIME:2026-01-15T09:30:00.123Z");
+}
+static void replyWeather(const char*) {
+  commandsHandled++;
+  comm.beginResponse("WEATHER:").appendFloat(3.4f, 1).appendChar(',').appendInt(81).appendChar(',')
+      .append("light rain").appendChar(',').appendFloat(1.2f, 1).appendChar(',').appendFloat(5.9f, 1)
+      .endResponse();
+}
+static void replyStock(const char* params) {
+  commandsHandled++;
+  comm.beginResponse("STOCK:").append(params).appendChar(',').appendFixed(18734, 2).appendChar(',')
+      .appendFixed(-112, 2).endResponse();
+}
+static void replyBalance(const char*) {
+  commandsHandled++;
+  comm.beginResponse("BALANCE:").appendFixed(1234567, 2).endResponse();
+}
+static void replyCalendar(const char*) {
+  commandsHandled++;
+  comm.beginResponse("CALENDAR:").appendInt(10);
+  for (int i = 0; i < 10; i++) {
+    comm.appendChar(';').append("2026-01-15 10:00,2026-01-15 10:30,Team standup");
+  }
+  comm.endResponse();
+}
+
+static bool benchTranscript(const char* path, int repeats) {
+  static WiFiClient file;
+  if (!file.open(path)) {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return false;
+  }
+  // The STM32 link delivers a UART FIFO's worth at a time
+  file.setSegmentSize(128);
+
+  comm.begin(file);
+  comm.onCommand("WIFI", replyOK);
+  comm.onCommand("STATUS", replyStatus);
+  comm.onCommand("TIME", replyTime);
+  comm.onCommand("WEATHER", replyWeather);
+  comm.onCommand("STOCK", replyStock);
+  comm.onCommand("BALANCE", replyBalance);
+  comm.onCommand("CALENDAR", replyCalendar);
+  comm.onCommand("SET_CALENDAR_URL", replyOK);
+  comm.onCommand("SET_WEATHER_API_KEY", replyOK);
+  comm.onCommand("SET_WEATHER_LOCATION", replyOK);
+  comm.onCommand("GCP_PROJECT", replyOK);
+  comm.onCommand("GCP_EMAIL", replyOK);
+  comm.onCommand("GCP_KEY", replyOK);
+
+  size_t peak = 0;
+  double start = seconds();
+  for (int i = 0; i < repeats; i++) {
+    commandsHandled = 0;
+    file.rewind();
+    heapReset();
+    while (file.available()) {
+      comm.process();
+    }
+    if (heapPeak > peak) peak = heapPeak;
+  }
+  double elapsed = seconds() - start;
+
+  double perRun = elapsed / repeats;
+  printf("%s: %zu bytes, %d commands\n", path, file.size(), commandsHandled);
+  printf("  %.2f us per command, %.2f MB/s in, peak heap %zu bytes\n",
+         commandsHandled > 0 ? perRun * 1e6 / commandsHandled : 0.0, file.size() / perRun / 1e6, peak);
+
+  file.close();
+  return commandsHandled > 0;
+}
+
+int main(int argc, char** argv) {
+  setenv("TZ", "UTC0", 1);
+  tzset();
+
+  int repeats = DEFAULT_REPEATS;
+  int first = 1;
+  if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+    repeats = atoi(argv[2]);
+    if (repeats < 1) repeats = 1;
+    first = 3;
+  }
+
+  static const char* corpus[] = {
+      ESP_CORPUS_DIR "/work.ics",
+      ESP_CORPUS_DIR "/holidays.ics",
+      ESP_CORPUS_DIR "/stm32_session.txt",
+  };
+  const char* const* files = (const char* const*)argv + first;
+  int count = argc - first;
+  if (count == 0) {
+    files = corpus;
+    count = (int)(sizeof(corpus) / sizeof(corpus[0]));
+  }
+
+  printf("Static storage: ICalParser %zu, ICalTopKN<%d> %zu, ICalEventCache %zu, STM32Comm %zu bytes\n",
+         sizeof(ICalParser), ICAL_MAX_EVENTS, sizeof(ICalTopKN<ICAL_MAX_EVENTS>), sizeof(ICalEventCache), sizeof(STM32Comm));
+
+  bool ok = true;
+  for (int i = 0; i < count; i++) {
+    if (endsWith(files[i], ".ics")) {
+      ok = benchFeed(files[i], repeats) && ok;
+    } else {
+      ok = benchTranscript(files[i], repeats) && ok;
+    }
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+#ifndef ICAL_TEST_HELPERS_H
+#define ICAL_TEST_HELPERS_H
+
+// Shared by the ICalParser host tests
+#include "ICalParser.h"
+
+static inline ICalRRule make_rule(ICalFreq freq, int interval, time_t until, int count, uint8_t byDay) {
+  ICalRRule rule = {freq, interval, until, count, byDay};
+  return rule;
+}
+
+#endif // ICAL_TEST_HELPERS_H
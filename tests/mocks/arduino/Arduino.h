@@ -0,0 +1,160 @@
+#ifndef ARDUINO_STUB_H
+#define ARDUINO_STUB_H
+
+// Minimal Arduino.h stand-in so the ESP8266 libraries' pure logic can be
+// compiled natively for host testing. The networking headers beside it
+// declare just what the libraries' headers mention: the code that talks to
+// the network (ICalParser::fetch(), SntpClient.cpp) is not compiled here.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <time.h>
+
+#ifdef __cplusplus
+
+// Timing: a monotonic millisecond clock; yield() has no watchdog to feed
+inline unsigned long millis() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long)ts.tv_sec * 1000UL + (unsigned long)(ts.tv_nsec / 1000000L);
+}
+inline void yield() {}
+inline void delay(unsigned long ms) {
+  struct timespec ts = {(time_t)(ms / 1000), (long)(ms % 1000) * 1000000L};
+  nanosleep(&ts, nullptr);
+}
+
+// Heap string with the members the libraries use. Grows in 16-byte steps
+// like the ESP8266 core, allocating with new[] so a benchmark can count it.
+class String {
+public:
+  String(const char* text = "") : _buffer(nullptr), _length(0), _capacity(0) { assign(text, strlen(text)); }
+  String(const String& other) : _buffer(nullptr), _length(0), _capacity(0) { assign(other.c_str(), other._length); }
+  ~String() { delete[] _buffer; }
+
+  String& operator=(const String& other) {
+    if (this != &other) assign(other.c_str(), other._length);
+    return *this;
+  }
+  String& operator=(const char* text) { return assign(text, strlen(text)); }
+
+  unsigned int length() const { return _length; }
+  const char* c_str() const { return _buffer ? _buffer : ""; }
+
+  bool reserve(unsigned int size) {
+    if (size < _capacity) return true;
+    unsigned int capacity = (size + 16) & ~15u;
+    char* grown = new char[capacity];
+    memcpy(grown, c_str(), _length + 1);
+    delete[] _buffer;
+    _buffer = grown;
+    _capacity = capacity;
+    return true;
+  }
+
+  String& operator+=(char c) {
+    reserve(_length + 1);
+    _buffer[_length++] = c;
+    _buffer[_length] = '\0';
+    return *this;
+  }
+  String& operator+=(const char* text) {
+    size_t len = strlen(text);
+    reserve(_length + len);
+    memcpy(_buffer + _length, text, len + 1);
+    _length += len;
+    return *this;
+  }
+
+  bool operator==(const char* text) const { return strcmp(c_str(), text) == 0; }
+  bool operator!=(const char* text) const { return !(*this == text); }
+  bool startsWith(const char* prefix) const { return strncmp(c_str(), prefix, strlen(prefix)) == 0; }
+
+  int indexOf(char c, unsigned int from = 0) const {
+    if (from >= _length) return -1;
+    const char* found = strchr(c_str() + from, c);
+    return found ? (int)(found - c_str()) : -1;
+  }
+  int indexOf(const char* text, unsigned int from = 0) const {
+    if (from > _length) return -1;
+    const char* found = strstr(c_str() + from, text);
+    return found ? (int)(found - c_str()) : -1;
+  }
+
+  String substring(unsigned int from) const { return substring(from, _length); }
+  String substring(unsigned int from, unsigned int to) const {
+    if (to > _length) to = _length;
+    String out;
+    if (from < to) out.assign(c_str() + from, to - from);
+    return out;
+  }
+
+  void trim() {
+    if (_length == 0) return;
+    unsigned int begin = 0, end = _length;
+    while (begin < end && isspace((unsigned char)_buffer[begin])) begin++;
+    while (end > begin && isspace((unsigned char)_buffer[end - 1])) end--;
+    _length = end - begin;
+    memmove(_buffer, _buffer + begin, _length);
+    _buffer[_length] = '\0';
+  }
+
+private:
+  char* _buffer;
+  unsigned int _length;
+  unsigned int _capacity;  // Bytes allocated, including the terminator
+
+  String& assign(const char* text, size_t len) {
+    _length = 0;
+    if (_buffer) _buffer[0] = '\0';
+    if (len == 0) return *this;
+    reserve(len);
+    memcpy(_buffer, text, len);
+    _buffer[len] = '\0';
+    _length = len;
+    return *this;
+  }
+};
+
+// Byte sink / source interfaces with the subset of the Arduino API used by
+// the libraries (LittleFS File derives from Stream on the device)
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (size-- > 0 && write(*buffer++) == 1) n++;
+    return n;
+  }
+  virtual int availableForWrite() { return 0; }
+  size_t print(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+  size_t println(const char* text) { return print(text) + print("\r\n"); }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  virtual size_t readBytes(char* buffer, size_t length) {
+    size_t n = 0;
+    while (n < length) {
+      int c = read();
+      if (c < 0) break;
+      buffer[n++] = (char)c;
+    }
+    return n;
+  }
+  size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+};
+
+#endif
+
+#endif // ARDUINO_STUB_H
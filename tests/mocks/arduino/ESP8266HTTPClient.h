@@ -0,0 +1,8 @@
+#ifndef ESP8266HTTPCLIENT_STUB_H
+#define ESP8266HTTPCLIENT_STUB_H
+
+// Empty: ICalParser.h includes it, but HTTPClient appears only in fetch().
+
+#include "Arduino.h"
+
+#endif // ESP8266HTTPCLIENT_STUB_H
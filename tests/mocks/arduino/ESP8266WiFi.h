@@ -0,0 +1,74 @@
+#ifndef ESP8266WIFI_STUB_H
+#define ESP8266WIFI_STUB_H
+
+// WiFiClient is backed by a file so ICalParser::parseStream() can read a
+// saved response body.
+
+#include "Arduino.h"
+
+class WiFiClient : public Stream {
+public:
+  WiFiClient() : _data(nullptr), _size(0), _pos(0), _segment(0) {}
+  ~WiFiClient() { close(); }
+  WiFiClient(const WiFiClient&) = delete;
+  WiFiClient& operator=(const WiFiClient&) = delete;
+
+  // Load path into memory; reads then come from it as if off the network
+  bool open(const char* path) {
+    close();
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    _data = (char*)malloc(size > 0 ? size : 1);
+    _size = size > 0 && fread(_data, 1, size, file) == (size_t)size ? size : 0;
+    fclose(file);
+    _pos = 0;
+    return true;
+  }
+
+  void close() {
+    free(_data);
+    _data = nullptr;
+    _size = 0;
+    _pos = 0;
+  }
+
+  // Start over from the first byte
+  void rewind() { _pos = 0; }
+
+  // Report at most this many bytes per available(), like TCP segments
+  // arriving one at a time (0 = everything left)
+  void setSegmentSize(size_t segment) { _segment = segment; }
+
+  size_t size() const { return _size; }
+
+  int available() override {
+    size_t left = _size - _pos;
+    return (int)(_segment > 0 && left > _segment ? _segment : left);
+  }
+  int read() override { return _pos < _size ? (uint8_t)_data[_pos++] : -1; }
+  int peek() override { return _pos < _size ? (uint8_t)_data[_pos] : -1; }
+  size_t readBytes(char* buffer, size_t length) override {
+    if (length > _size - _pos) length = _size - _pos;
+    memcpy(buffer, _data + _pos, length);
+    _pos += length;
+    return length;
+  }
+
+  // Anything sent back is discarded
+  size_t write(uint8_t) override { return 1; }
+  size_t write(const uint8_t*, size_t size) override { return size; }
+
+  // The "peer" closes once the whole file has been read
+  uint8_t connected() { return _pos < _size; }
+
+private:
+  char* _data;
+  size_t _size;
+  size_t _pos;
+  size_t _segment;
+};
+
+#endif // ESP8266WIFI_STUB_H
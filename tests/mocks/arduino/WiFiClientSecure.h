@@ -0,0 +1,13 @@
+#ifndef WIFICLIENTSECURE_STUB_H
+#define WIFICLIENTSECURE_STUB_H
+
+// Declares BearSSL::Session, which ICalParser::setTlsSession() takes by
+// pointer; the TLS client itself appears only in fetch().
+
+#include "Arduino.h"
+
+namespace BearSSL {
+class Session;
+}
+
+#endif // WIFICLIENTSECURE_STUB_H
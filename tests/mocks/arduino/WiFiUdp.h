@@ -0,0 +1,12 @@
+#ifndef WIFIUDP_STUB_H
+#define WIFIUDP_STUB_H
+
+// Empty types for SntpClient's members; the socket calls are all in
+// SntpClient.cpp.
+
+#include "Arduino.h"
+
+class IPAddress {};
+class WiFiUDP {};
+
+#endif // WIFIUDP_STUB_H
@@ -15,6 +15,9 @@ typedef struct {
     uint8_t Hours;
     uint8_t Minutes;
     uint8_t Seconds;
+    uint8_t TimeFormat;
+    uint32_t SubSeconds;
+    uint32_t SecondFraction;
 } RTC_TimeTypeDef;
 
 typedef struct {
@@ -28,10 +31,22 @@ typedef struct {
     void *Instance;
 } RTC_HandleTypeDef;
 
+typedef struct {
+    void *Instance;
+} SPI_HandleTypeDef;
+
 // RTC Format
 #define RTC_FORMAT_BIN 0x00U
 #define RTC_FORMAT_BCD 0x01U
 
+// RTC AM/PM (TimeFormat)
+#define RTC_HOURFORMAT12_AM ((uint8_t)0x00)
+#define RTC_HOURFORMAT12_PM ((uint8_t)0x01)
+
+// RTC backup registers
+#define RTC_BKP_DR0 0x00000000U
+#define RTC_BKP_DR1 0x00000001U
+
 // RTC Months
 #define RTC_MONTH_JANUARY   ((uint8_t)0x01)
 #define RTC_MONTH_FEBRUARY  ((uint8_t)0x02)
@@ -63,5 +78,8 @@ HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTim
 HAL_StatusTypeDef HAL_RTC_GetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *sDate, uint32_t Format);
 HAL_StatusTypeDef HAL_RTC_SetTime(RTC_HandleTypeDef *hrtc, RTC_TimeTypeDef *sTime, uint32_t Format);
 HAL_StatusTypeDef HAL_RTC_SetDate(RTC_HandleTypeDef *hrtc, RTC_DateTypeDef *sDate, uint32_t Format);
+uint32_t HAL_RTCEx_BKUPRead(RTC_HandleTypeDef *hrtc, uint32_t BackupRegister);
+void HAL_RTCEx_BKUPWrite(RTC_HandleTypeDef *hrtc, uint32_t BackupRegister, uint32_t Data);
+uint32_t HAL_GetTick(void);
 
 #endif // STM32_HAL_MOCK_H
@@ -0,0 +1,10 @@
+#ifndef STM32F4XX_HAL_HOST_H
+#define STM32F4XX_HAL_HOST_H
+
+// Host stand-in for the HAL umbrella header the views and DateHelper
+// include, so they build against the mocks instead of the real HAL and
+// CMSIS headers (which assume 32-bit pointers and the ARM toolchain)
+
+#include "hal_compat.h"
+
+#endif // STM32F4XX_HAL_HOST_H
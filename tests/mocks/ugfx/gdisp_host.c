@@ -0,0 +1,397 @@
+// Software gdisp for the host: the drawing calls in gfx.h rasterized into a
+// framebuffer_t, plus the host Display (blit and layers) the views use, so
+// every *View.c links unchanged. Counts primitives and pixel writes per
+// frame for tests/render_views.c.
+
+#include "gfx.h"
+#include <stdlib.h>
+#include <string.h>
+#include "Display.h"
+
+static framebuffer_t frame;
+static gdisp_host_stats_t stats;
+
+// Pixels
+
+static void plot(int x, int y, bool on) {
+  if (x < 0 || y < 0 || x >= FB_WIDTH || y >= FB_HEIGHT) return;
+  fb_set_pixel(&frame, x, y, on);
+  stats.pixels++;
+}
+
+static void fill(int x, int y, int cx, int cy, bool on) {
+  if (x < 0) {
+    cx += x;
+    x = 0;
+  }
+  if (y < 0) {
+    cy += y;
+    y = 0;
+  }
+  if (x + cx > FB_WIDTH) cx = FB_WIDTH - x;
+  if (y + cy > FB_HEIGHT) cy = FB_HEIGHT - y;
+  if (cx <= 0 || cy <= 0) return;
+  fb_fill_rect(&frame, x, y, cx, cy, on);
+  stats.pixels += (uint32_t)cx * cy;
+}
+
+// Bresenham, both ends included, as gdisp draws them
+static void line(int x0, int y0, int x1, int y1, bool on) {
+  if (y0 == y1) {
+    fill(x0 < x1 ? x0 : x1, y0, abs(x1 - x0) + 1, 1, on);
+    return;
+  }
+  if (x0 == x1) {
+    fill(x0, y0 < y1 ? y0 : y1, 1, abs(y1 - y0) + 1, on);
+    return;
+  }
+  int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+  int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+  int err = dx + dy;
+  for (;;) {
+    plot(x0, y0, on);
+    if (x0 == x1 && y0 == y1) break;
+    int e2 = 2 * err;
+    if (e2 >= dy) {
+      err += dy;
+      x0 += sx;
+    }
+    if (e2 <= dx) {
+      err += dx;
+      y0 += sy;
+    }
+  }
+}
+
+// Half the width of a filled circle's span dy rows from the centre
+static int circle_span(int radius, int dy) {
+  int dx = radius;
+  while (dx > 0 && dx * dx + dy * dy > radius * radius + radius) dx--;
+  return dx;
+}
+
+// gdisp
+
+struct GDisplay {
+  int unused;
+};
+static GDisplay display;
+
+GDisplay* gdispGetDisplay(unsigned index) {
+  return index == 0 ? &display : NULL;
+}
+
+gCoord gdispGetWidth(void) {
+  return FB_WIDTH;
+}
+
+gCoord gdispGetHeight(void) {
+  return FB_HEIGHT;
+}
+
+void gdispGFlush(GDisplay* g) {
+  (void)g;
+  stats.flushes++;
+}
+
+void gdispClear(gColor color) {
+  stats.primitives++;
+  fill(0, 0, FB_WIDTH, FB_HEIGHT, color != Black);
+}
+
+void gdispDrawPixel(gCoord x, gCoord y, gColor color) {
+  stats.primitives++;
+  plot(x, y, color != Black);
+}
+
+void gdispDrawLine(gCoord x0, gCoord y0, gCoord x1, gCoord y1, gColor color) {
+  stats.primitives++;
+  line(x0, y0, x1, y1, color != Black);
+}
+
+// Parallel lines across the minor axis; round ends get a dot of the width
+void gdispDrawThickLine(gCoord x0, gCoord y0, gCoord x1, gCoord y1, gColor color, gCoord width, gBool round) {
+  stats.primitives++;
+  bool on = color != Black;
+  bool steep = abs(y1 - y0) > abs(x1 - x0);
+  for (int i = -(width - 1) / 2; i <= width / 2; i++) {
+    if (steep) {
+      line(x0 + i, y0, x1 + i, y1, on);
+    } else {
+      line(x0, y0 + i, x1, y1 + i, on);
+    }
+  }
+  if (round && width > 2) {
+    for (int dy = -width / 2; dy <= width / 2; dy++) {
+      int dx = circle_span(width / 2, dy);
+      fill(x0 - dx, y0 + dy, 2 * dx + 1, 1, on);
+      fill(x1 - dx, y1 + dy, 2 * dx + 1, 1, on);
+    }
+  }
+}
+
+void gdispDrawBox(gCoord x, gCoord y, gCoord cx, gCoord cy, gColor color) {
+  stats.primitives++;
+  if (cx <= 0 || cy <= 0) return;
+  bool on = color != Black;
+  fill(x, y, cx, 1, on);
+  fill(x, y + cy - 1, cx, 1, on);
+  fill(x, y + 1, 1, cy - 2, on);
+  fill(x + cx - 1, y + 1, 1, cy - 2, on);
+}
+
+void gdispFillArea(gCoord x, gCoord y, gCoord cx, gCoord cy, gColor color) {
+  stats.primitives++;
+  fill(x, y, cx, cy, color != Black);
+}
+
+// Midpoint circle
+void gdispDrawCircle(gCoord x, gCoord y, gCoord radius, gColor color) {
+  stats.primitives++;
+  bool on = color != Black;
+  int a = 0, b = radius, p = 1 - radius;
+  while (a <= b) {
+    plot(x + a, y + b, on);
+    plot(x - a, y + b, on);
+    plot(x + a, y - b, on);
+    plot(x - a, y - b, on);
+    plot(x + b, y + a, on);
+    plot(x - b, y + a, on);
+    plot(x + b, y - a, on);
+    plot(x - b, y - a, on);
+    a++;
+    if (p < 0) {
+      p += 2 * a + 1;
+    } else {
+      b--;
+      p += 2 * (a - b) + 1;
+    }
+  }
+}
+
+void gdispFillCircle(gCoord x, gCoord y, gCoord radius, gColor color) {
+  stats.primitives++;
+  for (int dy = -radius; dy <= radius; dy++) {
+    int dx = circle_span(radius, dy);
+    fill(x - dx, y + dy, 2 * dx + 1, 1, color != Black);
+  }
+}
+
+// Fonts: one 5x7 face (plus descender row), scaled up for the larger sizes
+
+struct host_font {
+  char name[24];
+  uint8_t size;   // Nominal pixel height from the name
+  uint8_t scale;  // Glyph pixels per face pixel
+  bool bold;      // Drawn twice, one pixel apart
+};
+
+#define GLYPH_WIDTH 5
+#define GLYPH_ROWS 8
+#define MAX_FONTS 8
+
+// Columns left to right, bit 0 = top row; ' ' to '~'
+static const uint8_t glyphs[][GLYPH_WIDTH] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00},
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+    {0x36, 0x49, 0x56, 0x20, 0x50}, {0x00, 0x08, 0x07, 0x03, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00},
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x2A, 0x1C, 0x7F, 0x1C, 0x2A}, {0x08, 0x08, 0x3E, 0x08, 0x08},
+    {0x00, 0x80, 0x70, 0x30, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x00, 0x60, 0x60, 0x00},
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},
+    {0x72, 0x49, 0x49, 0x49, 0x46}, {0x21, 0x41, 0x49, 0x4D, 0x33}, {0x18, 0x14, 0x12, 0x7F, 0x10},
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x31}, {0x41, 0x21, 0x11, 0x09, 0x07},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x46, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x00, 0x14, 0x00, 0x00},
+    {0x00, 0x40, 0x34, 0x00, 0x00}, {0x00, 0x08, 0x14, 0x22, 0x41}, {0x14, 0x14, 0x14, 0x14, 0x14},
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x59, 0x09, 0x06}, {0x3E, 0x41, 0x5D, 0x59, 0x4E},
+    {0x7C, 0x12, 0x11, 0x12, 0x7C}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},
+    {0x7F, 0x41, 0x41, 0x41, 0x3E}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01},
+    {0x3E, 0x41, 0x41, 0x51, 0x73}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00},
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40},
+    {0x7F, 0x02, 0x1C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46},
+    {0x26, 0x49, 0x49, 0x49, 0x32}, {0x03, 0x01, 0x7F, 0x01, 0x03}, {0x3F, 0x40, 0x40, 0x40, 0x3F},
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63},
+    {0x03, 0x04, 0x78, 0x04, 0x03}, {0x61, 0x59, 0x49, 0x4D, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x41},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x41, 0x7F}, {0x04, 0x02, 0x01, 0x02, 0x04},
+    {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x03, 0x07, 0x08, 0x00}, {0x20, 0x54, 0x54, 0x78, 0x40},
+    {0x7F, 0x28, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x28}, {0x38, 0x44, 0x44, 0x28, 0x7F},
+    {0x38, 0x54, 0x54, 0x54, 0x18}, {0x00, 0x08, 0x7E, 0x09, 0x02}, {0x18, 0xA4, 0xA4, 0x9C, 0x78},
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x40, 0x3D, 0x00},
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x78, 0x04, 0x78},
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0xFC, 0x18, 0x24, 0x24, 0x18},
+    {0x18, 0x24, 0x24, 0x18, 0xFC}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x24},
+    {0x04, 0x04, 0x3F, 0x44, 0x24}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C},
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x4C, 0x90, 0x90, 0x90, 0x7C},
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x77, 0x00, 0x00},
+    {0x00, 0x41, 0x36, 0x08, 0x00}, {0x02, 0x01, 0x02, 0x04, 0x02},
+};
+_Static_assert(sizeof(glyphs) / sizeof(glyphs[0]) == '~' - ' ' + 1, "one glyph per printable character");
+
+static struct host_font fonts[MAX_FONTS];
+static int font_count;
+
+// "DejaVuSans16", "DejaVuSansBold12": size from the trailing digits
+gFont gdispOpenFont(const char* name) {
+  for (int i = 0; i < font_count; i++) {
+    if (strcmp(fonts[i].name, name) == 0) return &fonts[i];
+  }
+  if (font_count == MAX_FONTS) return NULL;
+
+  struct host_font* font = &fonts[font_count++];
+  strncpy(font->name, name, sizeof(font->name) - 1);
+  const char* digits = name + strlen(name);
+  while (digits > name && digits[-1] >= '0' && digits[-1] <= '9') digits--;
+  font->size = *digits ? atoi(digits) : 10;
+  font->scale = font->size >= 16 ? font->size / GLYPH_ROWS : 1;
+  font->bold = strstr(name, "Bold") != NULL;
+  return font;
+}
+
+gCoord gdispGetFontMetric(gFont font, gFontmetric metric) {
+  int glyph_height = GLYPH_ROWS * font->scale;
+  switch (metric) {
+    case fontHeight:
+    case fontLineSpacing:
+      return font->size > glyph_height ? font->size : glyph_height;
+    case fontDescendersHeight:
+      return font->scale;
+    case fontCharPadding:
+      return font->scale;
+    case fontMinWidth:
+    case fontMaxWidth:
+      return gdispGetCharWidth('M', font);
+  }
+  return 0;
+}
+
+// UTF-8 lead bytes draw as '?', continuation bytes take no room
+static const uint8_t* glyph_for(unsigned char c) {
+  if (c >= 0xC0) c = '?';
+  if (c < ' ' || c > '~') return NULL;
+  return glyphs[c - ' '];
+}
+
+gCoord gdispGetCharWidth(char c, gFont font) {
+  if (!glyph_for((unsigned char)c)) return 0;
+  return (GLYPH_WIDTH + 1) * font->scale + font->bold;
+}
+
+gCoord gdispGetStringWidth(const char* str, gFont font) {
+  int width = 0;
+  for (; *str; str++) {
+    width += gdispGetCharWidth(*str, font);
+  }
+  return width;
+}
+
+// Draw str with its top left at x, y, keeping to the clip rectangle
+static void draw_text(int x, int y, const char* str, gFont font, bool on, int clip_x0, int clip_y0, int clip_x1,
+                      int clip_y1) {
+  int s = font->scale;
+  y += (gdispGetFontMetric(font, fontHeight) - GLYPH_ROWS * s) / 2;
+  for (; *str; str++) {
+    const uint8_t* glyph = glyph_for((unsigned char)*str);
+    if (!glyph) continue;
+    for (int col = 0; col < GLYPH_WIDTH; col++) {
+      for (int row = 0; row < GLYPH_ROWS; row++) {
+        if (!(glyph[col] & (1 << row))) continue;
+        for (int b = 0; b <= font->bold; b++) {
+          int px = x + col * s + b, py = y + row * s;
+          for (int dy = 0; dy < s; dy++) {
+            for (int dx = 0; dx < s; dx++) {
+              if (px + dx >= clip_x0 && px + dx < clip_x1 && py + dy >= clip_y0 && py + dy < clip_y1) {
+                plot(px + dx, py + dy, on);
+              }
+            }
+          }
+        }
+      }
+    }
+    x += gdispGetCharWidth(*str, font);
+  }
+}
+
+void gdispDrawString(gCoord x, gCoord y, const char* str, gFont font, gColor color) {
+  stats.primitives++;
+  draw_text(x, y, str, font, color != Black, 0, 0, FB_WIDTH, FB_HEIGHT);
+}
+
+// Centred vertically in the box and clipped to it, like gdisp
+void gdispDrawStringBox(gCoord x, gCoord y, gCoord cx, gCoord cy, const char* str, gFont font, gColor color,
+                        gJustify justify) {
+  stats.primitives++;
+  int width = gdispGetStringWidth(str, font);
+  int tx = x;
+  if (justify & justifyCenter) {
+    tx = x + (cx - width + 1) / 2;
+  } else if (justify & justifyRight) {
+    tx = x + cx - width;
+  }
+  int ty = y + (cy - gdispGetFontMetric(font, fontHeight) + 1) / 2;
+  draw_text(tx, ty, str, font, color != Black, x, y, x + cx, y + cy);
+}
+
+// Host only
+
+const framebuffer_t* gdisp_host_frame(void) {
+  return &frame;
+}
+
+const gdisp_host_stats_t* gdisp_host_stats(void) {
+  return &stats;
+}
+
+void gdisp_host_reset_stats(void) {
+  memset(&stats, 0, sizeof(stats));
+}
+
+// Display, minus the panel: blit and layers go straight to the frame
+
+static display_stats_t display_stats;
+
+static void display_init(void) {}
+
+static void display_process(void) {}
+
+static void display_dma_complete(SPI_HandleTypeDef* hspi) {
+  (void)hspi;
+}
+
+static void display_blit(int x, int y, const fb_sprite_t* sprite) {
+  stats.primitives++;
+  fb_blit(&frame, x, y, sprite);
+  // Every pixel under the sprite is read, set or not
+  int cx = sprite->width, cy = sprite->height;
+  if (x < 0) cx += x;
+  if (y < 0) cy += y;
+  if (x + sprite->width > FB_WIDTH) cx -= x + sprite->width - FB_WIDTH;
+  if (y + sprite->height > FB_HEIGHT) cy -= y + sprite->height - FB_HEIGHT;
+  if (cx > 0 && cy > 0) stats.pixels += (uint32_t)cx * cy;
+}
+
+static void display_save_layer(framebuffer_t* layer) {
+  *layer = frame;
+}
+
+static void display_load_layer(const framebuffer_t* layer) {
+  stats.primitives++;
+  stats.pixels += FB_WIDTH * FB_HEIGHT;
+  frame = *layer;
+}
+
+static const display_stats_t* display_get_stats(void) {
+  return &display_stats;
+}
+
+static void display_reset_stats(void) {}
+
+const struct display Display = {
+    .init = display_init,
+    .process = display_process,
+    .dma_complete = display_dma_complete,
+    .blit = display_blit,
+    .save_layer = display_save_layer,
+    .load_layer = display_load_layer,
+    .stats = display_get_stats,
+    .reset_stats = display_reset_stats,
+};
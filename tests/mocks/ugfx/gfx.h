@@ -0,0 +1,83 @@
+#pragma once
+
+// Host stand-in for the slice of uGFX the views draw with, backed by the
+// same 1bpp framebuffer_t the firmware flushes from (see gdisp_host.c).
+// Signatures follow uGFX 2.9; anything not black lights the pixel, as on
+// the panel. Fonts are a scaled 5x7 face named after the DejaVu ones, so
+// layouts come out close to the real thing but glyphs are not identical.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "framebuffer.h"
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+typedef int16_t gCoord;
+typedef gCoord coord_t;
+typedef uint32_t gColor;
+typedef gColor color_t;
+typedef bool gBool;
+
+#define HTML2COLOR(h) ((gColor)(h))
+#define Black HTML2COLOR(0x000000)
+#define White HTML2COLOR(0xFFFFFF)
+
+typedef enum {
+  justifyLeft = 0x00,
+  justifyCenter = 0x01,
+  justifyRight = 0x02,
+} gJustify;
+typedef gJustify justify_t;
+
+typedef enum {
+  fontHeight,
+  fontDescendersHeight,
+  fontLineSpacing,
+  fontCharPadding,
+  fontMinWidth,
+  fontMaxWidth,
+} gFontmetric;
+
+typedef const struct host_font* gFont;
+typedef gFont font_t;
+
+typedef struct GDisplay GDisplay;
+
+GDisplay* gdispGetDisplay(unsigned display);
+gCoord gdispGetWidth(void);
+gCoord gdispGetHeight(void);
+void gdispGFlush(GDisplay* g);
+
+void gdispClear(gColor color);
+void gdispDrawPixel(gCoord x, gCoord y, gColor color);
+void gdispDrawLine(gCoord x0, gCoord y0, gCoord x1, gCoord y1, gColor color);
+void gdispDrawThickLine(gCoord x0, gCoord y0, gCoord x1, gCoord y1, gColor color, gCoord width, gBool round);
+void gdispDrawBox(gCoord x, gCoord y, gCoord cx, gCoord cy, gColor color);
+void gdispFillArea(gCoord x, gCoord y, gCoord cx, gCoord cy, gColor color);
+void gdispDrawCircle(gCoord x, gCoord y, gCoord radius, gColor color);
+void gdispFillCircle(gCoord x, gCoord y, gCoord radius, gColor color);
+
+gFont gdispOpenFont(const char* name);
+gCoord gdispGetFontMetric(gFont font, gFontmetric metric);
+gCoord gdispGetCharWidth(char c, gFont font);
+gCoord gdispGetStringWidth(const char* str, gFont font);
+void gdispDrawString(gCoord x, gCoord y, const char* str, gFont font, gColor color);
+void gdispDrawStringBox(gCoord x, gCoord y, gCoord cx, gCoord cy, const char* str, gFont font, gColor color,
+                        gJustify justify);
+
+// Host only: what the views drew since the last reset
+
+typedef struct {
+  uint32_t primitives;  // gdisp calls and Display blits/layer loads
+  uint32_t pixels;      // Pixel writes, clipped to the frame
+  uint32_t flushes;
+} gdisp_host_stats_t;
+
+const framebuffer_t* gdisp_host_frame(void);
+const gdisp_host_stats_t* gdisp_host_stats(void);
+void gdisp_host_reset_stats(void);
@@ -0,0 +1,313 @@
+// Headless renderer for the views: draws every scene below through the
+// software gdisp in mocks/ugfx with a mocked RTC, writes each frame as a
+// PBM and reports the primitives and pixels it took.
+//
+//   render_views [-o dir] [-c golden_dir] [-n repeats]
+//
+// -o writes <scene>.pbm files (default: none); -c compares every frame with
+// the golden of the same name and fails on any difference; -n renders each
+// scene that many more times and reports the time per frame. Accept new
+// goldens with render_views -o ../tests/golden after checking the images.
+//
+// Scenes run in order in one process and views keep their animation state
+// between renders, exactly as on the board, so always run the whole list.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "AlarmView.h"
+#include "BankView.h"
+#include "CalendarView.h"
+#include "ClockView.h"
+#include "DateHelper.h"
+#include "FlipClockView.h"
+#include "Fonts.h"
+#include "StatusView.h"
+#include "gfx.h"
+
+#define DEFAULT_REPEATS 0
+#define MOCK_TICK 123456
+
+// Mocked RTC: the scene's wall clock, read back the way the board's 12-hour
+// RTC reports it
+
+RTC_HandleTypeDef hrtc;
+
+static struct {
+  uint16_t year;
+  uint8_t month, day;
+  uint8_t hour, minute, second;  // 24-hour
+  uint16_t ms;
+} clock_now;
+
+static uint32_t backup[20];
+
+HAL_StatusTypeDef HAL_RTC_GetTime(RTC_HandleTypeDef* rtc, RTC_TimeTypeDef* time, uint32_t format) {
+  (void)rtc;
+  (void)format;
+  memset(time, 0, sizeof(*time));
+  time->TimeFormat = clock_now.hour >= 12 ? RTC_HOURFORMAT12_PM : RTC_HOURFORMAT12_AM;
+  time->Hours = clock_now.hour % 12 == 0 ? 12 : clock_now.hour % 12;
+  time->Minutes = clock_now.minute;
+  time->Seconds = clock_now.second;
+  // Sub-second down-counter at the board's SynchPrediv of 255
+  time->SecondFraction = 255;
+  time->SubSeconds = 255 - clock_now.ms * 256 / 1000;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RTC_GetDate(RTC_HandleTypeDef* rtc, RTC_DateTypeDef* date, uint32_t format) {
+  (void)rtc;
+  (void)format;
+  date->Year = clock_now.year - 2000;
+  date->Month = clock_now.month;
+  date->Date = clock_now.day;
+  date->WeekDay = DateHelper.calc_rtc_weekday(clock_now.year, clock_now.month, clock_now.day);
+  return HAL_OK;
+}
+
+uint32_t HAL_RTCEx_BKUPRead(RTC_HandleTypeDef* rtc, uint32_t reg) {
+  (void)rtc;
+  return reg < sizeof(backup) / sizeof(backup[0]) ? backup[reg] : 0;
+}
+
+void HAL_RTCEx_BKUPWrite(RTC_HandleTypeDef* rtc, uint32_t reg, uint32_t data) {
+  (void)rtc;
+  if (reg < sizeof(backup) / sizeof(backup[0])) backup[reg] = data;
+}
+
+uint32_t HAL_GetTick(void) {
+  return MOCK_TICK;
+}
+
+// Scenes: a time on the clock and the data each view is fed
+
+static struct {
+  View* status;
+  View* clock;
+  View* flipclock;
+  View* calendar;
+  View* bank;
+  View* alarm;
+} views;
+
+static View* status_booting(void) {
+  StatusView.set_wifi_state(BOOT_PHASE_COMPLETE);
+  StatusView.set_time_state(BOOT_PHASE_COMPLETE);
+  StatusView.set_weather_state(BOOT_PHASE_IN_PROGRESS);
+  return views.status;
+}
+
+static View* status_done(void) {
+  StatusView.set_weather_state(BOOT_PHASE_COMPLETE);
+  StatusView.set_balance_state(BOOT_PHASE_COMPLETE);
+  StatusView.set_calendar_state(BOOT_PHASE_COMPLETE);
+  return views.status;
+}
+
+static View* clock_face(void) {
+  return views.clock;
+}
+
+static View* flipclock_no_weather(void) {
+  return views.flipclock;
+}
+
+static View* flipclock_rain(void) {
+  FlipClockView.set_weather(41, "Light Rain", 80);
+  return views.flipclock;
+}
+
+static View* flipclock_clear_night(void) {
+  FlipClockView.set_weather(-3, "Clear", 0);
+  return views.flipclock;
+}
+
+static View* calendar_empty(void) {
+  CalendarView.set_events(NULL, 0);
+  return views.calendar;
+}
+
+static View* calendar_busy(void) {
+  static calendar_event_t events[] = {
+      {"2026-01-15 09:30", "2026-01-15 10:00", "Standup"},
+      {"2026-01-15 12:00", "2026-01-15 13:00", "Lunch with the quarterly planning committee"},
+      {"2026-01-15 15:00", "2026-01-15 15:30", "Caf\xC3\xA9 run"},
+      {"2026-01-16 00:00", "2026-01-16 23:59", "Release day"},
+      {"2026-01-17 10:00", "2026-01-17 11:00", "Dentist"},
+      {"2026-01-18 18:00", "2026-01-18 21:00", "Dinner"},
+  };
+  CalendarView.set_events(events, sizeof(events) / sizeof(events[0]));
+  return views.calendar;
+}
+
+static View* bank_balance(void) {
+  BankView.set_balance(123456);
+  return views.bank;
+}
+
+static View* alarm_editing(void) {
+  AlarmView.set_alarm_hour(6);
+  AlarmView.set_alarm_minute(45);
+  AlarmView.set_enabled(true);
+  AlarmView.set_selected_field(ALARM_FIELD_MINUTE);
+  return views.alarm;
+}
+
+typedef struct {
+  const char* name;
+  uint16_t year;
+  uint8_t month, day, hour, minute, second;
+  View* (*prepare)(void);
+} scene_t;
+
+static const scene_t scenes[] = {
+    {"status_booting", 2026, 1, 15, 9, 30, 0, status_booting},
+    {"status_done", 2026, 1, 15, 9, 30, 2, status_done},
+    {"clock", 2026, 1, 15, 10, 8, 42, clock_face},
+    {"flipclock_no_weather", 2026, 1, 15, 7, 45, 12, flipclock_no_weather},
+    {"flipclock_rain", 2026, 1, 15, 13, 5, 0, flipclock_rain},
+    {"flipclock_clear_night", 2026, 1, 15, 23, 59, 59, flipclock_clear_night},
+    {"calendar_empty", 2026, 1, 15, 9, 30, 0, calendar_empty},
+    {"calendar_busy", 2026, 1, 15, 9, 30, 0, calendar_busy},
+    {"bank", 2026, 1, 15, 9, 30, 0, bank_balance},
+    {"alarm", 2026, 1, 15, 21, 0, 0, alarm_editing},
+};
+#define SCENE_COUNT (sizeof(scenes) / sizeof(scenes[0]))
+
+// PBM (P4): rows packed MSB first like the frame, but 1 is black
+
+static bool write_pbm(const char* path, const framebuffer_t* fb) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  fprintf(f, "P4\n%d %d\n", FB_WIDTH, FB_HEIGHT);
+  for (int i = 0; i < FB_SIZE; i++) {
+    fputc(~fb->bits[i] & 0xFF, f);
+  }
+  return fclose(f) == 0;
+}
+
+static bool read_pbm(const char* path, framebuffer_t* fb) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  int width, height;
+  bool ok = fscanf(f, "P4 %d %d", &width, &height) == 2 && width == FB_WIDTH && height == FB_HEIGHT &&
+            fgetc(f) != EOF && fread(fb->bits, 1, FB_SIZE, f) == FB_SIZE;
+  fclose(f);
+  for (int i = 0; i < FB_SIZE; i++) {
+    fb->bits[i] = ~fb->bits[i];
+  }
+  return ok;
+}
+
+static int count_differences(const framebuffer_t* a, const framebuffer_t* b) {
+  int count = 0;
+  for (int i = 0; i < FB_SIZE; i++) {
+    count += __builtin_popcount(a->bits[i] ^ b->bits[i]);
+  }
+  return count;
+}
+
+static double seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void set_clock(const scene_t* scene) {
+  clock_now.year = scene->year;
+  clock_now.month = scene->month;
+  clock_now.day = scene->day;
+  clock_now.hour = scene->hour;
+  clock_now.minute = scene->minute;
+  clock_now.second = scene->second;
+  clock_now.ms = 0;
+}
+
+int main(int argc, char** argv) {
+  const char* out_dir = NULL;
+  const char* golden_dir = NULL;
+  int repeats = DEFAULT_REPEATS;
+  int arg = 1;
+  for (; arg + 1 < argc; arg += 2) {
+    if (strcmp(argv[arg], "-o") == 0) {
+      out_dir = argv[arg + 1];
+    } else if (strcmp(argv[arg], "-c") == 0) {
+      golden_dir = argv[arg + 1];
+    } else if (strcmp(argv[arg], "-n") == 0) {
+      repeats = atoi(argv[arg + 1]);
+    } else {
+      break;
+    }
+  }
+  if (arg != argc) {
+    fprintf(stderr, "usage: %s [-o dir] [-c golden_dir] [-n repeats]\n", argv[0]);
+    return 2;
+  }
+
+  Fonts.init();
+  views.status = StatusView.init();
+  views.clock = ClockView.init();
+  views.flipclock = FlipClockView.init();
+  views.calendar = CalendarView.init();
+  views.bank = BankView.init();
+  views.alarm = AlarmView.init();
+
+  bool ok = true;
+  printf("%-24s %10s %10s", "scene", "primitives", "pixels");
+  if (repeats > 0) printf(" %10s %10s", "us/frame", "max us");
+  printf("\n");
+
+  for (size_t i = 0; i < SCENE_COUNT; i++) {
+    const scene_t* scene = &scenes[i];
+    set_clock(scene);
+    View* view = scene->prepare();
+
+    gdisp_host_reset_stats();
+    view->render();
+    gdisp_host_stats_t drawn = *gdisp_host_stats();
+    framebuffer_t frame = *gdisp_host_frame();
+    printf("%-24s %10u %10u", scene->name, drawn.primitives, drawn.pixels);
+
+    // Same inputs again; animated views move on a frame each time, as they
+    // would at their frame rate
+    if (repeats > 0) {
+      double total = 0, worst = 0;
+      for (int r = 0; r < repeats; r++) {
+        double start = seconds();
+        view->render();
+        double elapsed = seconds() - start;
+        total += elapsed;
+        if (elapsed > worst) worst = elapsed;
+      }
+      printf(" %10.2f %10.2f", total / repeats * 1e6, worst * 1e6);
+    }
+    printf("\n");
+
+    char path[512];
+    if (out_dir) {
+      snprintf(path, sizeof(path), "%s/%s.pbm", out_dir, scene->name);
+      if (!write_pbm(path, &frame)) {
+        fprintf(stderr, "%s: cannot write\n", path);
+        ok = false;
+      }
+    }
+    if (golden_dir) {
+      framebuffer_t golden;
+      snprintf(path, sizeof(path), "%s/%s.pbm", golden_dir, scene->name);
+      if (!read_pbm(path, &golden)) {
+        fprintf(stderr, "%s: missing or not a %dx%d PBM\n", path, FB_WIDTH, FB_HEIGHT);
+        ok = false;
+      } else if (count_differences(&frame, &golden) != 0) {
+        fprintf(stderr, "%s: %d pixels differ from %s\n", scene->name, count_differences(&frame, &golden), path);
+        ok = false;
+      }
+    }
+    if (drawn.flushes != 1) {
+      fprintf(stderr, "%s: %u flushes, expected 1\n", scene->name, drawn.flushes);
+      ok = false;
+    }
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+#include "unity.h"
+#include <stdlib.h>
+#include <string.h>
+#include "framebuffer.h"
+#include "sprites/piggy_96_96.h"
+#include "sprites_rle/piggy_96_96.h"
+
+static framebuffer_t frame;
+static framebuffer_t sent;
+static fb_band_t bands[FB_MAX_BANDS];
+
+void setUp(void) {
+  fb_clear(&frame, false);
+  fb_clear(&sent, false);
+}
+void tearDown(void) {}
+
+void test_fill_rect_matches_pixels(void) {
+  static framebuffer_t expected;
+  srand(1);
+  for (int n = 0; n < 500; n++) {
+    int x = rand() % FB_WIDTH, y = rand() % FB_HEIGHT;
+    int cx = 1 + rand() % (FB_WIDTH - x), cy = 1 + rand() % (FB_HEIGHT - y);
+    bool on = n % 3 != 0;
+    fb_fill_rect(&frame, x, y, cx, cy, on);
+    for (int j = y; j < y + cy; j++) {
+      for (int i = x; i < x + cx; i++) {
+        fb_set_pixel(&expected, i, j, on);
+      }
+    }
+    TEST_ASSERT_EQUAL_MEMORY(expected.bits, frame.bits, FB_SIZE);
+  }
+}
+
+void test_unchanged_frame_has_no_bands(void) {
+  fb_fill_rect(&frame, 10, 10, 50, 50, true);
+  fb_fill_rect(&sent, 10, 10, 50, 50, true);
+  TEST_ASSERT_EQUAL_INT(0, fb_diff(&frame, &sent, 6, bands, FB_MAX_BANDS));
+}
+
+void test_band_is_aligned(void) {
+  // A blinking colon: byte 9 (x 72..79) of rows 40..45
+  fb_fill_rect(&frame, 76, 40, 3, 6, true);
+  TEST_ASSERT_EQUAL_INT(1, fb_diff(&frame, &sent, 6, bands, FB_MAX_BANDS));
+  TEST_ASSERT_EQUAL_INT(72, bands[0].x0);
+  TEST_ASSERT_EQUAL_INT(84, bands[0].x1);
+  TEST_ASSERT_EQUAL_INT(40, bands[0].y0);
+  TEST_ASSERT_EQUAL_INT(46, bands[0].y1);
+}
+
+void test_close_rows_merge(void) {
+  fb_set_pixel(&frame, 0, 10, true);
+  fb_set_pixel(&frame, 159, 10 + FB_BAND_MERGE_ROWS, true);
+  fb_set_pixel(&frame, 80, 100, true);
+  TEST_ASSERT_EQUAL_INT(2, fb_diff(&frame, &sent, 6, bands, FB_MAX_BANDS));
+  TEST_ASSERT_EQUAL_INT(0, bands[0].x0);
+  TEST_ASSERT_EQUAL_INT(162, bands[0].x1);  // Widened past the edge to a whole group
+  TEST_ASSERT_EQUAL_INT(10, bands[0].y0);
+  TEST_ASSERT_EQUAL_INT(11 + FB_BAND_MERGE_ROWS, bands[0].y1);
+  TEST_ASSERT_EQUAL_INT(100, bands[1].y0);
+  TEST_ASSERT_EQUAL_INT(101, bands[1].y1);
+}
+
+void test_last_band_absorbs_overflow(void) {
+  for (int y = 0; y < FB_HEIGHT; y += 2 * FB_BAND_MERGE_ROWS) {
+    fb_set_pixel(&frame, y % FB_WIDTH, y, true);
+  }
+  TEST_ASSERT_EQUAL_INT(3, fb_diff(&frame, &sent, 1, bands, 3));
+  TEST_ASSERT_EQUAL_INT(4 * FB_BAND_MERGE_ROWS, bands[2].y0);
+  TEST_ASSERT_EQUAL_INT(FB_HEIGHT - 2 * FB_BAND_MERGE_ROWS + 1, bands[2].y1);
+}
+
+void test_commit_clears_difference(void) {
+  srand(2);
+  for (int n = 0; n < 200; n++) {
+    fb_set_pixel(&frame, rand() % FB_WIDTH, rand() % FB_HEIGHT, rand() % 2);
+    int count = fb_diff(&frame, &sent, 6, bands, FB_MAX_BANDS);
+    for (int i = 0; i < count; i++) {
+      fb_commit(&sent, &frame, &bands[i]);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(frame.bits, sent.bits, FB_SIZE);
+  }
+}
+
+void test_blit_matches_pixels(void) {
+  static framebuffer_t expected;
+  static uint8_t bits[15 * 40];
+  srand(2);
+  for (int n = 0; n < 300; n++) {
+    // Wide enough for the word loop, the odd bytes and the spill
+    fb_sprite_t sprite = {1 + rand() % 120, 1 + rand() % 40, 0, bits};
+    sprite.stride = (sprite.width + 7) / 8;
+    memset(bits, 0, sizeof(bits));
+    for (int r = 0; r < sprite.height; r++) {
+      for (int c = 0; c < sprite.width; c++) {
+        if (rand() % 2) bits[r * sprite.stride + (c >> 3)] |= 0x80 >> (c & 7);
+      }
+    }
+    // Includes positions hanging off every edge
+    int x = rand() % (FB_WIDTH + 40) - 20 - sprite.width / 2;
+    int y = rand() % (FB_HEIGHT + 40) - 20 - sprite.height / 2;
+
+    fb_blit(&frame, x, y, &sprite);
+    for (int r = 0; r < sprite.height; r++) {
+      for (int c = 0; c < sprite.width; c++) {
+        int px = x + c, py = y + r;
+        if (px < 0 || py < 0 || px >= FB_WIDTH || py >= FB_HEIGHT) continue;
+        if (bits[r * sprite.stride + (c >> 3)] & (0x80 >> (c & 7))) fb_set_pixel(&expected, px, py, true);
+      }
+    }
+    TEST_ASSERT_EQUAL_MEMORY(expected.bits, frame.bits, FB_SIZE);
+  }
+}
+
+void test_rle_unpack(void) {
+  // 3 literals, then 0xAA x 4, then 0x0F x 2 as literals
+  static const uint8_t data[] = {0x02, 0x80, 0x40, 0x20, 0xFD, 0xAA, 0x01, 0x0F, 0x0F};
+  static const uint8_t expected[] = {0x80, 0x40, 0x20, 0xAA, 0xAA, 0xAA, 0xAA, 0x0F, 0x0F};
+  fb_rle_sprite_t rle = {24, 3, 3, sizeof(data), data};
+  uint8_t bits[9];
+  fb_sprite_t sprite;
+  TEST_ASSERT_TRUE(fb_rle_unpack(&rle, bits, &sprite));
+  TEST_ASSERT_EQUAL_MEMORY(expected, bits, sizeof(expected));
+  TEST_ASSERT_EQUAL_UINT16(24, sprite.width);
+  TEST_ASSERT_EQUAL_PTR(bits, sprite.bits);
+
+  // One byte short, and a run past the end
+  rle.size = sizeof(data) - 1;
+  TEST_ASSERT_FALSE(fb_rle_unpack(&rle, bits, &sprite));
+  rle.height = 2;
+  rle.size = sizeof(data);
+  TEST_ASSERT_FALSE(fb_rle_unpack(&rle, bits, &sprite));
+}
+
+void test_piggy_asset(void) {
+  // Both headers come from tools/bmp2sprite.py at build time
+  TEST_ASSERT_EQUAL_UINT16(94, piggy_96_96_sprite.width);
+  TEST_ASSERT_EQUAL_UINT16(96, piggy_96_96_sprite.height);
+  TEST_ASSERT_EQUAL_UINT16(12, piggy_96_96_sprite.stride);
+  TEST_ASSERT_EQUAL_size_t(12 * 96, sizeof(piggy_96_96_bits));
+
+  static uint8_t bits[12 * 96];
+  fb_sprite_t unpacked;
+  TEST_ASSERT_TRUE(fb_rle_unpack(&piggy_96_96_rle, bits, &unpacked));
+  TEST_ASSERT_EQUAL_MEMORY(piggy_96_96_bits, bits, sizeof(bits));
+
+  // The outline is white on black: the top-left corner is clear, the ear set
+  fb_blit(&frame, 0, 0, &piggy_96_96_sprite);
+  TEST_ASSERT_FALSE(fb_get_pixel(&frame, 0, 0));
+  TEST_ASSERT_TRUE(fb_get_pixel(&frame, 7, 0));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_fill_rect_matches_pixels);
+  RUN_TEST(test_unchanged_frame_has_no_bands);
+  RUN_TEST(test_band_is_aligned);
+  RUN_TEST(test_close_rows_merge);
+  RUN_TEST(test_last_band_absorbs_overflow);
+  RUN_TEST(test_commit_clears_difference);
+  RUN_TEST(test_blit_matches_pixels);
+  RUN_TEST(test_rle_unpack);
+  RUN_TEST(test_piggy_asset);
+  return UNITY_END();
+}
@@ -0,0 +1,363 @@
+#include "unity.h"
+#include "ICalParser.h"
+#include "ical_test_helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define DAY 86400L
+#define NOW ((time_t)1768469400)  // 2026-01-15 09:30
+#define URL "https://calendar.example.com/basic.ics"
+
+static uint32_t rng_state = 0x2545f491;
+static uint32_t rng(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+// In-memory stand-in for a LittleFS File
+class MemoryStream : public Stream {
+public:
+  uint8_t data[8192];
+  size_t length = 0;
+  size_t pos = 0;
+
+  size_t write(uint8_t c) override {
+    if (length >= sizeof(data)) return 0;
+    data[length++] = c;
+    return 1;
+  }
+  int available() override { return (int)(length - pos); }
+  int read() override { return pos < length ? data[pos++] : -1; }
+  int peek() override { return pos < length ? data[pos] : -1; }
+};
+
+void test_uncommitted_cache_is_not_valid(void) {
+  static ICalEventCache cache;
+  TEST_ASSERT_FALSE(cache.validFor(URL));
+
+  cache.begin(URL);
+  cache.add(NOW, 3600, make_rule(ICAL_FREQ_NONE, 1, 0, 0, 0), "Standup");
+  TEST_ASSERT_FALSE(cache.validFor(URL));
+
+  cache.commit("\"abc\"", "Thu, 15 Jan 2026 09:00:00 GMT", 1000);
+  TEST_ASSERT_TRUE(cache.validFor(URL));
+  TEST_ASSERT_FALSE(cache.validFor("https://calendar.example.com/other.ics"));
+  TEST_ASSERT_EQUAL_STRING("\"abc\"", cache.etag());
+  TEST_ASSERT_EQUAL_STRING("Thu, 15 Jan 2026 09:00:00 GMT", cache.lastModified());
+
+  cache.clear();
+  TEST_ASSERT_FALSE(cache.validFor(URL));
+  TEST_ASSERT_EQUAL_STRING("", cache.etag());
+}
+
+void test_freshness_window(void) {
+  static ICalEventCache cache;
+  cache.begin(URL);
+  cache.commit("\"abc\"", "", 1000);
+
+  TEST_ASSERT_TRUE(cache.freshFor(URL, 1000, 500));
+  TEST_ASSERT_TRUE(cache.freshFor(URL, 1499, 500));
+  TEST_ASSERT_FALSE(cache.freshFor(URL, 1500, 500));
+  TEST_ASSERT_FALSE(cache.freshFor(URL, 1000, 0));
+
+  cache.touch(5000);
+  TEST_ASSERT_TRUE(cache.freshFor(URL, 5100, 500));
+
+  // millis() wraparound
+  cache.touch((unsigned long)-100);
+  TEST_ASSERT_TRUE(cache.freshFor(URL, 200, 500));
+}
+
+void test_oversized_validator_is_dropped(void) {
+  static ICalEventCache cache;
+  char etag[ICAL_VALIDATOR_LEN + 10];
+  memset(etag, 'e', sizeof(etag) - 1);
+  etag[sizeof(etag) - 1] = '\0';
+
+  cache.begin(URL);
+  cache.commit(etag, "Thu, 15 Jan 2026 09:00:00 GMT", 0);
+  TEST_ASSERT_TRUE(cache.validFor(URL));
+  TEST_ASSERT_EQUAL_STRING("", cache.etag());
+  TEST_ASSERT_EQUAL_STRING("Thu, 15 Jan 2026 09:00:00 GMT", cache.lastModified());
+}
+
+void test_overflow_disables_cache(void) {
+  static ICalEventCache cache;
+  ICalRRule none = make_rule(ICAL_FREQ_NONE, 1, 0, 0, 0);
+
+  cache.begin(URL);
+  for (int i = 0; i < ICAL_CACHE_MAX_RECORDS; i++) {
+    TEST_ASSERT_TRUE(cache.add(NOW + i, 60, none, "x"));
+  }
+  TEST_ASSERT_FALSE(cache.add(NOW, 60, none, "x"));
+  cache.commit("\"abc\"", "", 0);
+  TEST_ASSERT_FALSE(cache.validFor(URL));
+
+  // Long titles exhaust the pool before the record table
+  char title[ICAL_MAX_TITLE_LEN];
+  memset(title, 't', sizeof(title) - 1);
+  title[sizeof(title) - 1] = '\0';
+  cache.begin(URL);
+  bool full = false;
+  for (int i = 0; i < ICAL_CACHE_MAX_RECORDS && !full; i++) {
+    full = !cache.add(NOW + i, 60, none, title);
+  }
+  TEST_ASSERT_TRUE(full);
+  cache.commit("\"abc\"", "", 0);
+  TEST_ASSERT_FALSE(cache.validFor(URL));
+}
+
+void test_expand_recurring(void) {
+  static ICalEventCache cache;
+  static ICalTopKN<ICAL_MAX_EVENTS> top;
+  cache.begin(URL);
+  cache.add(NOW - 7 * DAY, 1800, make_rule(ICAL_FREQ_WEEKLY, 1, 0, 0, 0), "Weekly sync");
+  cache.add(NOW + 2 * DAY, 3600, make_rule(ICAL_FREQ_NONE, 1, 0, 0, 0), "Dentist");
+  cache.commit("\"abc\"", "", 0);
+
+  top.begin(5);
+  cache.expand(NOW + 3 * DAY, &top);
+  top.finish();
+  TEST_ASSERT_EQUAL_INT(1, top.count());
+  TEST_ASSERT_EQUAL_STRING("Weekly sync", top.title(0));
+  TEST_ASSERT_EQUAL_INT64(NOW + 7 * DAY, top.occurrence(0));
+  TEST_ASSERT_EQUAL_INT64(NOW + 7 * DAY + 1800, top.endOccurrence(0));
+}
+
+void test_expand_window_with_exceptions(void) {
+  static ICalEventCache cache;
+  static MemoryStream file;
+  static ICalTopKN<ICAL_MAX_EVENTS> top;
+  static ICalTopKN<ICAL_MAX_EVENTS> restored;
+
+  // Daily at NOW + 1h; the 2nd instance is an EXDATE, the 3rd was moved
+  time_t exdates[] = {NOW + 3600 + DAY};
+  ICalSeries daily = {NOW + 3600 - 10 * DAY, 900, make_rule(ICAL_FREQ_DAILY, 1, 0, 0, 0), 0x1234, exdates, 1};
+  cache.begin(URL);
+  TEST_ASSERT_TRUE(cache.add(daily, "Standup"));
+  TEST_ASSERT_TRUE(cache.add(NOW + 2 * DAY + 7200, 900, make_rule(ICAL_FREQ_NONE, 1, 0, 0, 0), "Standup (moved)"));
+  TEST_ASSERT_TRUE(cache.addOverride(0x1234, NOW + 3600 + 2 * DAY));
+  TEST_ASSERT_TRUE(cache.addOverride(0x9999, NOW + 3600 + 3 * DAY));  // Another event's
+  cache.commit("\"v1\"", "", 0);
+
+  top.begin(ICAL_MAX_EVENTS);
+  cache.expand(NOW, &top, 4 * DAY + 3600);
+  top.finish();
+  TEST_ASSERT_EQUAL_INT(4, top.count());
+  TEST_ASSERT_EQUAL_INT64(NOW + 3600, top.occurrence(0));
+  TEST_ASSERT_EQUAL_STRING("Standup (moved)", top.title(1));
+  TEST_ASSERT_EQUAL_INT64(NOW + 3600 + 3 * DAY, top.occurrence(2));
+  TEST_ASSERT_EQUAL_INT64(NOW + 3600 + 3 * DAY + 900, top.endOccurrence(2));
+  TEST_ASSERT_EQUAL_INT64(NOW + 3600 + 4 * DAY, top.occurrence(3));
+
+  // Without a horizon only the next instance is listed
+  top.begin(ICAL_MAX_EVENTS);
+  cache.expand(NOW + 2 * 3600, &top);
+  top.finish();
+  TEST_ASSERT_EQUAL_INT(2, top.count());
+  TEST_ASSERT_EQUAL_STRING("Standup (moved)", top.title(0));
+  TEST_ASSERT_EQUAL_INT64(NOW + 3600 + 3 * DAY, top.occurrence(1));
+
+  // Exceptions survive a save and load
+  file.length = file.pos = 0;
+  TEST_ASSERT_TRUE(cache.save(file));
+  static ICalEventCache loaded;
+  TEST_ASSERT_TRUE(loaded.load(file));
+  restored.begin(ICAL_MAX_EVENTS);
+  loaded.expand(NOW, &restored, 4 * DAY + 3600);
+  restored.finish();
+  top.begin(ICAL_MAX_EVENTS);
+  cache.expand(NOW, &top, 4 * DAY + 3600);
+  top.finish();
+  TEST_ASSERT_EQUAL_INT(top.count(), restored.count());
+  for (int i = 0; i < top.count(); i++) {
+    TEST_ASSERT_EQUAL_INT64(top.occurrence(i), restored.occurrence(i));
+  }
+}
+
+void test_exdates_count_against_the_cache(void) {
+  static ICalEventCache cache;
+  static time_t exdates[ICAL_MAX_EXDATES];
+  for (int i = 0; i < ICAL_MAX_EXDATES; i++) exdates[i] = NOW + i * DAY;
+  ICalSeries series = {NOW, 60, make_rule(ICAL_FREQ_DAILY, 1, 0, 0, 0), 1, exdates, ICAL_MAX_EXDATES};
+
+  cache.begin(URL);
+  int added = 0;
+  while (cache.add(series, "x")) added++;
+  TEST_ASSERT_EQUAL_INT(ICAL_CACHE_MAX_EXDATES / ICAL_MAX_EXDATES, added);
+  cache.commit("", "", 0);
+  TEST_ASSERT_FALSE(cache.validFor(URL));
+}
+
+void test_save_and_load_round_trip(void) {
+  static ICalEventCache saved;
+  static ICalEventCache loaded;
+  static ICalTopKN<ICAL_MAX_EVENTS> before;
+  static ICalTopKN<ICAL_MAX_EVENTS> after;
+  static MemoryStream file;
+
+  saved.begin(URL);
+  saved.add(NOW - 7 * DAY, 1800, make_rule(ICAL_FREQ_WEEKLY, 1, 0, 0, 0x22), "Weekly sync");
+  saved.add(NOW + 2 * DAY, 3600, make_rule(ICAL_FREQ_NONE, 1, 0, 0, 0), "Dentist");
+  saved.add(NOW - 30 * DAY, 0, make_rule(ICAL_FREQ_MONTHLY, 1, NOW + 90 * DAY, 0, 0), "");
+  saved.commit("\"v7\"", "Thu, 15 Jan 2026 09:00:00 GMT", 1000);
+  TEST_ASSERT_FALSE(saved.stale());
+
+  file.length = file.pos = 0;
+  TEST_ASSERT_TRUE(saved.save(file));
+  TEST_ASSERT_TRUE(loaded.load(file));
+
+  // Restored: usable for revalidation and expansion, but never fresh
+  TEST_ASSERT_TRUE(loaded.stale());
+  TEST_ASSERT_TRUE(loaded.validFor(URL));
+  TEST_ASSERT_FALSE(loaded.freshFor(URL, 1000, 900000));
+  TEST_ASSERT_EQUAL_STRING("\"v7\"", loaded.etag());
+  TEST_ASSERT_EQUAL_STRING("Thu, 15 Jan 2026 09:00:00 GMT", loaded.lastModified());
+  TEST_ASSERT_EQUAL_INT(3, loaded.count());
+
+  before.begin(ICAL_MAX_EVENTS);
+  saved.expand(NOW + DAY, &before);
+  before.finish();
+  after.begin(ICAL_MAX_EVENTS);
+  loaded.expand(NOW + DAY, &after);
+  after.finish();
+  TEST_ASSERT_EQUAL_INT(before.count(), after.count());
+  for (int i = 0; i < before.count(); i++) {
+    TEST_ASSERT_EQUAL_INT64(before.occurrence(i), after.occurrence(i));
+    TEST_ASSERT_EQUAL_INT64(before.endOccurrence(i), after.endOccurrence(i));
+    TEST_ASSERT_EQUAL_STRING(before.title(i), after.title(i));
+  }
+
+  // A successful revalidation makes it fresh again
+  loaded.touch(2000);
+  TEST_ASSERT_FALSE(loaded.stale());
+  TEST_ASSERT_TRUE(loaded.freshFor(URL, 2500, 900000));
+}
+
+void test_load_rejects_bad_snapshots(void) {
+  static ICalEventCache cache;
+  static MemoryStream file;
+
+  // Not committed: nothing to save
+  cache.begin(URL);
+  file.length = file.pos = 0;
+  TEST_ASSERT_FALSE(cache.save(file));
+
+  cache.add(NOW, 60, make_rule(ICAL_FREQ_NONE, 1, 0, 0, 0), "Standup");
+  cache.commit("\"abc\"", "", 0);
+  TEST_ASSERT_TRUE(cache.save(file));
+  size_t fullLength = file.length;
+
+  // Truncated file
+  file.length = fullLength - 3;
+  file.pos = 0;
+  TEST_ASSERT_FALSE(cache.load(file));
+  TEST_ASSERT_FALSE(cache.validFor(URL));
+
+  // Corrupted magic
+  file.length = fullLength;
+  file.pos = 0;
+  file.data[0] ^= 0xFF;
+  TEST_ASSERT_FALSE(cache.load(file));
+  file.data[0] ^= 0xFF;
+
+  // Unterminated title pool
+  file.pos = 0;
+  file.data[fullLength - 1] = 'x';
+  TEST_ASSERT_FALSE(cache.load(file));
+  file.data[fullLength - 1] = '\0';
+
+  file.pos = 0;
+  TEST_ASSERT_TRUE(cache.load(file));
+  TEST_ASSERT_TRUE(cache.validFor(URL));
+}
+
+#define RANDOM_FEEDS 100
+#define FEED_EVENTS 200
+
+// Re-expanding the cached records for a later "now" must give the same list
+// as parsing the whole (unchanged) feed again at that time
+void test_expand_matches_full_reparse(void) {
+  static ICalEventCache cache;
+  static ICalTopKN<ICAL_MAX_EVENTS> fromCache;
+  static ICalTopKN<ICAL_MAX_EVENTS> fromFeed;
+  static time_t dtstarts[FEED_EVENTS];
+  static time_t durations[FEED_EVENTS];
+  static ICalRRule rules[FEED_EVENTS];
+  static char titles[FEED_EVENTS][16];
+  int cachedFeeds = 0;
+
+  for (int f = 0; f < RANDOM_FEEDS; f++) {
+    for (int i = 0; i < FEED_EVENTS; i++) {
+      dtstarts[i] = NOW - (time_t)(rng() % (3 * 365)) * DAY + (time_t)(rng() % (60 * DAY));
+      durations[i] = (time_t)(rng() % 240) * 60;
+      // Mostly one-off events, as in a real feed
+      ICalFreq freq = (rng() % 4 == 0) ? (ICalFreq)(1 + rng() % 4) : ICAL_FREQ_NONE;
+      int count = (rng() % 3 == 0) ? (int)(1 + rng() % 50) : 0;
+      time_t until = (rng() % 3 == 0) ? NOW + (time_t)(rng() % (30 * DAY)) : 0;
+      uint8_t byDay = (freq == ICAL_FREQ_WEEKLY && rng() % 2) ? (uint8_t)(1 + rng() % 127) : 0;
+      rules[i] = make_rule(freq, 1 + (int)(rng() % 3), until, count, byDay);
+      snprintf(titles[i], sizeof(titles[i]), "event %d", i);
+    }
+
+    // Initial fetch at NOW: only events with an occurrence left are cached
+    cache.begin(URL);
+    for (int i = 0; i < FEED_EVENTS; i++) {
+      if (ICalParser::getNextOccurrence(dtstarts[i], rules[i], NOW) > 0) {
+        cache.add(dtstarts[i], durations[i], rules[i], titles[i]);
+      }
+    }
+    cache.commit("\"v1\"", "", 0);
+    if (!cache.validFor(URL)) continue;
+    cachedFeeds++;
+
+    time_t later = NOW + (time_t)(rng() % (45 * DAY));
+    int k = 1 + (int)(rng() % ICAL_MAX_EVENTS);
+
+    fromCache.begin(k);
+    cache.expand(later, &fromCache);
+    fromCache.finish();
+
+    fromFeed.begin(k);
+    for (int i = 0; i < FEED_EVENTS; i++) {
+      time_t next = ICalParser::getNextOccurrence(dtstarts[i], rules[i], later);
+      if (next > 0) fromFeed.offer(next, next + durations[i], titles[i]);
+    }
+    fromFeed.finish();
+
+    TEST_ASSERT_EQUAL_INT(fromFeed.count(), fromCache.count());
+    for (int i = 0; i < fromFeed.count(); i++) {
+      TEST_ASSERT_EQUAL_INT64(fromFeed.occurrence(i), fromCache.occurrence(i));
+      TEST_ASSERT_EQUAL_INT64(fromFeed.endOccurrence(i), fromCache.endOccurrence(i));
+      TEST_ASSERT_EQUAL_STRING(fromFeed.title(i), fromCache.title(i));
+    }
+  }
+
+  // Most generated feeds must fit, or this test proves nothing
+  TEST_ASSERT_TRUE(cachedFeeds > RANDOM_FEEDS / 2);
+}
+
+int main(void) {
+  setenv("TZ", "UTC0", 1);
+  tzset();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_uncommitted_cache_is_not_valid);
+  RUN_TEST(test_freshness_window);
+  RUN_TEST(test_oversized_validator_is_dropped);
+  RUN_TEST(test_overflow_disables_cache);
+  RUN_TEST(test_expand_recurring);
+  RUN_TEST(test_expand_window_with_exceptions);
+  RUN_TEST(test_exdates_count_against_the_cache);
+  RUN_TEST(test_save_and_load_round_trip);
+  RUN_TEST(test_load_rejects_bad_snapshots);
+  RUN_TEST(test_expand_matches_full_reparse);
+  return UNITY_END();
+}
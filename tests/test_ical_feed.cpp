@@ -0,0 +1,257 @@
+#include "unity.h"
+#include "ICalParser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NOW ((time_t)1768469400)  // 2026-01-15 09:30
+
+static ICalParser parser;
+static ICalResult result;
+static ICalTopKN<ICAL_MAX_EVENTS> events;
+static WiFiClient feed;
+
+void setUp(void) {
+  parser.setCache(nullptr);
+  memset(&result, 0, sizeof(result));
+  events.begin(ICAL_MAX_EVENTS);
+}
+void tearDown(void) {
+  feed.close();
+}
+
+// Serve text through the file-backed WiFiClient
+static void open_text(const char* text) {
+  char path[] = "/tmp/ical_feedXXXXXX";
+  int fd = mkstemp(path);
+  TEST_ASSERT_TRUE(fd >= 0);
+  TEST_ASSERT_EQUAL_INT((int)strlen(text), (int)write(fd, text, strlen(text)));
+  close(fd);
+  TEST_ASSERT_TRUE(feed.open(path));
+  unlink(path);
+}
+
+static bool parse(void) {
+  parser.setHorizon(0);
+  bool complete = parser.parseStream(feed, NOW, &events, &result);
+  events.finish();
+  return complete;
+}
+
+void test_events_in_order(void) {
+  open_text("BEGIN:VCALENDAR\r\n"
+            "BEGIN:VEVENT\r\n"
+            "DTSTART:20260120T100000Z\r\n"
+            "DTEND:20260120T110000Z\r\n"
+            "SUMMARY:Later\r\n"
+            "END:VEVENT\r\n"
+            "BEGIN:VEVENT\r\n"
+            "DTSTART;VALUE=DATE:20260116\r\n"
+            "SUMMARY:All day\r\n"
+            "END:VEVENT\r\n"
+            "BEGIN:VEVENT\r\n"
+            "DTSTART:20250101T100000Z\r\n"
+            "SUMMARY:Past\r\n"
+            "END:VEVENT\r\n"
+            "END:VCALENDAR\r\n");
+  TEST_ASSERT_TRUE(parse());
+  TEST_ASSERT_EQUAL_INT(3, result.totalEventsParsed);
+  TEST_ASSERT_EQUAL_INT(2, events.count());
+  TEST_ASSERT_EQUAL_STRING("All day", events.title(0));
+  TEST_ASSERT_EQUAL_STRING("Later", events.title(1));
+  TEST_ASSERT_EQUAL_INT64(ICalParser::parseDate("20260120T110000Z"), events.endOccurrence(1));
+}
+
+void test_skipped_event_does_not_hide_the_next(void) {
+  // A cancelled event or override used to leave "END:VEVENT" in the line
+  // buffer, so the following BEGIN:VEVENT was never recognised. The
+  // override itself is listed at its own start.
+  open_text("BEGIN:VCALENDAR\n"
+            "BEGIN:VEVENT\n"
+            "DTSTART:20260116T100000Z\n"
+            "STATUS:CANCELLED\n"
+            "SUMMARY:Cancelled\n"
+            "END:VEVENT\n"
+            "BEGIN:VEVENT\n"
+            "DTSTART:20260117T100000Z\n"
+            "SUMMARY:Kept\n"
+            "END:VEVENT\n"
+            "BEGIN:VEVENT\n"
+            "DTSTART:20260118T100000Z\n"
+            "RECURRENCE-ID:20260112T100000Z\n"
+            "SUMMARY:Override\n"
+            "END:VEVENT\n"
+            "BEGIN:VEVENT\n"
+            "DTSTART:20260119T100000Z\n"
+            "SUMMARY:Also kept\n"
+            "END:VEVENT\n"
+            "END:VCALENDAR\n");
+  TEST_ASSERT_TRUE(parse());
+  TEST_ASSERT_EQUAL_INT(4, result.totalEventsParsed);
+  TEST_ASSERT_EQUAL_INT(3, events.count());
+  TEST_ASSERT_EQUAL_STRING("Kept", events.title(0));
+  TEST_ASSERT_EQUAL_STRING("Override", events.title(1));
+  TEST_ASSERT_EQUAL_STRING("Also kept", events.title(2));
+}
+
+void test_truncated_feed_is_incomplete(void) {
+  open_text("BEGIN:VCALENDAR\n"
+            "BEGIN:VEVENT\n"
+            "DTSTART:20260116T100000Z\n"
+            "SUMMARY:Complete event\n"
+            "END:VEVENT\n"
+            "BEGIN:VEVENT\n"
+            "DTSTART:20260117T1000");
+  TEST_ASSERT_FALSE(parse());
+  TEST_ASSERT_EQUAL_INT(1, events.count());
+}
+
+// A daily standup with one EXDATE and two overrides (one moved, one
+// cancelled), then a one-off later in the week
+static const char* STANDUP_MASTER =
+    "BEGIN:VEVENT\n"
+    "DTSTART;TZID=Europe/Berlin:20251201T100000\n"
+    "DTEND;TZID=Europe/Berlin:20251201T101500\n"
+    "RRULE:FREQ=DAILY\n"
+    "EXDATE;TZID=Europe/Berlin:20260116T100000,20260120T100000\n"
+    "UID:standup@example.com\n"
+    "SUMMARY:Standup\n"
+    "BEGIN:VALARM\n"
+    "ACTION:EMAIL\n"
+    "SUMMARY:Reminder\n"
+    "END:VALARM\n"
+    "END:VEVENT\n";
+static const char* STANDUP_OVERRIDES =
+    "BEGIN:VEVENT\n"
+    "DTSTART;TZID=Europe/Berlin:20260117T113000\n"
+    "DTEND;TZID=Europe/Berlin:20260117T114500\n"
+    "RECURRENCE-ID;TZID=Europe/Berlin:20260117T100000\n"
+    "UID:standup@example.com\n"
+    "SUMMARY:Standup (late)\n"
+    "END:VEVENT\n"
+    "BEGIN:VEVENT\n"
+    "DTSTART;TZID=Europe/Berlin:20260118T100000\n"
+    "RECURRENCE-ID;TZID=Europe/Berlin:20260118T100000\n"
+    "UID:standup@example.com\n"
+    "STATUS:CANCELLED\n"
+    "SUMMARY:Standup\n"
+    "END:VEVENT\n";
+static const char* ONE_OFF =
+    "BEGIN:VEVENT\n"
+    "DTSTART:20260121T120000\n"
+    "SUMMARY:Lunch\n"
+    "END:VEVENT\n";
+
+static void check_standup_week(void) {
+  static const char* expected[][2] = {
+      {"2026-01-15 10:00", "Standup"},      {"2026-01-17 11:30", "Standup (late)"},
+      {"2026-01-19 10:00", "Standup"},      {"2026-01-21 10:00", "Standup"},
+      {"2026-01-21 12:00", "Lunch"},
+  };
+  int n = (int)(sizeof(expected) / sizeof(expected[0]));
+  TEST_ASSERT_EQUAL_INT(n, events.count());
+  for (int i = 0; i < n; i++) {
+    ICalEvent event;
+    events.getEvent(i, &event);
+    TEST_ASSERT_EQUAL_STRING(expected[i][0], event.datetime);
+    TEST_ASSERT_EQUAL_STRING(expected[i][1], event.title);
+  }
+}
+
+static void parse_window(const char* first, const char* second, ICalEventCache* cache) {
+  static char text[2048];
+  snprintf(text, sizeof(text), "BEGIN:VCALENDAR\n%s%s%sEND:VCALENDAR\n", first, second, ONE_OFF);
+  open_text(text);
+  parser.setCache(cache);
+  parser.setHorizon(6 * 86400L + 3600);  // Through 2026-01-21 10:30
+  if (cache) cache->begin("standup");
+  TEST_ASSERT_TRUE(parser.parseStream(feed, NOW, &events, &result));
+  events.finish();
+}
+
+void test_window_with_exceptions(void) {
+  // With a cache every event waits for finish(), so the overrides apply
+  // wherever they are in the feed
+  static ICalEventCache cache;
+  parse_window(STANDUP_MASTER, STANDUP_OVERRIDES, &cache);
+  check_standup_week();
+
+  setUp();
+  parse_window(STANDUP_OVERRIDES, STANDUP_MASTER, &cache);
+  check_standup_week();
+  cache.commit("", "", 0);
+
+  // The cache re-expands to the same week
+  memset(&result, 0, sizeof(result));
+  events.begin(ICAL_MAX_EVENTS);
+  cache.expand(NOW, &events, 6 * 86400L + 3600);
+  events.finish();
+  check_standup_week();
+
+  // Without one, overrides apply to an event that comes after them
+  setUp();
+  parse_window(STANDUP_OVERRIDES, STANDUP_MASTER, nullptr);
+  check_standup_week();
+}
+
+void test_window_stops_when_list_is_full(void) {
+  setUp();
+  events.begin(3);
+  parse_window(STANDUP_MASTER, "", nullptr);
+  TEST_ASSERT_EQUAL_INT(3, events.count());
+  TEST_ASSERT_EQUAL_STRING("Standup", events.title(2));
+  TEST_ASSERT_EQUAL_INT64(ICalParser::parseDate("20260118T100000"), events.occurrence(2));
+}
+
+void test_corpus_feeds(void) {
+  static time_t uncached[ICAL_MAX_EVENTS];
+  TEST_ASSERT_TRUE(feed.open(ESP_CORPUS_DIR "/work.ics"));
+  feed.setSegmentSize(1460);
+  TEST_ASSERT_TRUE(parse());
+  TEST_ASSERT_EQUAL_INT(180, result.totalEventsParsed);
+  TEST_ASSERT_EQUAL_INT(ICAL_MAX_EVENTS, events.count());
+  for (int i = 1; i < events.count(); i++) {
+    TEST_ASSERT_TRUE(events.occurrence(i - 1) <= events.occurrence(i));
+  }
+  int uncachedCount = events.count();
+  for (int i = 0; i < uncachedCount; i++) {
+    uncached[i] = events.occurrence(i);
+  }
+
+  // The feed overflows the cache part way: events it took are expanded at
+  // the end, the rest as they are read, and the list comes out the same
+  static ICalEventCache cache;
+  setUp();
+  parser.setCache(&cache);
+  feed.rewind();
+  cache.begin("work");
+  TEST_ASSERT_TRUE(parse());
+  cache.commit("", "", 0);
+  TEST_ASSERT_FALSE(cache.validFor("work"));
+  TEST_ASSERT_EQUAL_INT(uncachedCount, events.count());
+  for (int i = 0; i < uncachedCount; i++) {
+    TEST_ASSERT_EQUAL_INT64(uncached[i], events.occurrence(i));
+  }
+
+  setUp();
+  TEST_ASSERT_TRUE(feed.open(ESP_CORPUS_DIR "/holidays.ics"));
+  TEST_ASSERT_TRUE(parse());
+  TEST_ASSERT_EQUAL_INT(230, result.totalEventsParsed);
+  TEST_ASSERT_EQUAL_INT(0, result.recurringEventsParsed);
+}
+
+int main(void) {
+  setenv("TZ", "UTC0", 1);
+  tzset();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_events_in_order);
+  RUN_TEST(test_skipped_event_does_not_hide_the_next);
+  RUN_TEST(test_truncated_feed_is_incomplete);
+  RUN_TEST(test_window_with_exceptions);
+  RUN_TEST(test_window_stops_when_list_is_full);
+  RUN_TEST(test_corpus_feeds);
+  return UNITY_END();
+}
@@ -0,0 +1,366 @@
+#include "unity.h"
+#include "ICalParser.h"
+#include "ical_test_helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define DAY 86400L
+
+// Reference: the original one-step-at-a-time walk with mktime(), without the
+// 2000 iteration safety limit so long-running rules can be compared too.
+static time_t reference_next_occurrence(time_t dtstart, ICalRRule rule, time_t after) {
+  if (rule.freq == ICAL_FREQ_NONE) {
+    return (dtstart >= after) ? dtstart : 0;
+  }
+  if (rule.until > 0 && after > rule.until) {
+    return 0;
+  }
+
+  struct tm startTm;
+  struct tm* startPtr = localtime(&dtstart);
+  memcpy(&startTm, startPtr, sizeof(struct tm));
+
+  time_t candidate = dtstart;
+  int occurrenceCount = 1;
+  if (candidate >= after) {
+    return candidate;
+  }
+
+  while (true) {
+    switch (rule.freq) {
+      case ICAL_FREQ_DAILY:
+        startTm.tm_mday += rule.interval;
+        break;
+      case ICAL_FREQ_WEEKLY:
+        if (rule.byDay == 0) {
+          startTm.tm_mday += 7 * rule.interval;
+        } else {
+          startTm.tm_mday += 1;
+          time_t temp = mktime(&startTm);
+          struct tm* tempTm = localtime(&temp);
+          if (!((rule.byDay >> tempTm->tm_wday) & 1)) {
+            continue;
+          }
+        }
+        break;
+      case ICAL_FREQ_MONTHLY:
+        startTm.tm_mon += rule.interval;
+        break;
+      case ICAL_FREQ_YEARLY:
+        startTm.tm_year += rule.interval;
+        break;
+      default:
+        return 0;
+    }
+
+    candidate = mktime(&startTm);
+    occurrenceCount++;
+
+    if (rule.count > 0 && occurrenceCount > rule.count) {
+      return 0;
+    }
+    if (rule.until > 0 && candidate > rule.until) {
+      return 0;
+    }
+    if (candidate >= after) {
+      return candidate;
+    }
+  }
+}
+
+// 2026-01-15 09:30:00 (Thursday)
+static const time_t NOW = 1768469400;
+
+void test_non_recurring(void) {
+  ICalRRule rule = make_rule(ICAL_FREQ_NONE, 1, 0, 0, 0);
+  TEST_ASSERT_EQUAL_INT64(NOW + 60, ICalParser::getNextOccurrence(NOW + 60, rule, NOW));
+  TEST_ASSERT_EQUAL_INT64(0, ICalParser::getNextOccurrence(NOW - 60, rule, NOW));
+}
+
+void test_daily_standup_from_years_ago(void) {
+  // 2019-03-04 09:00 daily; the old walk gave up after 2000 iterations
+  time_t dtstart = ICalParser::parseDate("20190304T090000");
+  ICalRRule rule = ICalParser::parseRRule("FREQ=DAILY");
+  time_t next = ICalParser::getNextOccurrence(dtstart, rule, NOW);
+  TEST_ASSERT_EQUAL_INT64(ICalParser::parseDate("20260116T090000"), next);
+  TEST_ASSERT_EQUAL_INT64(reference_next_occurrence(dtstart, rule, NOW), next);
+}
+
+void test_weekly_byday(void) {
+  // Mon/Wed/Fri starting Monday 2025-12-01 10:00; next after Thu 09:30 is Fri
+  time_t dtstart = ICalParser::parseDate("20251201T100000");
+  ICalRRule rule = ICalParser::parseRRule("FREQ=WEEKLY;BYDAY=MO,WE,FR");
+  TEST_ASSERT_EQUAL_INT64(ICalParser::parseDate("20260116T100000"),
+                          ICalParser::getNextOccurrence(dtstart, rule, NOW));
+}
+
+void test_monthly_end_of_month_drift(void) {
+  // Jan 31 + 1 month normalises to Mar 3 and the series continues from there
+  time_t dtstart = ICalParser::parseDate("20250131T120000");
+  ICalRRule rule = ICalParser::parseRRule("FREQ=MONTHLY");
+  time_t next = ICalParser::getNextOccurrence(dtstart, rule, NOW);
+  TEST_ASSERT_EQUAL_INT64(ICalParser::parseDate("20260203T120000"), next);
+  TEST_ASSERT_EQUAL_INT64(reference_next_occurrence(dtstart, rule, NOW), next);
+}
+
+void test_yearly_leap_day(void) {
+  // Feb 29 rolls over to Mar 1 in the first non-leap year and stays there
+  time_t dtstart = ICalParser::parseDate("20240229T080000");
+  ICalRRule rule = ICalParser::parseRRule("FREQ=YEARLY");
+  TEST_ASSERT_EQUAL_INT64(ICalParser::parseDate("20260301T080000"),
+                          ICalParser::getNextOccurrence(dtstart, rule, NOW));
+}
+
+void test_count_and_until_limits(void) {
+  time_t dtstart = ICalParser::parseDate("20260101T090000");
+  ICalRRule counted = ICalParser::parseRRule("FREQ=DAILY;COUNT=10");
+  TEST_ASSERT_EQUAL_INT64(0, ICalParser::getNextOccurrence(dtstart, counted, NOW));
+  ICalRRule counted_long = ICalParser::parseRRule("FREQ=DAILY;COUNT=16");
+  TEST_ASSERT_EQUAL_INT64(ICalParser::parseDate("20260116T090000"),
+                          ICalParser::getNextOccurrence(dtstart, counted_long, NOW));
+
+  ICalRRule until = ICalParser::parseRRule("FREQ=WEEKLY;UNTIL=20260120T000000Z");
+  TEST_ASSERT_EQUAL_INT64(0, ICalParser::getNextOccurrence(dtstart, until, NOW));
+}
+
+// Small deterministic PRNG so failures are reproducible
+static uint32_t rng_state = 0x12345678;
+static uint32_t rng(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+#define RANDOM_RULES 3000
+
+void test_random_rules_match_reference(void) {
+  static time_t dtstarts[RANDOM_RULES];
+  static time_t afters[RANDOM_RULES];
+  static ICalRRule rules[RANDOM_RULES];
+  static time_t expected[RANDOM_RULES];
+  static time_t actual[RANDOM_RULES];
+
+  for (int i = 0; i < RANDOM_RULES; i++) {
+    // Start anywhere in the 6 years before NOW, at a random minute of the day
+    dtstarts[i] = NOW - (time_t)(rng() % (6 * 365)) * DAY - (time_t)(rng() % 1440) * 60;
+    afters[i] = NOW + (time_t)(rng() % (60 * DAY));
+
+    ICalFreq freq = (ICalFreq)(rng() % 5);
+    int interval = 1 + (int)(rng() % 4);
+    uint8_t byDay = (freq == ICAL_FREQ_WEEKLY && rng() % 2) ? (uint8_t)(1 + rng() % 127) : 0;
+    int count = (rng() % 3 == 0) ? (int)(1 + rng() % 2500) : 0;
+    time_t until = (rng() % 3 == 0) ? afters[i] + (time_t)(rng() % (90 * DAY)) - 30 * DAY : 0;
+    rules[i] = make_rule(freq, interval, until, count, byDay);
+  }
+
+  clock_t ref_start = clock();
+  for (int i = 0; i < RANDOM_RULES; i++) {
+    expected[i] = reference_next_occurrence(dtstarts[i], rules[i], afters[i]);
+  }
+  clock_t ref_ticks = clock() - ref_start;
+
+  clock_t fast_start = clock();
+  for (int i = 0; i < RANDOM_RULES; i++) {
+    actual[i] = ICalParser::getNextOccurrence(dtstarts[i], rules[i], afters[i]);
+  }
+  clock_t fast_ticks = clock() - fast_start;
+
+  for (int i = 0; i < RANDOM_RULES; i++) {
+    char msg[96];
+    snprintf(msg, sizeof(msg), "rule %d: freq=%d interval=%d byDay=0x%02x count=%d", i, rules[i].freq,
+             rules[i].interval, rules[i].byDay, rules[i].count);
+    TEST_ASSERT_EQUAL_INT64_MESSAGE(expected[i], actual[i], msg);
+  }
+
+  printf("getNextOccurrence over %d rules: reference %.2f ms, closed-form %.2f ms (%.0fx)\n", RANDOM_RULES,
+         ref_ticks * 1000.0 / CLOCKS_PER_SEC, fast_ticks * 1000.0 / CLOCKS_PER_SEC,
+         fast_ticks > 0 ? (double)ref_ticks / fast_ticks : 0.0);
+}
+
+#define WINDOW_RULES 300
+
+// Every occurrence in a 30-day window, in order, as the reference finds them
+// one after another
+void test_occurrences_match_reference(void) {
+  for (int i = 0; i < WINDOW_RULES; i++) {
+    time_t dtstart = NOW - (time_t)(rng() % (3 * 365)) * DAY - (time_t)(rng() % 1440) * 60;
+    ICalFreq freq = (ICalFreq)(rng() % 5);
+    uint8_t byDay = (freq == ICAL_FREQ_WEEKLY && rng() % 2) ? (uint8_t)(1 + rng() % 127) : 0;
+    int count = (rng() % 3 == 0) ? (int)(1 + rng() % 1500) : 0;
+    time_t until = (rng() % 3 == 0) ? NOW + (time_t)(rng() % (40 * DAY)) : 0;
+    ICalRRule rule = make_rule(freq, 1 + (int)(rng() % 3), until, count, byDay);
+    time_t windowEnd = NOW + 30 * DAY;
+
+    ICalOccurrences occurrences;
+    occurrences.begin(dtstart, rule, NOW);
+    time_t expected = reference_next_occurrence(dtstart, rule, NOW);
+    int n = 0;
+    while (expected > 0 && expected <= windowEnd) {
+      char msg[96];
+      snprintf(msg, sizeof(msg), "rule %d instance %d: freq=%d byDay=0x%02x count=%d", i, n, rule.freq,
+               rule.byDay, rule.count);
+      TEST_ASSERT_EQUAL_INT64_MESSAGE(expected, occurrences.next(), msg);
+      expected = reference_next_occurrence(dtstart, rule, expected + 1);
+      n++;
+    }
+    TEST_ASSERT_EQUAL_INT64(expected, occurrences.next());
+  }
+
+  // Exhausted stays exhausted
+  ICalOccurrences once;
+  once.begin(NOW + DAY, make_rule(ICAL_FREQ_NONE, 1, 0, 0, 0), NOW);
+  TEST_ASSERT_EQUAL_INT64(NOW + DAY, once.next());
+  TEST_ASSERT_EQUAL_INT64(0, once.next());
+  TEST_ASSERT_EQUAL_INT64(0, once.next());
+}
+
+// Reference parse with libc: floating times via timegm(), UTC ('Z') times
+// converted to US Eastern wall clock via the system tz rules
+static time_t reference_parse_date(int year, int month, int day, int hour, int minute, int second, bool utc) {
+  struct tm tm = {};
+  tm.tm_year = year - 1900;
+  tm.tm_mon = month - 1;
+  tm.tm_mday = day;
+  tm.tm_hour = hour;
+  tm.tm_min = minute;
+  tm.tm_sec = second;
+  time_t t = timegm(&tm);
+  if (!utc) {
+    return t;
+  }
+  setenv("TZ", "EST5EDT,M3.2.0,M11.1.0", 1);
+  tzset();
+  struct tm local;
+  localtime_r(&t, &local);
+  setenv("TZ", "UTC0", 1);
+  tzset();
+  return timegm(&local);
+}
+
+void test_parse_date_formats(void) {
+  TEST_ASSERT_EQUAL_INT64(1768435200, ICalParser::parseDate("20260115"));
+  TEST_ASSERT_EQUAL_INT64(NOW, ICalParser::parseDate("20260115T093000"));
+  TEST_ASSERT_EQUAL_INT64(NOW, ICalParser::parseDate("20260115T143000Z"));                  // EST
+  TEST_ASSERT_EQUAL_INT64(ICalParser::parseDate("20260715T103000"), ICalParser::parseDate("20260715T143000Z"));  // EDT
+  TEST_ASSERT_EQUAL_INT64(0, ICalParser::parseDate(""));
+  TEST_ASSERT_EQUAL_INT64(0, ICalParser::parseDate("2026"));
+  TEST_ASSERT_EQUAL_INT64(0, ICalParser::parseDate("20261315"));
+}
+
+void test_parse_date_dst_transitions(void) {
+  // 2026: DST starts Sunday March 8 at 07:00 UTC, ends Sunday November 1 at 06:00 UTC
+  TEST_ASSERT_EQUAL_INT64(ICalParser::parseDate("20260308T015900"), ICalParser::parseDate("20260308T065900Z"));
+  TEST_ASSERT_EQUAL_INT64(ICalParser::parseDate("20260308T030000"), ICalParser::parseDate("20260308T070000Z"));
+  TEST_ASSERT_EQUAL_INT64(ICalParser::parseDate("20261101T015900"), ICalParser::parseDate("20261101T055900Z"));
+  TEST_ASSERT_EQUAL_INT64(ICalParser::parseDate("20261101T010000"), ICalParser::parseDate("20261101T060000Z"));
+}
+
+void test_rrule_until_with_trailing_parts(void) {
+  ICalRRule rule = ICalParser::parseRRule("FREQ=DAILY;UNTIL=20260120T050000Z;INTERVAL=2");
+  TEST_ASSERT_EQUAL_INT64(ICalParser::parseDate("20260120T000000"), rule.until);
+  TEST_ASSERT_EQUAL_INT(2, rule.interval);
+}
+
+void test_format_date_time(void) {
+  char buf[ICAL_DATETIME_LEN];
+  ICalParser::formatDateTime(NOW, buf, sizeof(buf));
+  TEST_ASSERT_EQUAL_STRING("2026-01-15 09:30", buf);
+
+  char small[8] = "x";
+  ICalParser::formatDateTime(NOW, small, sizeof(small));
+  TEST_ASSERT_EQUAL_STRING("", small);
+}
+
+#define RANDOM_DATES 5000
+
+void test_random_dates_match_libc(void) {
+  static char strs[RANDOM_DATES][20];
+  static time_t expected[RANDOM_DATES];
+  static time_t actual[RANDOM_DATES];
+
+  for (int i = 0; i < RANDOM_DATES; i++) {
+    int year = 2000 + (int)(rng() % 60);
+    int month = 1 + (int)(rng() % 12);
+    int day = 1 + (int)(rng() % 28);
+    int hour = (int)(rng() % 24), minute = (int)(rng() % 60), second = (int)(rng() % 60);
+    int kind = (int)(rng() % 3);  // 0 = date only, 1 = floating, 2 = UTC
+    if (kind == 0) {
+      snprintf(strs[i], sizeof(strs[i]), "%04d%02d%02d", year, month, day);
+      expected[i] = reference_parse_date(year, month, day, 0, 0, 0, false);
+    } else {
+      snprintf(strs[i], sizeof(strs[i]), "%04d%02d%02dT%02d%02d%02d%s", year, month, day, hour, minute, second,
+               kind == 2 ? "Z" : "");
+      expected[i] = reference_parse_date(year, month, day, hour, minute, second, kind == 2);
+    }
+  }
+
+  // Baseline: the previous sscanf() + mktime() parse path (floating times)
+  clock_t ref_start = clock();
+  for (int i = 0; i < RANDOM_DATES; i++) {
+    struct tm tm = {};
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    sscanf(strs[i], "%4d%2d%2d", &year, &month, &day);
+    if (strlen(strs[i]) >= 15 && strs[i][8] == 'T') {
+      sscanf(strs[i] + 9, "%2d%2d%2d", &hour, &minute, &second);
+    }
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = second;
+    actual[i] = mktime(&tm);
+  }
+  clock_t ref_ticks = clock() - ref_start;
+
+  clock_t fast_start = clock();
+  for (int i = 0; i < RANDOM_DATES; i++) {
+    actual[i] = ICalParser::parseDate(strs[i]);
+  }
+  clock_t fast_ticks = clock() - fast_start;
+
+  for (int i = 0; i < RANDOM_DATES; i++) {
+    TEST_ASSERT_EQUAL_INT64_MESSAGE(expected[i], actual[i], strs[i]);
+
+    char formatted[ICAL_DATETIME_LEN];
+    char reference[32];
+    ICalParser::formatDateTime(actual[i], formatted, sizeof(formatted));
+    struct tm tm;
+    gmtime_r(&actual[i], &tm);
+    snprintf(reference, sizeof(reference), "%04d-%02d-%02d %02d:%02d", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+             tm.tm_hour, tm.tm_min);
+    TEST_ASSERT_EQUAL_STRING(reference, formatted);
+  }
+
+  printf("parseDate over %d strings: sscanf+mktime %.2f ms, fixed-width %.2f ms (%.0fx)\n", RANDOM_DATES,
+         ref_ticks * 1000.0 / CLOCKS_PER_SEC, fast_ticks * 1000.0 / CLOCKS_PER_SEC,
+         fast_ticks > 0 ? (double)ref_ticks / fast_ticks : 0.0);
+}
+
+int main(void) {
+  // ICalParser treats all times as UTC wall clock (TZ is unset on the ESP8266)
+  setenv("TZ", "UTC0", 1);
+  tzset();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_non_recurring);
+  RUN_TEST(test_daily_standup_from_years_ago);
+  RUN_TEST(test_weekly_byday);
+  RUN_TEST(test_monthly_end_of_month_drift);
+  RUN_TEST(test_yearly_leap_day);
+  RUN_TEST(test_count_and_until_limits);
+  RUN_TEST(test_random_rules_match_reference);
+  RUN_TEST(test_occurrences_match_reference);
+  RUN_TEST(test_parse_date_formats);
+  RUN_TEST(test_parse_date_dst_transitions);
+  RUN_TEST(test_rrule_until_with_trailing_parts);
+  RUN_TEST(test_format_date_time);
+  RUN_TEST(test_random_dates_match_libc);
+  return UNITY_END();
+}
@@ -0,0 +1,307 @@
+#include "unity.h"
+#include "ICalParser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define NOW ((time_t)1768469400)  // 2026-01-15 09:30
+
+// Reference: the original sorted insertion into an array of ICalEvent
+static void reference_insert(ICalEvent* events, int* count, int maxEvents,
+                             time_t occurrence, time_t endOccurrence, const char* title) {
+  if (occurrence == 0) return;
+
+  int insertIdx = *count;
+  for (int i = 0; i < *count; i++) {
+    if (occurrence < events[i].occurrence) {
+      insertIdx = i;
+      break;
+    }
+  }
+  if (insertIdx >= maxEvents) return;
+
+  int shiftEnd = (*count < maxEvents) ? *count : maxEvents - 1;
+  for (int i = shiftEnd; i > insertIdx; i--) {
+    events[i] = events[i - 1];
+  }
+
+  events[insertIdx].occurrence = occurrence;
+  events[insertIdx].endOccurrence = endOccurrence;
+  strncpy(events[insertIdx].title, title, ICAL_MAX_TITLE_LEN - 1);
+  events[insertIdx].title[ICAL_MAX_TITLE_LEN - 1] = '\0';
+
+  if (*count < maxEvents) (*count)++;
+}
+
+static uint32_t rng_state = 0x9e3779b9;
+static uint32_t rng(void) {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
+static void random_title(char* out, int maxLen) {
+  int len = (int)(rng() % (uint32_t)maxLen);
+  for (int i = 0; i < len; i++) {
+    out[i] = (char)('a' + rng() % 26);
+  }
+  out[len] = '\0';
+}
+
+void test_keeps_earliest_sorted(void) {
+  static ICalTopKN<ICAL_MAX_EVENTS> top;
+  top.begin(3);
+  TEST_ASSERT_TRUE(top.offer(NOW + 500, NOW + 600, "five"));
+  TEST_ASSERT_TRUE(top.offer(NOW + 100, NOW + 200, "one"));
+  TEST_ASSERT_TRUE(top.offer(NOW + 300, NOW + 400, "three"));
+  TEST_ASSERT_FALSE(top.offer(NOW + 900, NOW + 950, "nine"));
+  TEST_ASSERT_TRUE(top.offer(NOW + 200, NOW + 250, "two"));
+  TEST_ASSERT_FALSE(top.offer(0, 0, "none"));
+  top.finish();
+
+  TEST_ASSERT_EQUAL_INT(3, top.count());
+  TEST_ASSERT_EQUAL_STRING("one", top.title(0));
+  TEST_ASSERT_EQUAL_STRING("two", top.title(1));
+  TEST_ASSERT_EQUAL_STRING("three", top.title(2));
+  TEST_ASSERT_EQUAL_INT64(NOW + 250, top.endOccurrence(1));
+
+  ICalEvent event;
+  top.getEvent(0, &event);
+  TEST_ASSERT_EQUAL_STRING("2026-01-15 09:31", event.datetime);
+  TEST_ASSERT_EQUAL_STRING("2026-01-15 09:33", event.endDatetime);
+  TEST_ASSERT_EQUAL_STRING("one", event.title);
+}
+
+void test_ties_keep_earlier_candidate(void) {
+  static ICalTopKN<ICAL_MAX_EVENTS> top;
+  top.begin(2);
+  top.offer(NOW, NOW, "first");
+  top.offer(NOW, NOW, "second");
+  TEST_ASSERT_FALSE(top.offer(NOW, NOW, "third"));
+  top.finish();
+  TEST_ASSERT_EQUAL_STRING("first", top.title(0));
+  TEST_ASSERT_EQUAL_STRING("second", top.title(1));
+}
+
+void test_k_is_clamped(void) {
+  static ICalTopKN<ICAL_MAX_EVENTS> top;
+  top.begin(0);
+  top.offer(NOW + 2, NOW, "b");
+  top.offer(NOW + 1, NOW, "a");
+  top.finish();
+  TEST_ASSERT_EQUAL_INT(1, top.count());
+  TEST_ASSERT_EQUAL_STRING("a", top.title(0));
+
+  top.begin(1000);
+  for (int i = 0; i < 100; i++) {
+    top.offer(NOW + i, NOW, "x");
+  }
+  TEST_ASSERT_EQUAL_INT(ICAL_MAX_EVENTS, top.count());
+}
+
+void test_small_list_is_k_sized(void) {
+  // Storage follows K, and K is also the most begin() will keep
+  static ICalTopKN<4> top;
+  size_t perEvent = (sizeof(ICalTopKN<ICAL_MAX_EVENTS>) - sizeof(ICalTopK)) / ICAL_MAX_EVENTS;
+  TEST_ASSERT_EQUAL_INT((int)(4 * perEvent), (int)(sizeof(top) - sizeof(ICalTopK)));
+  TEST_ASSERT_TRUE(perEvent < sizeof(ICalEvent));
+  TEST_ASSERT_EQUAL_INT(4, top.maxCapacity());
+
+  top.begin(ICAL_MAX_EVENTS);
+  TEST_ASSERT_EQUAL_INT(4, top.capacity());
+  for (int i = 10; i > 0; i--) {
+    top.offer(NOW + i, NOW + i + 60, "Long enough title to fill a 4-event pool quickly");
+  }
+  top.finish();
+  TEST_ASSERT_EQUAL_INT(4, top.count());
+  for (int i = 0; i < 4; i++) {
+    TEST_ASSERT_EQUAL_INT64(NOW + 1 + i, top.occurrence(i));
+  }
+  TEST_ASSERT_EQUAL_STRING("Long enough title to fill a 4-event pool quickly", top.title(0));
+}
+
+void test_pool_compacts_under_churn(void) {
+  // Every candidate is earlier than the last, so each one evicts the root and
+  // leaves a hole in the pool; compaction must keep every kept title intact.
+  static ICalTopKN<ICAL_MAX_EVENTS> top;
+  top.begin(8);
+  char title[ICAL_MAX_TITLE_LEN];
+  for (int i = 0; i < 2000; i++) {
+    snprintf(title, sizeof(title), "event-%04d-%s", i, "padding-to-make-titles-long");
+    top.offer(NOW + 100000 - i, NOW, title);
+  }
+  top.finish();
+  for (int i = 0; i < 8; i++) {
+    snprintf(title, sizeof(title), "event-%04d-%s", 1999 - i, "padding-to-make-titles-long");
+    TEST_ASSERT_EQUAL_STRING(title, top.title(i));
+  }
+}
+
+// Overlong titles arriving latest first, so once k are kept every offer
+// evicts and the pool has to be compacted around the hole; the k kept must
+// all come back cut to ICAL_MAX_TITLE_LEN - 1 and otherwise whole
+static void check_max_length_titles(ICalTopK* top, int k) {
+  char title[ICAL_MAX_TITLE_LEN + 16];
+  char expected[ICAL_MAX_TITLE_LEN];
+  top->begin(k);
+  for (int i = 3 * k; i > 0; i--) {
+    memset(title, 'a' + i % 26, sizeof(title) - 1);
+    title[sizeof(title) - 1] = '\0';
+    top->offer(NOW + i, NOW, title);
+  }
+  top->finish();
+
+  TEST_ASSERT_EQUAL_INT(k, top->count());
+  for (int i = 0; i < k; i++) {
+    memset(expected, 'a' + (i + 1) % 26, sizeof(expected) - 1);
+    expected[sizeof(expected) - 1] = '\0';
+    TEST_ASSERT_EQUAL_STRING(expected, top->title(i));
+  }
+}
+
+void test_max_length_titles_are_kept(void) {
+  static ICalTopKN<ICAL_MAX_EVENTS> top;
+  static ICalTopKN<4> small;
+  static ICalTopKN<1> single;
+  check_max_length_titles(&top, ICAL_MAX_EVENTS);
+  check_max_length_titles(&small, 4);
+  check_max_length_titles(&single, 1);
+}
+
+#define RANDOM_STREAMS 200
+#define STREAM_LEN 2000
+
+void test_random_streams_match_reference(void) {
+  static ICalTopKN<ICAL_MAX_EVENTS> top;
+  static ICalEvent expected[ICAL_MAX_EVENTS];
+  static time_t occurrences[STREAM_LEN];
+  static char titles[STREAM_LEN][24];
+  clock_t ref_ticks = 0, heap_ticks = 0;
+
+  for (int s = 0; s < RANDOM_STREAMS; s++) {
+    int k = 1 + (int)(rng() % ICAL_MAX_EVENTS);
+    // Small ranges produce many ties
+    uint32_t range = (s % 2) ? 50 : 365 * 1440;
+    for (int i = 0; i < STREAM_LEN; i++) {
+      occurrences[i] = NOW + (time_t)(rng() % range) * 60;
+      random_title(titles[i], (int)sizeof(titles[i]));
+    }
+
+    int expectedCount = 0;
+    clock_t start = clock();
+    for (int i = 0; i < STREAM_LEN; i++) {
+      reference_insert(expected, &expectedCount, k, occurrences[i], occurrences[i] + 3600, titles[i]);
+    }
+    ref_ticks += clock() - start;
+
+    start = clock();
+    top.begin(k);
+    for (int i = 0; i < STREAM_LEN; i++) {
+      top.offer(occurrences[i], occurrences[i] + 3600, titles[i]);
+    }
+    top.finish();
+    heap_ticks += clock() - start;
+
+    TEST_ASSERT_EQUAL_INT(expectedCount, top.count());
+    for (int i = 0; i < expectedCount; i++) {
+      TEST_ASSERT_EQUAL_INT64(expected[i].occurrence, top.occurrence(i));
+      TEST_ASSERT_EQUAL_INT64(expected[i].endOccurrence, top.endOccurrence(i));
+      TEST_ASSERT_EQUAL_STRING(expected[i].title, top.title(i));
+    }
+  }
+
+  printf("Top-K over %d x %d candidates: sorted insertion %.2f ms, heap %.2f ms\n", RANDOM_STREAMS,
+         STREAM_LEN, ref_ticks * 1000.0 / CLOCKS_PER_SEC, heap_ticks * 1000.0 / CLOCKS_PER_SEC);
+  printf("Storage for %d events: ICalEvent array %d bytes, ICalTopKN %d bytes\n", ICAL_MAX_EVENTS,
+         (int)(ICAL_MAX_EVENTS * sizeof(ICalEvent)), (int)sizeof(ICalTopKN<ICAL_MAX_EVENTS>));
+}
+
+void test_merge_interleaves_feeds(void) {
+  static ICalTopKN<ICAL_MAX_EVENTS> home, work, empty;
+  home.begin(4);
+  home.offer(NOW + 300, NOW + 400, "Dentist");
+  home.offer(NOW + 100, NOW + 200, "Breakfast");
+  home.finish();
+  work.begin(4);
+  work.offer(NOW + 300, NOW + 360, "Standup");
+  work.offer(NOW + 200, NOW + 260, "Email");
+  work.offer(NOW + 900, NOW + 960, "Review");
+  work.finish();
+  empty.begin(4);
+  empty.finish();
+
+  const ICalTopK* lists[] = {&home, nullptr, &empty, &work};
+  ICalMerge merge;
+  merge.begin(lists, 4);
+  TEST_ASSERT_EQUAL_INT(5, merge.remaining());
+
+  static const char* expected[] = {"Breakfast", "Email", "Dentist", "Standup", "Review"};
+  const ICalTopK* list;
+  int index;
+  for (int i = 0; i < 5; i++) {
+    TEST_ASSERT_TRUE(merge.next(&list, &index));
+    TEST_ASSERT_EQUAL_STRING(expected[i], list->title(index));
+  }
+  TEST_ASSERT_EQUAL_INT(0, merge.remaining());
+  TEST_ASSERT_FALSE(merge.next(&list, &index));
+}
+
+void test_merge_matches_single_list(void) {
+  // Merging per-feed top-K lists gives the same first K as one list fed
+  // every feed in turn, ties included
+  static ICalTopKN<ICAL_MAX_EVENTS> feeds[ICAL_MAX_FEEDS];
+  static ICalTopKN<ICAL_MAX_EVENTS> all;
+  char title[24];
+
+  for (int s = 0; s < RANDOM_STREAMS; s++) {
+    int k = 1 + (int)(rng() % ICAL_MAX_EVENTS);
+    uint32_t range = (s % 2) ? 50 : 365 * 1440;
+    all.begin(k);
+    for (int f = 0; f < ICAL_MAX_FEEDS; f++) {
+      feeds[f].begin(k);
+      int len = (int)(rng() % (STREAM_LEN / ICAL_MAX_FEEDS));
+      for (int i = 0; i < len; i++) {
+        time_t occurrence = NOW + (time_t)(rng() % range) * 60;
+        snprintf(title, sizeof(title), "%d/%d", f, i);
+        feeds[f].offer(occurrence, occurrence + 3600, title);
+        all.offer(occurrence, occurrence + 3600, title);
+      }
+      feeds[f].finish();
+    }
+    all.finish();
+
+    const ICalTopK* lists[ICAL_MAX_FEEDS];
+    for (int f = 0; f < ICAL_MAX_FEEDS; f++) lists[f] = &feeds[f];
+    ICalMerge merge;
+    merge.begin(lists, ICAL_MAX_FEEDS);
+    const ICalTopK* list;
+    int index;
+    for (int i = 0; i < all.count(); i++) {
+      TEST_ASSERT_TRUE(merge.next(&list, &index));
+      TEST_ASSERT_EQUAL_INT64(all.occurrence(i), list->occurrence(index));
+      TEST_ASSERT_EQUAL_STRING(all.title(i), list->title(index));
+    }
+  }
+}
+
+int main(void) {
+  setenv("TZ", "UTC0", 1);
+  tzset();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_keeps_earliest_sorted);
+  RUN_TEST(test_ties_keep_earlier_candidate);
+  RUN_TEST(test_k_is_clamped);
+  RUN_TEST(test_small_list_is_k_sized);
+  RUN_TEST(test_pool_compacts_under_churn);
+  RUN_TEST(test_max_length_titles_are_kept);
+  RUN_TEST(test_random_streams_match_reference);
+  RUN_TEST(test_merge_interleaves_feeds);
+  RUN_TEST(test_merge_matches_single_list);
+  return UNITY_END();
+}
@@ -0,0 +1,185 @@
+#include "unity.h"
+#include "SntpClient.h"
+#include <stdio.h>
+#include <string.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define COOKIE 0x0123456789abcdefULL
+#define OFFSET_US 1768469400123456LL  // UTC minus local clock: 2026-01-15 09:30:00.123456
+#define ONE_WAY_US 20000LL
+#define SERVER_HOLD_US 1000LL
+
+static void put64(uint8_t* p, uint64_t value) {
+  for (int i = 7; i >= 0; i--) {
+    p[i] = (uint8_t)value;
+    value >>= 8;
+  }
+}
+
+// Unix microseconds to NTP 32.32, rounding the fraction up so converting
+// back (which truncates) gives the same microsecond
+static uint64_t unix_us_to_ntp(int64_t us) {
+  uint64_t seconds = (uint64_t)(us / 1000000 + 2208988800LL) & 0xFFFFFFFFULL;
+  uint64_t micros = (uint64_t)(us % 1000000);
+  uint64_t fraction = ((micros << 32) + 999999) / 1000000;
+  return (seconds << 32) | fraction;
+}
+
+static void make_reply(uint8_t* packet, uint64_t cookie, int64_t t2, int64_t t3) {
+  memset(packet, 0, SNTP_PACKET_SIZE);
+  packet[0] = (0 << 6) | (4 << 3) | 4;  // Version 4, server
+  packet[1] = 2;                        // Stratum
+  put64(packet + 24, cookie);
+  put64(packet + 32, unix_us_to_ntp(t2));
+  put64(packet + 40, unix_us_to_ntp(t3));
+}
+
+// One exchange starting at local time sent, with the given one-way delays
+// and the server's clock offset from true UTC
+static bool exchange(SntpClient* client, int64_t sent, int64_t out_us, int64_t back_us,
+                     int64_t server_error_us) {
+  uint8_t packet[SNTP_PACKET_SIZE];
+  int64_t t2 = sent + OFFSET_US + out_us + server_error_us;
+  int64_t t3 = t2 + SERVER_HOLD_US;
+  int64_t received = sent + out_us + SERVER_HOLD_US + back_us;
+  make_reply(packet, COOKIE, t2, t3);
+  return client->handleReply(packet, sizeof(packet), COOKIE, sent, received);
+}
+
+void test_request_layout(void) {
+  uint8_t packet[SNTP_PACKET_SIZE];
+  memset(packet, 0xAA, sizeof(packet));
+  SntpClient::buildRequest(packet, COOKIE);
+  TEST_ASSERT_EQUAL_HEX8(0x23, packet[0]);
+  TEST_ASSERT_EQUAL_HEX8(0x00, packet[1]);
+  TEST_ASSERT_EQUAL_HEX8(0x01, packet[40]);
+  TEST_ASSERT_EQUAL_HEX8(0xef, packet[47]);
+}
+
+void test_offset_and_delay_from_symmetric_reply(void) {
+  SntpClient client;
+  TEST_ASSERT_FALSE(client.isTimeSet());
+  TEST_ASSERT_TRUE(exchange(&client, 5000000, ONE_WAY_US, ONE_WAY_US, 0));
+  TEST_ASSERT_TRUE(client.isTimeSet());
+  TEST_ASSERT_EQUAL_INT64(OFFSET_US, client.offsetUs());
+  TEST_ASSERT_EQUAL_INT64(2 * ONE_WAY_US, client.lastDelayUs());
+  TEST_ASSERT_EQUAL_INT64(OFFSET_US + 7000000, client.epochUsAt(7000000));
+}
+
+void test_rejects_invalid_replies(void) {
+  SntpClient client;
+  uint8_t packet[SNTP_PACKET_SIZE];
+  int64_t sent = 1000000;
+  int64_t t2 = sent + OFFSET_US + ONE_WAY_US;
+  int64_t received = sent + 2 * ONE_WAY_US + SERVER_HOLD_US;
+
+  make_reply(packet, COOKIE, t2, t2 + SERVER_HOLD_US);
+  TEST_ASSERT_FALSE(client.handleReply(packet, SNTP_PACKET_SIZE - 1, COOKIE, sent, received));
+  TEST_ASSERT_FALSE(client.handleReply(packet, sizeof(packet), COOKIE + 1, sent, received));
+
+  packet[0] = (4 << 3) | 3;  // Client mode
+  TEST_ASSERT_FALSE(client.handleReply(packet, sizeof(packet), COOKIE, sent, received));
+  packet[0] = (3 << 6) | (4 << 3) | 4;  // Unsynchronized server
+  TEST_ASSERT_FALSE(client.handleReply(packet, sizeof(packet), COOKIE, sent, received));
+  packet[0] = (4 << 3) | 4;
+  packet[1] = 0;  // Kiss-o'-death
+  TEST_ASSERT_FALSE(client.handleReply(packet, sizeof(packet), COOKIE, sent, received));
+
+  make_reply(packet, COOKIE, t2, t2 + SERVER_HOLD_US);
+  memset(packet + 40, 0, 8);
+  TEST_ASSERT_FALSE(client.handleReply(packet, sizeof(packet), COOKIE, sent, received));
+
+  // Arrived far too late to be of any use
+  make_reply(packet, COOKIE, t2, t2 + SERVER_HOLD_US);
+  TEST_ASSERT_FALSE(client.handleReply(packet, sizeof(packet), COOKIE, sent, received + 2000000));
+
+  TEST_ASSERT_FALSE(client.isTimeSet());
+  TEST_ASSERT_EQUAL_UINT32(0, client.acceptedSamples());
+  TEST_ASSERT_EQUAL_UINT32(7, client.rejectedSamples());
+}
+
+void test_low_delay_sample_wins(void) {
+  SntpClient client;
+  // Accurate fast sample, then slower ones whose asymmetric paths skew the
+  // computed offset by up to 40 ms
+  TEST_ASSERT_TRUE(exchange(&client, 1000000, 5000, 5000, 0));
+  for (int i = 1; i < SNTP_FILTER_SAMPLES; i++) {
+    TEST_ASSERT_TRUE(exchange(&client, 1000000 + i * 2000000LL, 5000 + 80000, 5000, 0));
+  }
+  TEST_ASSERT_INT64_WITHIN(1000, OFFSET_US, client.offsetUs());
+  TEST_ASSERT_EQUAL_UINT32(SNTP_FILTER_SAMPLES, client.acceptedSamples());
+}
+
+void test_small_corrections_are_slewed(void) {
+  SntpClient client;
+  TEST_ASSERT_TRUE(exchange(&client, 1000000, ONE_WAY_US, ONE_WAY_US, 0));
+  // The server now reads 40 ms later; the newest sample has the same delay
+  // and less age, so it is picked, and a quarter of the change is applied
+  TEST_ASSERT_TRUE(exchange(&client, 3000000, ONE_WAY_US, ONE_WAY_US, 40000));
+  TEST_ASSERT_EQUAL_INT64(OFFSET_US + 10000, client.offsetUs());
+  TEST_ASSERT_TRUE(exchange(&client, 5000000, ONE_WAY_US, ONE_WAY_US, 40000));
+  TEST_ASSERT_EQUAL_INT64(OFFSET_US + 17500, client.offsetUs());
+}
+
+void test_slew_is_spread_over_the_poll_interval(void) {
+  SntpClient client("pool.ntp.org", 60000);
+  TEST_ASSERT_TRUE(exchange(&client, 1000000, ONE_WAY_US, ONE_WAY_US, 0));
+
+  // The server now reads 40 ms earlier: the clock runs slow until the
+  // quarter applied is caught up, one poll interval later, never backwards
+  int64_t received = 3000000 + 2 * ONE_WAY_US + SERVER_HOLD_US;
+  int64_t before = client.epochUsAt(received);
+  TEST_ASSERT_TRUE(exchange(&client, 3000000, ONE_WAY_US, ONE_WAY_US, -40000));
+  TEST_ASSERT_EQUAL_INT64(OFFSET_US - 10000, client.offsetUs());
+  TEST_ASSERT_EQUAL_INT64(before, client.epochUsAt(received));
+  int64_t last = before;
+  for (int64_t t = received + 1000; t <= received + 61000000; t += 1000) {
+    int64_t now = client.epochUsAt(t);
+    TEST_ASSERT_TRUE(now > last);
+    last = now;
+  }
+  TEST_ASSERT_EQUAL_INT64(received + 30000000 + OFFSET_US - 5000, client.epochUsAt(received + 30000000));
+  TEST_ASSERT_EQUAL_INT64(received + 60000000 + OFFSET_US - 10000, client.epochUsAt(received + 60000000));
+}
+
+void test_outlier_needs_confirmation_to_step(void) {
+  SntpClient client;
+  TEST_ASSERT_TRUE(exchange(&client, 1000000, ONE_WAY_US, ONE_WAY_US, 0));
+
+  // A lone sample 5 s off is ignored
+  TEST_ASSERT_FALSE(exchange(&client, 3000000, ONE_WAY_US, ONE_WAY_US, 5000000));
+  TEST_ASSERT_EQUAL_INT64(OFFSET_US, client.offsetUs());
+  TEST_ASSERT_TRUE(exchange(&client, 5000000, ONE_WAY_US, ONE_WAY_US, 0));
+
+  // Two in a row that agree step the clock at once
+  TEST_ASSERT_FALSE(exchange(&client, 7000000, ONE_WAY_US, ONE_WAY_US, 5000000));
+  TEST_ASSERT_TRUE(exchange(&client, 9000000, ONE_WAY_US, ONE_WAY_US, 5000000));
+  TEST_ASSERT_EQUAL_INT64(OFFSET_US + 5000000, client.offsetUs());
+  TEST_ASSERT_EQUAL_UINT32(2, client.rejectedSamples());
+}
+
+void test_ntp_era_rollover(void) {
+  // 2040-01-01: NTP seconds have wrapped past 2^32 (February 2036)
+  SntpClient client;
+  uint8_t packet[SNTP_PACKET_SIZE];
+  int64_t utc = 2208988800LL * 1000000LL + 250000;
+  int64_t sent = 1000000;
+  make_reply(packet, COOKIE, utc, utc);
+  TEST_ASSERT_TRUE(client.handleReply(packet, sizeof(packet), COOKIE, sent, sent));
+  TEST_ASSERT_EQUAL_INT64(utc - sent, client.offsetUs());
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_request_layout);
+  RUN_TEST(test_offset_and_delay_from_symmetric_reply);
+  RUN_TEST(test_rejects_invalid_replies);
+  RUN_TEST(test_low_delay_sample_wins);
+  RUN_TEST(test_small_corrections_are_slewed);
+  RUN_TEST(test_slew_is_spread_over_the_poll_interval);
+  RUN_TEST(test_outlier_needs_confirmation_to_step);
+  RUN_TEST(test_ntp_era_rollover);
+  return UNITY_END();
+}
@@ -0,0 +1,460 @@
+#include "unity.h"
+#include "STM32Comm.h"
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Captures what STM32Comm writes and how many write calls it took, and
+// feeds it input in slices of at most rxChunk bytes per available()
+class CaptureStream : public Stream {
+public:
+  char data[8192];
+  size_t length = 0;
+  int writeCalls = 0;
+
+  const char* rx = nullptr;
+  size_t rxLength = 0;
+  size_t rxPos = 0;
+  size_t rxChunk = 0;
+  int room = INT_MAX;  // What availableForWrite() reports; writes use it up
+
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buffer, size_t size) override {
+    writeCalls++;
+    if (size > sizeof(data) - 1 - length) size = sizeof(data) - 1 - length;
+    memcpy(data + length, buffer, size);
+    length += size;
+    if (room != INT_MAX) room -= (int)size;
+    data[length] = '\0';
+    return size;
+  }
+  int availableForWrite() override { return room; }
+  int available() override {
+    size_t left = rxLength - rxPos;
+    return (int)(rxChunk > 0 && left > rxChunk ? rxChunk : left);
+  }
+  int read() override { return rxPos < rxLength ? (uint8_t)rx[rxPos++] : -1; }
+  int peek() override { return rxPos < rxLength ? (uint8_t)rx[rxPos] : -1; }
+  size_t readBytes(char* buffer, size_t size) override {
+    if (size > rxLength - rxPos) size = rxLength - rxPos;
+    memcpy(buffer, rx + rxPos, size);
+    rxPos += size;
+    return size;
+  }
+
+  void feed(const char* input, size_t inputLength, size_t chunk) {
+    rx = input;
+    rxLength = inputLength;
+    rxPos = 0;
+    rxChunk = chunk;
+  }
+  void feed(const char* input, size_t chunk = 0) { feed(input, strlen(input), chunk); }
+
+  void clear() {
+    room = INT_MAX;
+    length = 0;
+    writeCalls = 0;
+    data[0] = '\0';
+  }
+};
+
+// Handlers append "NAME(params)" to a log so dispatch order and params show
+static char handled[4096];
+static void log_call(const char* name, const char* params) {
+  size_t used = strlen(handled);
+  snprintf(handled + used, sizeof(handled) - used, "%s(%s)", name, params);
+}
+static void on_wifi(const char* params) { log_call("WIFI", params); }
+static void on_status(const char* params) { log_call("STATUS", params); }
+static void on_time(const char* params) { log_call("TIME", params); }
+static void on_gcp_key(const char* params) {
+  char summary[32];
+  snprintf(summary, sizeof(summary), "len=%d", (int)strlen(params));
+  log_call("GCP_KEY", summary);
+}
+static void on_numbered(const char* params) { log_call("N", params); }
+static void on_unknown(const char* cmd) { log_call("?", cmd); }
+
+static STM32Comm comm;
+static CaptureStream serial;
+
+void setUp(void) {
+  comm.begin(serial);
+  serial.clear();
+}
+void tearDown(void) {}
+
+void test_typed_fields(void) {
+  comm.beginResponse("W:")
+      .appendInt(-42).appendChar(',')
+      .appendInt(LONG_MIN).appendChar(',')
+      .appendFixed(-1234, 2).appendChar(',')
+      .appendFixed(5, 3).appendChar(',')
+      .appendFixed(7, 0).appendChar(',')
+      .appendFloat(72.456f, 2).appendChar(',')
+      .appendFloat(-3.5f, 0).appendChar(',')
+      .append("ab|cd", 2);
+  char expected[96];
+  snprintf(expected, sizeof(expected), "W:-42,%ld,-12.34,0.005,7,72.46,-4,ab", LONG_MIN);
+  TEST_ASSERT_EQUAL_STRING(expected, comm.response());
+  TEST_ASSERT_EQUAL_INT((int)strlen(expected), (int)comm.responseLength());
+  TEST_ASSERT_EQUAL_INT(0, serial.writeCalls);
+
+  TEST_ASSERT_TRUE(comm.endResponse());
+  strcat(expected, "\n");
+  TEST_ASSERT_EQUAL_STRING(expected, serial.data);
+  TEST_ASSERT_EQUAL_INT(1, serial.writeCalls);
+}
+
+void test_send_helpers_use_one_write(void) {
+  comm.sendOK();
+  comm.sendError("NO_WIFI");
+  comm.sendf("BALANCE:%d", 1234);
+  TEST_ASSERT_EQUAL_STRING("OK\nERROR:NO_WIFI\nBALANCE:1234\n", serial.data);
+  TEST_ASSERT_EQUAL_INT(3, serial.writeCalls);
+}
+
+void test_long_replies_are_not_truncated(void) {
+  static char title[1001];
+  memset(title, 'x', sizeof(title) - 1);
+  title[sizeof(title) - 1] = '\0';
+  comm.sendf("CALENDAR:1,%s", title);
+  TEST_ASSERT_EQUAL_INT(11 + 1000 + 1, (int)serial.length);
+  TEST_ASSERT_EQUAL_CHAR('\n', serial.data[serial.length - 1]);
+}
+
+void test_overflow_sends_error_instead(void) {
+  // Two of these do not fit in the buffer
+  static char chunk[STM32COMM_TX_BUFFER_SIZE / 2 + 2];
+  memset(chunk, 'y', sizeof(chunk) - 1);
+  chunk[sizeof(chunk) - 1] = '\0';
+
+  comm.beginResponse("CALENDAR:").append(chunk).append(chunk);
+  TEST_ASSERT_FALSE(comm.responseFits());
+  // Later fields are ignored too, so the reply cannot go out with a gap
+  comm.appendInt(5);
+  TEST_ASSERT_FALSE(comm.endResponse());
+  TEST_ASSERT_EQUAL_STRING("ERROR:RESPONSE_TOO_LONG\n", serial.data);
+
+  serial.clear();
+  comm.sendf("%s%s", chunk, chunk);
+  TEST_ASSERT_EQUAL_STRING("ERROR:RESPONSE_TOO_LONG\n", serial.data);
+}
+
+void test_exactly_full_buffer_fits(void) {
+  static char full[STM32COMM_TX_BUFFER_SIZE + 1];
+  memset(full, 'z', sizeof(full) - 1);
+  full[sizeof(full) - 1] = '\0';
+  comm.beginResponse().append(full);
+  TEST_ASSERT_TRUE(comm.responseFits());
+  TEST_ASSERT_TRUE(comm.endResponse());
+  TEST_ASSERT_EQUAL_INT(STM32COMM_TX_BUFFER_SIZE + 1, (int)serial.length);
+}
+
+void test_resend_built_response(void) {
+  // A built reply kept by the caller can be sent again through send()
+  comm.beginResponse("STOCK:AAPL:").appendFloat(185.2345f, 2);
+  comm.send(comm.response());
+  TEST_ASSERT_EQUAL_STRING("STOCK:AAPL:185.23\n", serial.data);
+}
+
+void test_dispatch_across_chunks(void) {
+  static STM32Comm rxComm;
+  static CaptureStream link;
+  rxComm.begin(link);
+  rxComm.onCommand("WIFI", on_wifi);
+  rxComm.onCommand("STATUS", on_status);
+  rxComm.onCommand("TIME", on_time);
+  handled[0] = '\0';
+
+  // Every slice size splits the lines differently
+  const char* input = "WIFI:my ssid,pa:ss\r\nSTATUS\n\nTI\rME:\nSTAT\nSTATUSX:1\nWIFI\n";
+  for (size_t chunk = 1; chunk <= strlen(input); chunk++) {
+    handled[0] = '\0';
+    link.clear();
+    link.feed(input, chunk);
+    rxComm.process();
+    TEST_ASSERT_EQUAL_STRING("WIFI(my ssid,pa:ss)STATUS()TIME()WIFI()", handled);
+    TEST_ASSERT_EQUAL_STRING("ERROR:UNKNOWN_COMMAND\nERROR:UNKNOWN_COMMAND\n", link.data);
+  }
+
+  // A partial line waits for the rest
+  handled[0] = '\0';
+  link.feed("STA");
+  rxComm.process();
+  TEST_ASSERT_EQUAL_STRING("", handled);
+  link.feed("TUS\n");
+  rxComm.process();
+  TEST_ASSERT_EQUAL_STRING("STATUS()", handled);
+
+  rxComm.onUnknownCommand(on_unknown);
+  handled[0] = '\0';
+  link.feed("NOPE:1,2\n");
+  rxComm.process();
+  TEST_ASSERT_EQUAL_STRING("?(NOPE:1,2)", handled);
+}
+
+void test_overlong_line_is_truncated(void) {
+  static STM32Comm rxComm;
+  static CaptureStream link;
+  static char input[STM32COMM_BUFFER_SIZE + 200];
+  rxComm.begin(link);
+  rxComm.onCommand("GCP_KEY", on_gcp_key);
+  rxComm.onCommand("TIME", on_time);
+
+  size_t len = 0;
+  len += sprintf(input, "GCP_KEY:");
+  memset(input + len, 'k', STM32COMM_BUFFER_SIZE + 100);
+  len += STM32COMM_BUFFER_SIZE + 100;
+  len += sprintf(input + len, "\nTIME\n");
+
+  handled[0] = '\0';
+  link.feed(input, len, 64);
+  rxComm.process();
+  char expected[64];
+  snprintf(expected, sizeof(expected), "GCP_KEY(len=%d)TIME()", STM32COMM_BUFFER_SIZE - 1 - 8);
+  TEST_ASSERT_EQUAL_STRING(expected, handled);
+}
+
+void test_command_table(void) {
+  static STM32Comm rxComm;
+  static CaptureStream link;
+  rxComm.begin(link);
+
+  char name[16];
+  for (int i = 0; i < STM32COMM_MAX_COMMANDS; i++) {
+    snprintf(name, sizeof(name), "CMD%d", i);
+    TEST_ASSERT_TRUE(rxComm.onCommand(name, on_numbered));
+  }
+  TEST_ASSERT_FALSE(rxComm.onCommand("ONE_TOO_MANY", on_numbered));
+  TEST_ASSERT_FALSE(rxComm.hasCommand("ONE_TOO_MANY"));
+  // Updating an existing handler still works with the table full
+  TEST_ASSERT_TRUE(rxComm.onCommand("CMD3", on_time));
+
+  static char input[512];
+  size_t len = 0;
+  for (int i = 0; i < STM32COMM_MAX_COMMANDS; i++) {
+    snprintf(name, sizeof(name), "CMD%d", i);
+    TEST_ASSERT_TRUE(rxComm.hasCommand(name));
+    len += snprintf(input + len, sizeof(input) - len, "CMD%d:%d\n", i, i);
+  }
+  handled[0] = '\0';
+  link.feed(input, len, 0);
+  rxComm.process();
+  TEST_ASSERT_EQUAL_STRING("N(0)N(1)N(2)TIME(3)N(4)N(5)N(6)N(7)N(8)N(9)N(10)N(11)N(12)N(13)N(14)N(15)", handled);
+  TEST_ASSERT_FALSE(rxComm.hasCommand("CMD"));
+  TEST_ASSERT_FALSE(rxComm.hasCommand("CMD16"));
+}
+
+// Reference: the original byte-at-a-time read and linear strcmp dispatch
+void test_debug_output_is_deferred_to_process(void) {
+  static STM32Comm logComm;
+  static CaptureStream link, debug;
+  logComm.begin(link);
+  logComm.setDebugStream(debug);
+  logComm.onCommand("TIME", on_time);
+
+  logComm.debugf("boot %d", 1);
+  logComm.sendOK();
+  TEST_ASSERT_EQUAL_INT(0, (int)debug.length);
+
+  link.feed("TIME\n");
+  logComm.process();
+  TEST_ASSERT_EQUAL_STRING("DBG: boot 1\r\nTX> OK\r\nRX> TIME\r\n", debug.data);
+  TEST_ASSERT_EQUAL_UINT32(0, logComm.droppedLogLines());
+}
+
+void test_drain_respects_available_for_write(void) {
+  static STM32Comm logComm;
+  static CaptureStream link, debug;
+  logComm.begin(link);
+  logComm.setDebugStream(debug);
+
+  logComm.debug("0123456789");  // 17 bytes queued
+  debug.room = 5;
+  logComm.process();
+  TEST_ASSERT_EQUAL_STRING("DBG: ", debug.data);
+  logComm.process();
+  TEST_ASSERT_EQUAL_STRING("DBG: ", debug.data);
+  logComm.flushLog();
+  TEST_ASSERT_EQUAL_STRING("DBG: 0123456789\r\n", debug.data);
+}
+
+void test_full_log_drops_and_reports(void) {
+  static STM32Comm logComm;
+  static CaptureStream link, debug;
+  logComm.begin(link);
+  logComm.setDebugStream(debug);
+
+  // Each "DBG: abc\r\n" is 10 bytes
+  int lines = STM32COMM_LOG_BUFFER_SIZE / 10;
+  for (int i = 0; i < lines + 3; i++) {
+    logComm.debug("abc");
+  }
+  TEST_ASSERT_EQUAL_UINT32(3, logComm.droppedLogLines());
+
+  logComm.flushLog();
+  TEST_ASSERT_EQUAL_INT(lines * 10, (int)debug.length);
+  debug.clear();
+  logComm.debug("next");
+  logComm.flushLog();
+  TEST_ASSERT_EQUAL_STRING("DBG: 3 log lines dropped\r\nDBG: next\r\n", debug.data);
+}
+
+void test_long_log_lines_are_cut(void) {
+  static STM32Comm logComm;
+  static CaptureStream link, debug;
+  logComm.begin(link);
+  logComm.setDebugStream(debug);
+  logComm.onCommand("GCP_KEY", on_gcp_key);
+
+  static char input[STM32COMM_LOG_LINE_MAX + 64];
+  size_t len = sprintf(input, "GCP_KEY:");
+  memset(input + len, 'k', STM32COMM_LOG_LINE_MAX);
+  len += STM32COMM_LOG_LINE_MAX;
+  input[len++] = '\n';
+  link.feed(input, len, 0);
+  logComm.process();
+
+  // "RX> " + LINE_MAX bytes + "...\r\n"
+  TEST_ASSERT_EQUAL_INT(4 + STM32COMM_LOG_LINE_MAX + 5, (int)debug.length);
+  TEST_ASSERT_EQUAL_INT(0, strncmp("RX> GCP_KEY:kkk", debug.data, 15));
+  TEST_ASSERT_EQUAL_STRING("...\r\n", debug.data + debug.length - 5);
+}
+
+struct ReferenceEntry {
+  char command[STM32COMM_MAX_CMD_LEN];
+  STM32CommCallback callback;
+};
+static ReferenceEntry reference_commands[STM32COMM_MAX_COMMANDS];
+static int reference_count;
+static char reference_buffer[STM32COMM_BUFFER_SIZE];
+static size_t reference_index;
+
+static void reference_dispatch(const char* cmd) {
+  if (cmd[0] == '\0') return;
+  const char* colonPos = strchr(cmd, ':');
+  char commandName[STM32COMM_MAX_CMD_LEN];
+  const char* params = "";
+  if (colonPos) {
+    size_t cmdLen = colonPos - cmd;
+    if (cmdLen >= STM32COMM_MAX_CMD_LEN) cmdLen = STM32COMM_MAX_CMD_LEN - 1;
+    strncpy(commandName, cmd, cmdLen);
+    commandName[cmdLen] = '\0';
+    params = colonPos + 1;
+  } else {
+    strncpy(commandName, cmd, STM32COMM_MAX_CMD_LEN - 1);
+    commandName[STM32COMM_MAX_CMD_LEN - 1] = '\0';
+  }
+  for (int i = 0; i < reference_count; i++) {
+    if (strcmp(reference_commands[i].command, commandName) == 0) {
+      reference_commands[i].callback(params);
+      return;
+    }
+  }
+}
+
+static void reference_process(Stream* serial) {
+  while (serial->available()) {
+    char c = serial->read();
+    if (c == '\n') {
+      reference_buffer[reference_index] = '\0';
+      reference_dispatch(reference_buffer);
+      reference_index = 0;
+    } else if (c != '\r') {
+      if (reference_index < STM32COMM_BUFFER_SIZE - 1) reference_buffer[reference_index++] = c;
+    }
+  }
+}
+
+static unsigned long bench_calls;
+static unsigned long bench_param_bytes;
+static void on_bench(const char* params) {
+  bench_calls++;
+  bench_param_bytes += strlen(params);
+}
+
+// Commands the firmware registers, in its registration order
+static const char* const firmware_commands[] = {
+    "WIFI", "STATUS", "TIME", "WEATHER", "STOCK", "BALANCE", "CALENDAR", "SET_CALENDAR_URL",
+    "SET_WEATHER_API_KEY", "SET_WEATHER_LOCATION", "GCP_PROJECT", "GCP_EMAIL", "GCP_KEY"};
+#define FIRMWARE_COMMANDS (int)(sizeof(firmware_commands) / sizeof(firmware_commands[0]))
+
+void test_throughput_against_reference(void) {
+  // A boot's worth of config followed by a day of polling, repeated
+  static char transcript[1 << 20];
+  static char key[2048];
+  memset(key, 'K', sizeof(key) - 1);
+  key[sizeof(key) - 1] = '\0';
+  size_t len = 0;
+  int commands = 0;
+  while (len < sizeof(transcript) - 4096) {
+    len += snprintf(transcript + len, sizeof(transcript) - len,
+                    "WIFI:HomeNetwork,hunter2hunter2\r\nGCP_PROJECT:my-project\r\n"
+                    "GCP_EMAIL:svc@my-project.iam.gserviceaccount.com\r\nGCP_KEY:%s\r\n"
+                    "SET_WEATHER_LOCATION:San Francisco,US\r\n",
+                    key);
+    commands += 5;
+    for (int i = 0; i < 20 && len < sizeof(transcript) - 64; i++) {
+      len += snprintf(transcript + len, sizeof(transcript) - len, "STATUS\r\nTIME\r\nWEATHER\r\nCALENDAR:4\r\n");
+      commands += 4;
+    }
+  }
+
+  static STM32Comm rxComm;
+  static CaptureStream link;
+  rxComm.begin(link);
+  reference_count = 0;
+  reference_index = 0;
+  for (int i = 0; i < FIRMWARE_COMMANDS; i++) {
+    rxComm.onCommand(firmware_commands[i], on_bench);
+    strcpy(reference_commands[reference_count].command, firmware_commands[i]);
+    reference_commands[reference_count++].callback = on_bench;
+  }
+
+  // The ESP8266 UART driver hands over what arrived since the last loop()
+  const size_t slice = 256;
+  bench_calls = bench_param_bytes = 0;
+  link.feed(transcript, len, slice);
+  clock_t start = clock();
+  while (link.rxPos < link.rxLength) reference_process(&link);
+  clock_t reference_ticks = clock() - start;
+  unsigned long reference_calls = bench_calls, reference_bytes = bench_param_bytes;
+
+  bench_calls = bench_param_bytes = 0;
+  link.feed(transcript, len, slice);
+  start = clock();
+  while (link.rxPos < link.rxLength) rxComm.process();
+  clock_t ticks = clock() - start;
+
+  TEST_ASSERT_EQUAL_UINT32(commands, bench_calls);
+  TEST_ASSERT_EQUAL_UINT32(reference_calls, bench_calls);
+  TEST_ASSERT_EQUAL_UINT32(reference_bytes, bench_param_bytes);
+
+  double reference_s = (double)reference_ticks / CLOCKS_PER_SEC;
+  double s = (double)ticks / CLOCKS_PER_SEC;
+  if (reference_s <= 0) reference_s = 1e-9;
+  if (s <= 0) s = 1e-9;
+  printf("RX %d commands, %.1f KB: byte-at-a-time %.0f cmd/s %.1f MB/s, bulk %.0f cmd/s %.1f MB/s\n", commands,
+         len / 1024.0, commands / reference_s, len / reference_s / 1e6, commands / s, len / s / 1e6);
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_typed_fields);
+  RUN_TEST(test_send_helpers_use_one_write);
+  RUN_TEST(test_long_replies_are_not_truncated);
+  RUN_TEST(test_overflow_sends_error_instead);
+  RUN_TEST(test_exactly_full_buffer_fits);
+  RUN_TEST(test_resend_built_response);
+  RUN_TEST(test_dispatch_across_chunks);
+  RUN_TEST(test_overlong_line_is_truncated);
+  RUN_TEST(test_command_table);
+  RUN_TEST(test_debug_output_is_deferred_to_process);
+  RUN_TEST(test_drain_respects_available_for_write);
+  RUN_TEST(test_full_log_drops_and_reports);
+  RUN_TEST(test_long_log_lines_are_cut);
+  RUN_TEST(test_throughput_against_reference);
+  return UNITY_END();
+}
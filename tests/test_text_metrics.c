@@ -0,0 +1,89 @@
+#include "unity.h"
+#include <stdio.h>
+#include <string.h>
+#include "text_metrics.h"
+
+static text_metrics_t metrics;
+static text_cache_t cache;
+
+void setUp(void) {
+  // Every glyph 5 wide except 'i' (2) and 'W' (9)
+  memset(metrics.widths, 5, sizeof(metrics.widths));
+  metrics.widths['i' - TEXT_FIRST_CHAR] = 2;
+  metrics.widths['W' - TEXT_FIRST_CHAR] = 9;
+  text_cache_clear(&cache);
+}
+void tearDown(void) {}
+
+void test_width_sums_glyphs(void) {
+  TEST_ASSERT_EQUAL_INT(0, text_width(&metrics, ""));
+  TEST_ASSERT_EQUAL_INT(5 + 2 + 9, text_width(&metrics, "aiW"));
+}
+
+void test_width_rejects_non_ascii(void) {
+  TEST_ASSERT_EQUAL_INT(-1, text_width(&metrics, "Caf\xC3\xA9"));
+  TEST_ASSERT_EQUAL_INT(-1, text_width(&metrics, "tab\there"));
+}
+
+void test_width_of_prefix(void) {
+  TEST_ASSERT_EQUAL_INT(0, text_width_n(&metrics, "aiW", 0));
+  TEST_ASSERT_EQUAL_INT(5 + 2, text_width_n(&metrics, "aiW", 2));
+  TEST_ASSERT_EQUAL_INT(5 + 2 + 9, text_width_n(&metrics, "aiW", 10));
+  // Only the measured bytes have to be in the table
+  TEST_ASSERT_EQUAL_INT(15, text_width_n(&metrics, "Caf\xC3\xA9", 3));
+}
+
+void test_cache_hit_after_store(void) {
+  int width = 0;
+  TEST_ASSERT_FALSE(text_cache_lookup(&cache, 1, "MONTH / DATE", &width));
+  text_cache_store(&cache, 1, "MONTH / DATE", 71);
+  TEST_ASSERT_TRUE(text_cache_lookup(&cache, 1, "MONTH / DATE", &width));
+  TEST_ASSERT_EQUAL_INT(71, width);
+  TEST_ASSERT_EQUAL_UINT32(1, cache.hits);
+  TEST_ASSERT_EQUAL_UINT32(1, cache.misses);
+}
+
+void test_cache_keys_on_font_and_contents(void) {
+  int width;
+  char buffer[8] = "12";
+  text_cache_store(&cache, 0, buffer, 10);
+  TEST_ASSERT_FALSE(text_cache_lookup(&cache, 3, "12", &width));
+
+  // Same buffer, new contents: must not return the old width
+  strcpy(buffer, "13");
+  TEST_ASSERT_FALSE(text_cache_lookup(&cache, 0, buffer, &width));
+}
+
+void test_long_strings_are_not_cached(void) {
+  int width;
+  const char* title = "A rather long calendar event title";
+  text_cache_store(&cache, 0, title, 150);
+  TEST_ASSERT_FALSE(text_cache_lookup(&cache, 0, title, &width));
+}
+
+void test_collisions_replace(void) {
+  // More strings than slots: each lookup is either a hit with the right
+  // width or a miss, never a wrong width
+  char text[8];
+  for (int i = 0; i < 100; i++) {
+    snprintf(text, sizeof(text), "%d", i);
+    text_cache_store(&cache, 0, text, i);
+  }
+  for (int i = 0; i < 100; i++) {
+    int width;
+    snprintf(text, sizeof(text), "%d", i);
+    if (text_cache_lookup(&cache, 0, text, &width)) TEST_ASSERT_EQUAL_INT(i, width);
+  }
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_width_sums_glyphs);
+  RUN_TEST(test_width_rejects_non_ascii);
+  RUN_TEST(test_width_of_prefix);
+  RUN_TEST(test_cache_hit_after_store);
+  RUN_TEST(test_cache_keys_on_font_and_contents);
+  RUN_TEST(test_long_strings_are_not_cached);
+  RUN_TEST(test_collisions_replace);
+  return UNITY_END();
+}
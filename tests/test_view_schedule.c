@@ -0,0 +1,78 @@
+#include "unity.h"
+#include "view_schedule.h"
+
+static view_schedule_t s;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_first_pass_draws(void) {
+  view_schedule_init(&s, 0);
+  TEST_ASSERT_TRUE(view_schedule_due(&s, 0));
+}
+
+void test_static_view_waits_for_invalidate(void) {
+  view_schedule_init(&s, 0);
+  view_schedule_begin_frame(&s, 100);
+  TEST_ASSERT_FALSE(view_schedule_due(&s, 101));
+  TEST_ASSERT_FALSE(view_schedule_due(&s, 1000000));
+  view_schedule_invalidate(&s);
+  TEST_ASSERT_TRUE(view_schedule_due(&s, 1000001));
+  view_schedule_begin_frame(&s, 1000001);
+  TEST_ASSERT_FALSE(view_schedule_due(&s, 1000002));
+}
+
+void test_animation_is_due_after_interval(void) {
+  view_schedule_init(&s, 50);
+  view_schedule_begin_frame(&s, 1000);
+  TEST_ASSERT_FALSE(view_schedule_due(&s, 1049));
+  TEST_ASSERT_TRUE(view_schedule_due(&s, 1050));
+  TEST_ASSERT_TRUE(view_schedule_due(&s, 1200));
+}
+
+void test_invalidate_draws_before_interval(void) {
+  view_schedule_init(&s, 1000);
+  view_schedule_begin_frame(&s, 0);
+  view_schedule_invalidate(&s);
+  TEST_ASSERT_TRUE(view_schedule_due(&s, 10));
+}
+
+void test_wake_in_only_moves_earlier(void) {
+  view_schedule_init(&s, 1000);
+  view_schedule_begin_frame(&s, 0);
+  view_schedule_wake_in(&s, 0, 300);  // Next RTC second in 300 ms
+  TEST_ASSERT_FALSE(view_schedule_due(&s, 299));
+  TEST_ASSERT_TRUE(view_schedule_due(&s, 300));
+
+  view_schedule_begin_frame(&s, 300);
+  view_schedule_wake_in(&s, 300, 5000);
+  TEST_ASSERT_TRUE(view_schedule_due(&s, 1300));
+}
+
+void test_wake_in_wakes_static_view(void) {
+  view_schedule_init(&s, 0);
+  view_schedule_begin_frame(&s, 0);
+  view_schedule_wake_in(&s, 0, 60000);
+  TEST_ASSERT_FALSE(view_schedule_due(&s, 59999));
+  TEST_ASSERT_TRUE(view_schedule_due(&s, 60000));
+}
+
+void test_tick_wrap(void) {
+  view_schedule_init(&s, 50);
+  view_schedule_begin_frame(&s, 0xFFFFFFF0u);
+  TEST_ASSERT_FALSE(view_schedule_due(&s, 0xFFFFFFFFu));
+  TEST_ASSERT_FALSE(view_schedule_due(&s, 0x00000021u));
+  TEST_ASSERT_TRUE(view_schedule_due(&s, 0x00000022u));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_first_pass_draws);
+  RUN_TEST(test_static_view_waits_for_invalidate);
+  RUN_TEST(test_animation_is_due_after_interval);
+  RUN_TEST(test_invalidate_draws_before_interval);
+  RUN_TEST(test_wake_in_only_moves_earlier);
+  RUN_TEST(test_wake_in_wakes_static_view);
+  RUN_TEST(test_tick_wrap);
+  return UNITY_END();
+}
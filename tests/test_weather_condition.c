@@ -0,0 +1,41 @@
+#include "unity.h"
+#include "weather_condition.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_clear_conditions(void) {
+  TEST_ASSERT_EQUAL_INT(PRECIP_NONE, weather_classify("Sunny"));
+  TEST_ASSERT_EQUAL_INT(PRECIP_NONE, weather_classify("Mostly Cloudy"));
+  TEST_ASSERT_EQUAL_INT(PRECIP_NONE, weather_classify(""));
+  TEST_ASSERT_EQUAL_INT(PRECIP_NONE, weather_classify(NULL));
+}
+
+void test_keywords_ignore_case(void) {
+  TEST_ASSERT_EQUAL_INT(PRECIP_RAIN, weather_classify("Light Rain"));
+  TEST_ASSERT_EQUAL_INT(PRECIP_RAIN, weather_classify("chance showers"));
+  TEST_ASSERT_EQUAL_INT(PRECIP_RAIN, weather_classify("THUNDERSTORMS"));
+  TEST_ASSERT_EQUAL_INT(PRECIP_SNOW, weather_classify("Snow Flurries"));
+  TEST_ASSERT_EQUAL_INT(PRECIP_SNOW, weather_classify("blizzard"));
+  TEST_ASSERT_EQUAL_INT(PRECIP_SLEET, weather_classify("Wintry Mix"));
+}
+
+void test_sleet_beats_snow_beats_rain(void) {
+  TEST_ASSERT_EQUAL_INT(PRECIP_SLEET, weather_classify("Freezing Rain"));
+  TEST_ASSERT_EQUAL_INT(PRECIP_SLEET, weather_classify("Rain And Sleet"));
+  TEST_ASSERT_EQUAL_INT(PRECIP_SNOW, weather_classify("Rain And Snow Showers"));
+}
+
+void test_keyword_at_the_end(void) {
+  TEST_ASSERT_EQUAL_INT(PRECIP_RAIN, weather_classify("Chance Rain"));
+  TEST_ASSERT_EQUAL_INT(PRECIP_NONE, weather_classify("Chance Rai"));
+}
+
+int main(void) {
+  UNITY_BEGIN();
+  RUN_TEST(test_clear_conditions);
+  RUN_TEST(test_keywords_ignore_case);
+  RUN_TEST(test_sleet_beats_snow_beats_rain);
+  RUN_TEST(test_keyword_at_the_end);
+  return UNITY_END();
+}
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""Convert a BMP into a packed 1bpp sprite header for fb_blit.
+
+    bmp2sprite.py [--rle] [--name NAME] input.bmp output.h
+
+Pixels are thresholded on luma the way uGFX converts colours for the mono
+panel: light pixels become set (white) bits. Rows are packed MSB first
+and padded to whole bytes, matching fb_sprite_t. With --rle the bits are
+PackBits compressed and the header holds an fb_rle_sprite_t for
+fb_rle_unpack() instead.
+
+Uncompressed BMPs at 1, 4, 8, 16, 24 and 32 bits per pixel are supported,
+and BI_BITFIELDS ones at 16 and 32 with the channel masks they declare.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+
+def read_bmp(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:2] != b"BM":
+        sys.exit(f"{path}: not a BMP file")
+
+    offset, = struct.unpack_from("<I", data, 10)
+    header_size, width, height, planes, bpp, compression = struct.unpack_from("<IiiHHI", data, 14)
+    if compression not in (0, 3) or (compression == 3 and bpp not in (16, 32)):
+        sys.exit(f"{path}: compressed BMPs are not supported")
+    if bpp not in (1, 4, 8, 16, 24, 32):
+        sys.exit(f"{path}: {bpp} bits per pixel is not supported")
+
+    # Red, green and blue masks for 16 and 32 bpp. BI_BITFIELDS stores them
+    # right after the 40-byte info header, which is also where V4 and V5
+    # headers keep them; BI_RGB implies X1R5G5B5 and X8R8G8B8.
+    masks = None
+    if compression == 3:
+        masks = struct.unpack_from("<III", data, 14 + 40)
+        if not all(masks):
+            sys.exit(f"{path}: BI_BITFIELDS with an empty channel mask")
+    elif bpp == 16:
+        masks = (0x7C00, 0x03E0, 0x001F)
+    elif bpp == 32:
+        masks = (0xFF0000, 0x00FF00, 0x0000FF)
+
+    palette = []
+    if bpp <= 8:
+        count, = struct.unpack_from("<I", data, 46)
+        count = count or (1 << bpp)
+        base = 14 + header_size
+        palette = [tuple(data[base + 4 * i:base + 4 * i + 3]) for i in range(count)]  # BGR
+
+    # Rows are stored bottom-up unless the height is negative
+    top_down = height < 0
+    height = abs(height)
+    row_size = (width * bpp + 31) // 32 * 4
+
+    pixels = []
+    for y in range(height):
+        row = offset + (y if top_down else height - 1 - y) * row_size
+        line = []
+        for x in range(width):
+            if masks:
+                value = int.from_bytes(data[row + x * bpp // 8:row + (x + 1) * bpp // 8], "little")
+                r, g, b = (channel(value, mask) for mask in masks)
+            elif bpp == 24:
+                b, g, r = data[row + x * 3:row + x * 3 + 3]
+            else:
+                bit = x * bpp
+                index = (data[row + bit // 8] >> (8 - bpp - bit % 8)) & ((1 << bpp) - 1)
+                b, g, r = palette[index]
+            line.append((r + 2 * g + b) // 4 >= 128)
+        pixels.append(line)
+    return width, height, pixels
+
+
+def channel(value, mask):
+    """Scale the bits of value under mask to 0..255."""
+    shift = (mask & -mask).bit_length() - 1
+    top = mask >> shift
+    return ((value & mask) >> shift) * 255 // top
+
+
+def pack(width, height, pixels):
+    stride = (width + 7) // 8
+    bits = bytearray(stride * height)
+    for y, line in enumerate(pixels):
+        for x, on in enumerate(line):
+            if on:
+                bits[y * stride + x // 8] |= 0x80 >> (x % 8)
+    return stride, bytes(bits)
+
+
+def packbits(data):
+    """PackBits: n < 128 is n+1 literal bytes, n > 128 repeats the next byte 257-n times."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and run < 128 and data[i + run] == data[i]:
+            run += 1
+        if run >= 3:
+            out += bytes([257 - run, data[i]])
+            i += run
+            continue
+        start = i
+        while i < len(data) and i - start < 128:
+            if i + 2 < len(data) and data[i] == data[i + 1] == data[i + 2]:
+                break
+            i += 1
+        out.append(i - start - 1)
+        out += data[start:i]
+    return bytes(out)
+
+
+def c_array(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join(f"0x{b:02X}" for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a BMP into a packed 1bpp sprite header")
+    parser.add_argument("input")
+    parser.add_argument("output")
+    parser.add_argument("--rle", action="store_true", help="PackBits compress the bits")
+    parser.add_argument("--name", help="C identifier prefix (default: the file name)")
+    args = parser.parse_args()
+
+    name = args.name or re.sub(r"\W", "_", os.path.splitext(os.path.basename(args.input))[0])
+    width, height, pixels = read_bmp(args.input)
+    stride, bits = pack(width, height, pixels)
+
+    out = [
+        "// Generated by tools/bmp2sprite.py from " + os.path.basename(args.input) + "; do not edit.",
+        "#pragma once",
+        "",
+        '#include "framebuffer.h"',
+        "",
+    ]
+    if args.rle:
+        data = packbits(bits)
+        out += [
+            f"// {width}x{height}, {len(bits)} bytes packed, {len(data)} compressed",
+            f"static const uint8_t {name}_rle_data[] = {{",
+            c_array(data),
+            "};",
+            f"static const fb_rle_sprite_t {name}_rle = {{{width}, {height}, {stride}, sizeof({name}_rle_data), {name}_rle_data}};",
+        ]
+    else:
+        out += [
+            f"// {width}x{height}, {len(bits)} bytes",
+            f"static const uint8_t {name}_bits[] = {{",
+            c_array(bits),
+            "};",
+            f"static const fb_sprite_t {name}_sprite = {{{width}, {height}, {stride}, {name}_bits}};",
+        ]
+
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "w") as f:
+        f.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()